@@ -1,5 +1,7 @@
 #include "Device.h"
 
+#include <algorithm>
+
 #include <google/protobuf/wrappers.pb.h>
 
 #include "DeviceStorage.h"
@@ -56,6 +58,27 @@ std::vector<std::string> Metadata::GetEntryPaths() const
     return result;
 }
 
+PropertyUpdate& PropertyUpdate::Set(absl::string_view path, nlohmann::json value)
+{
+    auto it = std::find_if(m_values.begin(), m_values.end(),
+        [&](const std::pair<std::string, nlohmann::json>& entry) { return entry.first == path; });
+    if (it != m_values.end())
+    {
+        it->second = std::move(value);
+    }
+    else
+    {
+        m_values.emplace_back(std::string(path), std::move(value));
+    }
+    return *this;
+}
+
+PropertyUpdate& PropertyUpdate::SkipInvalid(bool skip)
+{
+    m_skipInvalid = skip;
+    return *this;
+}
+
 bool Properties::Set(
     absl::string_view path, const nlohmann::json& value, Device& device, DeviceStorage& storage, UserId user)
 {
@@ -82,6 +105,61 @@ bool Properties::Set(
     return false;
 }
 
+std::vector<std::string> Properties::Set(
+    const PropertyUpdate& update, Device& device, DeviceStorage& storage, UserId user)
+{
+    // Validate everything before changing anything, so a rejected update has no effect
+    std::vector<std::pair<const std::pair<std::string, nlohmann::json>*, const MetadataEntry*>> valid;
+    valid.reserve(update.GetSize());
+    for (const std::pair<std::string, nlohmann::json>& value : update.GetValues())
+    {
+        const std::string& path = value.first;
+        if (GetMetadata().HasEntry(path))
+        {
+            const MetadataEntry& meta = GetMetadata().GetEntry(path);
+            if (CheckPermissions(path, meta, user) && Validate(path, meta, value.second, user))
+            {
+                valid.emplace_back(&value, &meta);
+                continue;
+            }
+        }
+        if (!update.SkipsInvalid())
+        {
+            Res::Logger().Debug("Properties", "Rejected update because of property \"" + path + "\"");
+            return {};
+        }
+    }
+
+    std::vector<std::string> changed;
+    std::vector<PropertyWrite> writes;
+    changed.reserve(valid.size());
+    for (const auto& entry : valid)
+    {
+        const std::string& path = entry.first->first;
+        const bool insert = m_values.count(path) == 0;
+        if (insert)
+        {
+            Res::Logger().Debug("Properties", "Creating missing property \"" + path + "\"");
+        }
+        m_values[path] = entry.first->second;
+        const MetadataEntry::DBSave dbSave = entry.second->GetDBSave();
+        if (dbSave != MetadataEntry::DBSave::none)
+        {
+            writes.push_back(PropertyWrite {path, insert, dbSave == MetadataEntry::DBSave::save_log});
+        }
+        changed.push_back(path);
+    }
+    if (!writes.empty())
+    {
+        storage.SetDeviceProperties(device.GetId(), writes, *this, user);
+    }
+    if (!changed.empty())
+    {
+        m_type->OnUpdates(changed, device, user);
+    }
+    return changed;
+}
+
 nlohmann::json Properties::Get(absl::string_view path) const
 {
     if (GetMetadata().HasEntry(path))
@@ -283,6 +361,11 @@ bool Device::SetProperty(absl::string_view path, const nlohmann::json& value, De
     return GetProperties().Set(path, value, *this, storage, user);
 }
 
+bool Device::SetProperties(const PropertyUpdate& update, DeviceStorage& storage, UserId user)
+{
+    return GetProperties().Set(update, *this, storage, user).size() == update.GetSize();
+}
+
 nlohmann::json Device::GetProperty(absl::string_view path) const
 {
     return GetProperties().Get(path);
@@ -151,11 +151,44 @@ private:
     absl::flat_hash_map<std::string, MetadataEntry> m_entries;
 };
 
+// Describes how a changed property is written to the database
+struct PropertyWrite
+{
+    std::string key;
+    // The property did not exist before and has to be inserted
+    bool insert;
+    // The value is also added to the property log
+    bool log;
+};
+
+// Collects multiple property values which are set together with Device::SetProperties
+class PropertyUpdate
+{
+public:
+    // Setting the same path twice keeps the last value
+    PropertyUpdate& Set(absl::string_view path, nlohmann::json value);
+    // Skip values which fail validation instead of rejecting the whole update
+    PropertyUpdate& SkipInvalid(bool skip = true);
+
+    bool IsEmpty() const { return m_values.empty(); }
+    std::size_t GetSize() const { return m_values.size(); }
+    bool SkipsInvalid() const { return m_skipInvalid; }
+    const std::vector<std::pair<std::string, nlohmann::json>>& GetValues() const { return m_values; }
+
+private:
+    std::vector<std::pair<std::string, nlohmann::json>> m_values;
+    bool m_skipInvalid = false;
+};
+
 class Properties
 {
 public:
     bool Set(absl::string_view path, const nlohmann::json& value, class Device& device, class DeviceStorage& storage,
         UserId user);
+    // Validates all values first and sets them with one database transaction and one change event.
+    // Returns the paths which were set, none if a value is invalid and the update does not skip invalid values
+    std::vector<std::string> Set(
+        const PropertyUpdate& update, class Device& device, class DeviceStorage& storage, UserId user);
     nlohmann::json Get(absl::string_view path) const;
     nlohmann::json GetHistory(DeviceId deviceId, absl::string_view path,
         const std::chrono::system_clock::time_point& start,
@@ -227,6 +260,8 @@ public:
     Properties& GetProperties();
     const Properties& GetProperties() const;
     bool SetProperty(absl::string_view path, const nlohmann::json& value, class DeviceStorage& storage, UserId user);
+    // Sets multiple properties at once, returns true if all of them were set
+    bool SetProperties(const PropertyUpdate& update, class DeviceStorage& storage, UserId user);
     nlohmann::json GetProperty(absl::string_view path) const;
     nlohmann::json GetPropertyHistory(absl::string_view path, const std::chrono::system_clock::time_point& start,
         absl::optional<const std::chrono::system_clock::time_point> end, std::time_t compression,
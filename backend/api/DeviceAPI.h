@@ -16,15 +16,25 @@ public:
     // Should not be used for work, use Shutdown() instead
     virtual ~IDeviceAPI() = default;
 
-    // Used to initialize and read config, called before RegisterXXX() and Start()
+    // Used to initialize and read config, called before RegisterXXX() and Start(). Should not block on network
+    // requests, apis are initialized one after another
     virtual void Initialize(nlohmann::json& config) = 0;
 
-    // Used to start threads, called after Initialize() and RegisterXXX() of all loaded APIs
+    // Used for network bound initialization like device discovery, called after RegisterXXX() and before
+    // SynchronizeDevices(). Runs concurrently with the other apis, changes to config are saved afterwards
+    virtual void Connect(nlohmann::json& /*config*/) {}
+
+    // Used to start threads, called after SynchronizeDevices() and RegisterXXX() of all loaded APIs
     virtual void Start() {}
 
     // Used to stop threads, called last (only if Start() was successful)
     virtual void Shutdown() {}
 
+    // Called instead of Start() if Connect() or SynchronizeDevices() failed or did not finish in time, may run
+    // concurrently with them. Event handlers and subscriptions should remove themselves, the storage passed to
+    // SynchronizeDevices() throws from now on
+    virtual void Cancel() {}
+
     // Called after Initialize(), RegisterRuleConditions() and RegisterSubActinons() and before Start()
     virtual void RegisterEventHandlers(EventSystem& /*evSys*/) {}
 
@@ -36,8 +46,8 @@ public:
 
     // Register different device types (not used currently)
     virtual void RegisterDeviceTypes(DeviceTypeRegistry& /*registry*/) {}
-    // Add/Remove/Change devices at beginning when external changes happened
-    // storage only contains devices of this plugin
+    // Add/Remove/Change devices at beginning when external changes happened, called after Connect()
+    // storage only contains devices of this plugin, runs concurrently with the other apis
     virtual void SynchronizeDevices(DeviceStorage& /*storage*/) {}
 
     virtual const char* GetAPIId() const noexcept = 0;
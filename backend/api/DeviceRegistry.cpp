@@ -15,6 +15,18 @@ DeviceRegistry::DeviceRegistry(IDeviceSerialize& deviceSer, EventEmitter<Events:
     : m_storage(deviceSer, eventEmitter, propertyChanges)
 {}
 
+DeviceRegistry::~DeviceRegistry()
+{
+    for (auto& connection : m_connections)
+    {
+        connection->m_thread.join();
+    }
+    for (auto& connection : m_timedOut)
+    {
+        connection->m_thread.join();
+    }
+}
+
 void DeviceRegistry::RegisterDeviceAPI(std::unique_ptr<IDeviceAPI>&& api)
 {
     m_registered.push_back(std::move(api));
@@ -68,52 +80,102 @@ IDeviceAPI& DeviceRegistry::GetAPI(const std::string& apiId)
 }
 
 void DeviceRegistry::InitAPIs(const std::string& configDir, EventSystem& evSys, RuleConditions::Registry& condReg,
-    SubActionRegistry& subActReg, DeviceTypeRegistry& typeReg)
+    SubActionRegistry& subActReg, DeviceTypeRegistry& typeReg, std::chrono::milliseconds connectTimeout)
 {
     auto& log = Res::Logger();
     log.Info(CLASSNAME, "Initializing " + std::to_string(m_registered.size()) + " device apis");
 
+    m_configDir = configDir;
+    // Registration is done in order, so the registries do not depend on which api connects first
     for (auto it = m_registered.begin(); it != m_registered.end();)
     {
-        nlohmann::json config = GetAPIConfig(configDir, (*it)->GetAPIId());
+        auto connection = std::make_unique<Connection>();
+        connection->m_api = it->get();
+        connection->m_cancelled = std::make_shared<std::atomic<bool>>(false);
+        connection->m_config = GetAPIConfig(configDir, (*it)->GetAPIId());
         try
         {
-            (*it)->Initialize(config);
+            (*it)->Initialize(connection->m_config);
             (*it)->RegisterDeviceTypes(typeReg);
             (*it)->RegisterRuleConditions(condReg);
             (*it)->RegisterSubActions(subActReg);
             (*it)->RegisterEventHandlers(evSys);
-            (*it)->SynchronizeDevices(m_storage);
         }
         catch (const std::exception& e)
         {
             log.Error(CLASSNAME, std::string("Failed to initialize api ") + (*it)->GetAPIId());
             log.Debug(CLASSNAME, std::string("Reason:") + e.what());
-            SaveAPIConfig(configDir, (*it)->GetAPIId(), config);
+            SaveAPIConfig(configDir, (*it)->GetAPIId(), connection->m_config);
+            // Device types or handlers may already be registered
+            m_failed.push_back(std::move(*it));
             it = m_registered.erase(it);
             continue;
         }
-        log.Info(CLASSNAME, std::string("Initialized api ") + (*it)->GetAPIId());
-        SaveAPIConfig(configDir, (*it)->GetAPIId(), config);
+        m_apiStorages.push_back(std::make_unique<DeviceStorage>(m_storage, connection->m_cancelled));
+        connection->m_storage = m_apiStorages.back().get();
+        m_connections.push_back(std::move(connection));
         ++it;
     }
+
+    m_connectDeadline = std::chrono::steady_clock::now() + connectTimeout;
+    for (auto& connection : m_connections)
+    {
+        Connection* c = connection.get();
+        c->m_thread = std::thread([this, c] {
+            std::exception_ptr error;
+            try
+            {
+                c->m_api->Connect(c->m_config);
+                c->m_api->SynchronizeDevices(*c->m_storage);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(m_connectMutex);
+            c->m_done = true;
+            c->m_error = error;
+            m_connectCv.notify_all();
+        });
+    }
+}
+
+bool DeviceRegistry::Start(const std::string& apiId)
+{
+    auto pos = std::find_if(m_connections.begin(), m_connections.end(),
+        [&](const std::unique_ptr<Connection>& c) { return c->m_api->GetAPIId() == apiId; });
+    if (pos == m_connections.end())
+    {
+        return false;
+    }
+    std::unique_ptr<Connection> connection = std::move(*pos);
+    m_connections.erase(pos);
+    {
+        std::unique_lock<std::mutex> lock(m_connectMutex);
+        m_connectCv.wait_until(lock, m_connectDeadline, [&] { return connection->m_done; });
+    }
+    return FinishConnection(std::move(connection));
 }
 
 void DeviceRegistry::Start()
 {
-    for (auto it = m_registered.begin(); it != m_registered.end();)
+    std::unique_lock<std::mutex> lock(m_connectMutex);
+    auto isDone = [](const std::unique_ptr<Connection>& c) { return c->m_done; };
+    while (!m_connections.empty())
     {
-        try
-        {
-            (*it)->Start();
-        }
-        catch (const std::exception&)
+        // Apis are started in the order they finish, so a slow api does not delay the others
+        m_connectCv.wait_until(
+            lock, m_connectDeadline, [&] { return std::any_of(m_connections.begin(), m_connections.end(), isDone); });
+        auto pos = std::find_if(m_connections.begin(), m_connections.end(), isDone);
+        if (pos == m_connections.end())
         {
-            Res::Logger().Error(CLASSNAME, std::string("Failed to start api ") + (*it)->GetAPIId());
-            it = m_registered.erase(it);
-            continue;
+            pos = m_connections.begin();
         }
-        ++it;
+        std::unique_ptr<Connection> connection = std::move(*pos);
+        m_connections.erase(pos);
+        lock.unlock();
+        FinishConnection(std::move(connection));
+        lock.lock();
     }
 }
 
@@ -132,6 +194,81 @@ void DeviceRegistry::Shutdown()
     }
 }
 
+bool DeviceRegistry::FinishConnection(std::unique_ptr<Connection>&& connection)
+{
+    auto& log = Res::Logger();
+    IDeviceAPI* api = connection->m_api;
+    bool done;
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_connectMutex);
+        done = connection->m_done;
+        error = connection->m_error;
+    }
+    if (!done)
+    {
+        // The thread cannot be interrupted, but it cannot use the storage anymore. It is joined on destruction
+        log.Error(CLASSNAME, std::string("Timeout while initializing api ") + api->GetAPIId());
+        CancelConnection(*connection);
+        RemoveFailedAPI(api);
+        m_timedOut.push_back(std::move(connection));
+        return false;
+    }
+    connection->m_thread.join();
+    SaveAPIConfig(m_configDir, api->GetAPIId(), connection->m_config);
+    try
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log.Error(CLASSNAME, std::string("Failed to initialize api ") + api->GetAPIId());
+        log.Debug(CLASSNAME, std::string("Reason:") + e.what());
+        CancelConnection(*connection);
+        RemoveFailedAPI(api);
+        return false;
+    }
+    log.Info(CLASSNAME, std::string("Initialized api ") + api->GetAPIId());
+    try
+    {
+        api->Start();
+    }
+    catch (const std::exception&)
+    {
+        log.Error(CLASSNAME, std::string("Failed to start api ") + api->GetAPIId());
+        RemoveFailedAPI(api);
+        return false;
+    }
+    return true;
+}
+
+void DeviceRegistry::CancelConnection(Connection& connection)
+{
+    *connection.m_cancelled = true;
+    try
+    {
+        connection.m_api->Cancel();
+    }
+    catch (const std::exception&)
+    {
+        Res::Logger().Error(CLASSNAME, std::string("Failed to cancel api ") + connection.m_api->GetAPIId());
+    }
+}
+
+void DeviceRegistry::RemoveFailedAPI(const IDeviceAPI* api)
+{
+    auto pos = std::find_if(m_registered.begin(), m_registered.end(),
+        [&](const std::unique_ptr<IDeviceAPI>& a) { return a.get() == api; });
+    if (pos != m_registered.end())
+    {
+        m_failed.push_back(std::move(*pos));
+        m_registered.erase(pos);
+    }
+}
+
 nlohmann::json GetAPIConfig(const std::string& configDir, const char* apiName)
 {
     std::ifstream stream(configDir + "/" + apiName + "_config.json");
@@ -1,5 +1,12 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <json.hpp>
@@ -19,6 +26,8 @@ class DeviceRegistry
 public:
     DeviceRegistry(class IDeviceSerialize& deviceSer, EventEmitter<Events::DeviceChangeEvent>& eventEmitter,
         EventEmitter<Events::DevicePropertyChangeEvent>& propertyEvents);
+    // Waits for apis which are still connecting
+    ~DeviceRegistry();
     // Register API
     void RegisterDeviceAPI(std::unique_ptr<IDeviceAPI>&& api);
     // Remove API with given id
@@ -35,18 +44,56 @@ public:
     const class IDeviceAPI& GetAPI(const std::string& apiId) const;
     // Returns mutable api with given id
     class IDeviceAPI& GetAPI(const std::string& apiId);
-    // Calls Initialize() and RegisterXXX() on each api, must be called before Start(). Removes api without calling
-    // Shutdown() on error
+    // Calls Initialize() and RegisterXXX() on each api in order, must be called before Start(). Then calls Connect()
+    // and SynchronizeDevices() of all apis concurrently on separate threads. Removes api without calling Shutdown()
+    // on error
     void InitAPIs(const std::string& configDir, class EventSystem& evSys, RuleConditions::Registry& condReg,
-        class SubActionRegistry& subActReg, class DeviceTypeRegistry& typeReg);
-    // Calls Start() on each api, must be called after Initialize(). Removes api without calling Shutdown() on error
+        class SubActionRegistry& subActReg, class DeviceTypeRegistry& typeReg,
+        std::chrono::milliseconds connectTimeout = std::chrono::seconds(30));
+    // Waits until api with given id is connected and calls Start() on it. Returns false and removes api without
+    // calling Shutdown() on error or timeout, a failed connection is cancelled
+    bool Start(const std::string& apiId);
+    // Calls Start() on each remaining api as soon as it is connected. Returns when all apis are started or removed,
+    // removes api without calling Shutdown() on error or timeout, a failed connection is cancelled
     void Start();
     // Calls Shutdown() on each api, does NOT remove api on error
     void Shutdown();
 
 private:
+    struct Connection
+    {
+        IDeviceAPI* m_api;
+        nlohmann::json m_config;
+        // Storage passed to SynchronizeDevices(), cancelled if the api fails to connect
+        DeviceStorage* m_storage;
+        std::shared_ptr<std::atomic<bool>> m_cancelled;
+        std::thread m_thread;
+        // Guarded by m_connectMutex
+        bool m_done = false;
+        std::exception_ptr m_error;
+    };
+
+    // Starts api of the connection or removes it on error or timeout, returns whether the api was started
+    bool FinishConnection(std::unique_ptr<Connection>&& connection);
+    // Cancels the storage and the api of a connection which failed or timed out
+    void CancelConnection(Connection& connection);
+    // Moves api to m_failed, its device types and handlers may still refer to it
+    void RemoveFailedAPI(const IDeviceAPI* api);
+
+private:
+    // Storages of the apis, declared first because apis keep references to them
+    std::vector<std::unique_ptr<DeviceStorage>> m_apiStorages;
     std::vector<std::unique_ptr<IDeviceAPI>> m_registered;
+    // Apis which failed after registration, kept alive until destruction
+    std::vector<std::unique_ptr<IDeviceAPI>> m_failed;
     DeviceStorage m_storage;
+    std::string m_configDir;
+    std::chrono::steady_clock::time_point m_connectDeadline;
+    std::vector<std::unique_ptr<Connection>> m_connections;
+    // Connections which timed out, joined on destruction
+    std::vector<std::unique_ptr<Connection>> m_timedOut;
+    std::mutex m_connectMutex;
+    std::condition_variable m_connectCv;
     static constexpr const char* const CLASSNAME = "DeviceRegistry";
 };
 
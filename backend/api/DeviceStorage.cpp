@@ -4,21 +4,40 @@
 
 DeviceStorage::DeviceStorage(IDeviceSerialize& deviceSer, EventEmitter<Events::DeviceChangeEvent>& eventEmitter,
     EventEmitter<Events::DevicePropertyChangeEvent>& propertyEvents)
-    : m_serialize(&deviceSer), m_eventEmitter(&eventEmitter), m_propertyEvents(&propertyEvents)
+    : m_cache(std::make_shared<Cache>()),
+      m_serialize(&deviceSer),
+      m_eventEmitter(&eventEmitter),
+      m_propertyEvents(&propertyEvents)
+{}
+
+DeviceStorage::DeviceStorage(const DeviceStorage& storage, std::shared_ptr<const std::atomic<bool>> cancelled)
+    : m_cache(storage.m_cache),
+      m_cancelled(std::move(cancelled)),
+      m_serialize(storage.m_serialize),
+      m_eventEmitter(storage.m_eventEmitter),
+      m_propertyEvents(storage.m_propertyEvents)
 {}
 
 DeviceId DeviceStorage::AddDevice(const Device& d, UserId u)
 {
+    CheckCancelled();
     DeviceId id = m_serialize->AddDevice(*d.m_data, u);
-    m_cache.insert_or_assign(id, d.m_data);
+    {
+        std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+        m_cache->m_devices.insert_or_assign(id, d.m_data);
+    }
     m_eventEmitter->EmitEvent(Events::DeviceChangeEvent(Device(), d, Events::DeviceFields::ADD, u));
     return id;
 }
 
 void DeviceStorage::RemoveDevice(DeviceId id, UserId u)
 {
+    CheckCancelled();
     absl::optional<Device> d = GetDevice(id, u);
-    m_cache.erase(id);
+    {
+        std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+        m_cache->m_devices.erase(id);
+    }
     m_serialize->RemoveDevice(id, u);
     if (d)
     {
@@ -26,119 +45,142 @@ void DeviceStorage::RemoveDevice(DeviceId id, UserId u)
     }
 }
 
-void DeviceStorage::ChangeDevice(const Device& d, UserId u)
+void DeviceStorage::ChangeDevice(const Device& d, UserId u, Events::DeviceFields fields)
 {
+    CheckCancelled();
     // TODO: Find other way to specify old value, this does not work
     absl::optional<Device> old = GetDevice(d.GetId(), u);
-    m_serialize->UpdateDevice(d.GetId(), *d.m_data, u);
-    m_cache.insert_or_assign(d.GetId(), d.m_data);
+    m_serialize->UpdateDevice(d.GetId(), *d.m_data, fields, u);
+    {
+        std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+        m_cache->m_devices.insert_or_assign(d.GetId(), d.m_data);
+    }
     if (old)
     {
-        m_eventEmitter->EmitEvent(Events::DeviceChangeEvent(*old, d, Events::DeviceFields::ALL, u));
+        m_eventEmitter->EmitEvent(Events::DeviceChangeEvent(*old, d, fields, u));
     }
     else
     {
-        m_eventEmitter->EmitEvent(Events::DeviceChangeEvent(Device(), d, Events::DeviceFields::ALL, u));
+        m_eventEmitter->EmitEvent(Events::DeviceChangeEvent(Device(), d, fields, u));
     }
 }
 
 absl::optional<Device> DeviceStorage::GetDevice(DeviceId id, UserId u)
 {
-    auto it = m_cache.find(id);
-    if (it != m_cache.end())
+    CheckCancelled();
     {
-        if (std::shared_ptr<Device::Data> dataPtr = it->second.lock())
+        std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+        auto it = m_cache->m_devices.find(id);
+        if (it != m_cache->m_devices.end())
         {
-            return Device(id, dataPtr);
+            if (std::shared_ptr<Device::Data> dataPtr = it->second.lock())
+            {
+                return Device(id, dataPtr);
+            }
         }
     }
+    // Not locked while loading, the device may have been cached by another thread in the meantime
     auto deviceData = m_serialize->GetDeviceData(id, u);
     if (deviceData)
     {
-        auto dataPtr = std::make_shared<Device::Data>(*deviceData);
-        m_cache.insert_or_assign(id, dataPtr);
-        return Device(id, dataPtr);
+        std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+        std::weak_ptr<Device::Data>& cached = m_cache->m_devices[id];
+        std::shared_ptr<Device::Data> dataPtr = cached.lock();
+        if (!dataPtr)
+        {
+            dataPtr = std::make_shared<Device::Data>(std::move(*deviceData));
+            cached = dataPtr;
+        }
+        return Device(id, std::move(dataPtr));
     }
     return absl::nullopt;
 }
 
 std::vector<Device> DeviceStorage::GetApiDevices(absl::string_view apiId, UserId u)
 {
-    std::vector<DeviceId> deviceIds = m_serialize->GetAPIDeviceIds(apiId, u);
-    std::vector<Device> result;
-    result.reserve(deviceIds.size());
-    for (DeviceId id : deviceIds)
-    {
-        absl::optional<Device> device = GetDevice(id, u);
-        if (device)
-        {
-            result.emplace_back(std::move(device).value());
-        }
-    }
-    return result;
+    CheckCancelled();
+    return CacheDevices(m_serialize->GetAPIDevices(apiId, u));
 }
 
 std::vector<Device> DeviceStorage::GetAllDevices(UserId u)
 {
-    std::vector<DeviceId> deviceIds = m_serialize->GetAllDeviceIds(Filter(), u);
-    std::vector<Device> result;
-    result.reserve(deviceIds.size());
-    for (DeviceId id : deviceIds)
-    {
-        absl::optional<Device> device = GetDevice(id, u);
-        if (device)
-        {
-            result.emplace_back(std::move(device).value());
-        }
-    }
-    return result;
+    CheckCancelled();
+    return GetAllDevices(Filter(), u);
+}
+
+std::vector<Device> DeviceStorage::GetAllDevices(const Filter& filter, UserId u)
+{
+    CheckCancelled();
+    return CacheDevices(m_serialize->GetAllDevices(filter, u));
 }
 
 void DeviceStorage::SetDeviceProperty(DeviceId id, absl::string_view path, const Properties& properties, UserId user)
 {
+    CheckCancelled();
     absl::optional<Device> device = GetDevice(id, user);
     if (device)
     {
         m_serialize->SetDeviceProperty(id, path, properties, user);
         // TODO: Find other way to specify old value, this does not work
-        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, std::string(path), user));
+        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, {std::string(path)}, user));
     }
 }
 
 void DeviceStorage::SetAndLogDeviceProperty(
     DeviceId id, absl::string_view path, const Properties& properties, UserId user)
 {
+    CheckCancelled();
     absl::optional<Device> device = GetDevice(id, user);
     if (device)
     {
         m_serialize->SetDeviceProperty(id, path, properties, user);
         m_serialize->LogDeviceProperty(id, path, properties, user);
         // TODO: Find other way to specify old value, this does not work
-        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, std::string(path), user));
+        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, {std::string(path)}, user));
     }
 }
 
 void DeviceStorage::InsertDeviceProperty(DeviceId id, absl::string_view path, const Properties& properties, UserId user)
 {
+    CheckCancelled();
     absl::optional<Device> device = GetDevice(id, user);
     if (device)
     {
         m_serialize->InsertDeviceProperty(id, path, properties, user);
         // TODO: Find other way to specify old value, this does not work
-        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, std::string(path), user));
+        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, {std::string(path)}, user));
     }
 }
 
 void DeviceStorage::InsertAndLogDeviceProperty(
     DeviceId id, absl::string_view path, const Properties& properties, UserId user)
 {
+    CheckCancelled();
     absl::optional<Device> device = GetDevice(id, user);
     if (device)
     {
         m_serialize->InsertDeviceProperty(id, path, properties, user);
         m_serialize->LogDeviceProperty(id, path, properties, user);
         // TODO: Find other way to specify old value, this does not work
-        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, std::string(path), user));
+        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, {std::string(path)}, user));
+    }
+}
+
+void DeviceStorage::SetDeviceProperties(
+    DeviceId id, const std::vector<PropertyWrite>& writes, const Properties& properties, UserId user)
+{
+    CheckCancelled();
+    absl::optional<Device> device = GetDevice(id, user);
+    if (device)
+    {
+        m_serialize->SetDeviceProperties(id, writes, properties, user);
+        std::vector<std::string> keys;
+        keys.reserve(writes.size());
+        for (const PropertyWrite& write : writes)
+        {
+            keys.push_back(write.key);
+        }
+        m_propertyEvents->EmitEvent(Events::DevicePropertyChangeEvent(*device, *device, std::move(keys), user));
     }
 }
 
@@ -146,6 +188,7 @@ nlohmann::json DeviceStorage::GetPropertyHistory(DeviceId id, absl::string_view
     const std::chrono::system_clock::time_point& start, absl::optional<const std::chrono::system_clock::time_point> end,
     std::time_t compression, const Properties& properties, UserId user)
 {
+    CheckCancelled();
     absl::optional<Device> device = GetDevice(id, user);
     if (device)
     {
@@ -157,17 +200,46 @@ nlohmann::json DeviceStorage::GetPropertyHistory(DeviceId id, absl::string_view
     }
 }
 
+std::vector<Device> DeviceStorage::CacheDevices(std::vector<std::pair<DeviceId, Device::Data>>&& loaded)
+{
+    std::vector<Device> result;
+    result.reserve(loaded.size());
+    std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+    for (auto& device : loaded)
+    {
+        // Devices which are still in use keep their data, so all copies see the same changes
+        std::weak_ptr<Device::Data>& cached = m_cache->m_devices[device.first];
+        std::shared_ptr<Device::Data> dataPtr = cached.lock();
+        if (!dataPtr)
+        {
+            dataPtr = std::make_shared<Device::Data>(std::move(device.second));
+            cached = dataPtr;
+        }
+        result.push_back(Device(device.first, std::move(dataPtr)));
+    }
+    return result;
+}
+
 void DeviceStorage::CleanupCache()
 {
-    for (auto it = m_cache.begin(), end = m_cache.end(); it != end;)
+    std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+    for (auto it = m_cache->m_devices.begin(), end = m_cache->m_devices.end(); it != end;)
     {
         if (it->second.expired())
         {
-            m_cache.erase(it++);
+            m_cache->m_devices.erase(it++);
         }
         else
         {
             ++it;
         }
     }
+}
+
+void DeviceStorage::CheckCancelled() const
+{
+    if (m_cancelled != nullptr && *m_cancelled)
+    {
+        throw std::runtime_error("DeviceStorage: Api was cancelled");
+    }
 }
\ No newline at end of file
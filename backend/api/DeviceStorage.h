@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "Device.h"
+#include "Filter.h"
 
 #include "../events/Events.h"
 
@@ -10,19 +15,28 @@ public:
     // apiId must refer to static storage
     DeviceStorage(class IDeviceSerialize& deviceSer, EventEmitter<Events::DeviceChangeEvent>& eventEmitter,
         EventEmitter<Events::DevicePropertyChangeEvent>& propertyEvents);
+    // Storage for a single api which shares the cache of storage. Every call except CleanupCache() throws once
+    // cancelled is set
+    DeviceStorage(const DeviceStorage& storage, std::shared_ptr<const std::atomic<bool>> cancelled);
     // Adds device as new, ignores id
     DeviceId AddDevice(const Device& d, UserId u);
     void RemoveDevice(DeviceId id, UserId u);
-    // Changes existing device with same id
-    void ChangeDevice(const Device& d, UserId u);
+    // Changes existing device with same id, fields tells which parts of the device changed
+    void ChangeDevice(const Device& d, UserId u, Events::DeviceFields fields = Events::DeviceFields::ALL);
     absl::optional<Device> GetDevice(DeviceId id, UserId u);
+    // Load all devices with a constant number of queries, cached devices keep their data
     std::vector<Device> GetApiDevices(absl::string_view apiId, UserId u);
     std::vector<Device> GetAllDevices(UserId u);
+    // Returns devices matching filter, ordered by id
+    std::vector<Device> GetAllDevices(const Filter& filter, UserId u);
 
     void SetDeviceProperty(DeviceId id, absl::string_view path, const Properties& properties, UserId user);
     void SetAndLogDeviceProperty(DeviceId id, absl::string_view path, const Properties& properties, UserId user);
     void InsertDeviceProperty(DeviceId id, absl::string_view path, const Properties& properties, UserId user);
     void InsertAndLogDeviceProperty(DeviceId id, absl::string_view path, const Properties& properties, UserId user);
+    // Writes all properties in one transaction and emits one event with all keys
+    void SetDeviceProperties(
+        DeviceId id, const std::vector<PropertyWrite>& writes, const Properties& properties, UserId user);
     nlohmann::json GetPropertyHistory(DeviceId id, absl::string_view path,
         const std::chrono::system_clock::time_point& start,
         absl::optional<const std::chrono::system_clock::time_point> end, std::time_t compression,
@@ -32,7 +46,24 @@ public:
     void CleanupCache();
 
 private:
-    absl::flat_hash_map<DeviceId, std::weak_ptr<Device::Data>> m_cache;
+    // Returns devices for the loaded data, uses the cached data of devices which are still in use
+    std::vector<Device> CacheDevices(std::vector<std::pair<DeviceId, Device::Data>>&& loaded);
+    // Throws if the storage was cancelled
+    void CheckCancelled() const;
+
+private:
+    struct Cache
+    {
+        // Apis synchronize their devices concurrently
+        std::mutex m_mutex;
+        absl::flat_hash_map<DeviceId, std::weak_ptr<Device::Data>> m_devices;
+    };
+
+private:
+    // Shared with the storages of the apis
+    std::shared_ptr<Cache> m_cache;
+    // nullptr if the storage cannot be cancelled
+    std::shared_ptr<const std::atomic<bool>> m_cancelled;
     class IDeviceSerialize* m_serialize;
     EventEmitter<Events::DeviceChangeEvent>* m_eventEmitter;
     EventEmitter<Events::DevicePropertyChangeEvent>* m_propertyEvents;
@@ -21,6 +21,14 @@ public:
     virtual bool ValidateUpdate(absl::string_view property, const nlohmann::json& value, UserId user) const = 0;
     // Called on update, should notify underlying API of the changes
     virtual void OnUpdate(absl::string_view property, Device& device, UserId user) const = 0;
+    // Called once when multiple properties were updated together, calls OnUpdate for each property by default
+    virtual void OnUpdates(const std::vector<std::string>& properties, Device& device, UserId user) const
+    {
+        for (const std::string& property : properties)
+        {
+            OnUpdate(property, device, user);
+        }
+    }
 };
 
 class DeviceTypeRegistry
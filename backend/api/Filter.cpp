@@ -1,16 +1,69 @@
 #include "Filter.h"
 
+#include <limits>
+#include <stdexcept>
+
+constexpr char Filter::s_likeEscape;
+
+Filter::Filter(std::string searchString, int startIndex, int maxLength, std::string group)
+    : m_searchString(std::move(searchString)),
+      m_startIndex(startIndex),
+      m_maxLength(maxLength),
+      m_group(std::move(group))
+{
+    if (startIndex < 0 || maxLength < 0)
+    {
+        throw std::invalid_argument("Filter: start index and max length must not be negative");
+    }
+}
+
+Filter Filter::FromJson(const nlohmann::json& json)
+{
+    return Filter(json.value("search", std::string()), json.value("start", 0), json.value("max", 0),
+        json.value("group", std::string()));
+}
+
 std::string Filter::getSearchString() const
 {
-    return std::string();
+    return m_searchString;
+}
+
+std::string Filter::getSearchPattern() const
+{
+    std::string pattern = "%";
+    pattern.reserve(m_searchString.size() + 2);
+    for (char c : m_searchString)
+    {
+        if (c == '%' || c == '_' || c == s_likeEscape)
+        {
+            pattern += s_likeEscape;
+        }
+        pattern += c;
+    }
+    pattern += '%';
+    return pattern;
 }
 
 int Filter::getStartIndex() const
 {
-    return 0;
+    return m_startIndex;
 }
 
 int Filter::getMaxLength() const
 {
-    return 0;
+    return m_maxLength;
+}
+
+std::string Filter::getGroup() const
+{
+    return m_group;
+}
+
+uint64_t Filter::getQueryLimit() const
+{
+    if (m_maxLength > 0)
+    {
+        return static_cast<uint64_t>(m_maxLength);
+    }
+    return static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
 }
@@ -1,14 +1,44 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include <json.hpp>
+
 #include "../database/DBHandler.h"
 
+// Restricts the results of queries returning multiple elements
 class Filter
 {
 public:
+    // Unrestricted filter
+    Filter() = default;
+    Filter(std::string searchString, int startIndex, int maxLength, std::string group = "");
+
+    // Parses "search", "start", "max" and "group" from a request, missing values are unrestricted
+    static Filter FromJson(const nlohmann::json& json);
+
+    // Only elements whose name contains this string are returned, empty matches all
     std::string getSearchString() const;
+    // LIKE pattern matching names which contain the search string, '%', '_' and the escape character are escaped
+    std::string getSearchPattern() const;
+    // Number of elements which are skipped
     int getStartIndex() const;
+    // Maximum number of elements returned, 0 is unlimited
     int getMaxLength() const;
+    // Only elements in this group are returned, empty matches all. Ignored for elements without groups
+    std::string getGroup() const;
+    // Value for a LIMIT clause, because sqlite does not allow OFFSET without LIMIT
+    uint64_t getQueryLimit() const;
+
+public:
+    // Escape character of getSearchPattern()
+    static constexpr char s_likeEscape = '\\';
+
+private:
+    std::string m_searchString;
+    int m_startIndex = 0;
+    int m_maxLength = 0;
+    std::string m_group;
 };
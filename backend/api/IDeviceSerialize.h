@@ -1,11 +1,14 @@
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "Device.h"
 #include "Filter.h"
 #include "User.h"
 
+#include "../events/Events.h"
+
 // Just a tag type to ensure a transaction persists
 class UserHeldTransaction;
 
@@ -20,14 +23,26 @@ public:
     // Adds a device, returns the id
     virtual DeviceId AddDevice(const Device::Data& deviceData, UserId user) = 0;
     virtual DeviceId AddDevice(const Device::Data& deviceData, const UserHeldTransaction&) = 0;
-    // Updates an existing device
-    virtual void UpdateDevice(DeviceId id, const Device::Data& data, UserId user) = 0;
-    virtual void UpdateDevice(DeviceId id, const Device::Data& data, const UserHeldTransaction&) = 0;
+    // Updates the fields of an existing device, ALL also includes the properties
+    virtual void UpdateDevice(DeviceId id, const Device::Data& data, Events::DeviceFields fields, UserId user) = 0;
+    virtual void UpdateDevice(
+        DeviceId id, const Device::Data& data, Events::DeviceFields fields, const UserHeldTransaction&)
+        = 0;
 
     virtual std::vector<DeviceId> GetAPIDeviceIds(absl::string_view apiId, UserId user) const = 0;
     virtual std::vector<DeviceId> GetAPIDeviceIds(absl::string_view apiId, const UserHeldTransaction&) const = 0;
     virtual std::vector<DeviceId> GetAllDeviceIds(const Filter& filter, UserId user) const = 0;
     virtual std::vector<DeviceId> GetAllDeviceIds(const Filter& filter, const UserHeldTransaction&) const = 0;
+    // Returns the data of all devices of the api with known types, ordered by id.
+    // Loads devices, groups and properties in a constant number of queries
+    virtual std::vector<std::pair<DeviceId, Device::Data>> GetAPIDevices(
+        absl::string_view apiId, UserId user) const = 0;
+    virtual std::vector<std::pair<DeviceId, Device::Data>> GetAPIDevices(
+        absl::string_view apiId, const UserHeldTransaction&) const = 0;
+    // Returns the data of all devices matching filter with known types, ordered by id
+    virtual std::vector<std::pair<DeviceId, Device::Data>> GetAllDevices(const Filter& filter, UserId user) const = 0;
+    virtual std::vector<std::pair<DeviceId, Device::Data>> GetAllDevices(
+        const Filter& filter, const UserHeldTransaction&) const = 0;
     // Removes a device
     virtual void RemoveDevice(DeviceId deviceId, UserId user) = 0;
     virtual void RemoveDevice(DeviceId deviceId, const UserHeldTransaction&) = 0;
@@ -53,6 +68,14 @@ public:
         DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, const UserHeldTransaction&)
         = 0;
 
+    // Updates, inserts and logs multiple properties in one transaction
+    virtual void SetDeviceProperties(DeviceId deviceId, const std::vector<PropertyWrite>& writes,
+        const Properties& properties, UserId user)
+        = 0;
+    virtual void SetDeviceProperties(DeviceId deviceId, const std::vector<PropertyWrite>& writes,
+        const Properties& properties, const UserHeldTransaction&)
+        = 0;
+
     virtual nlohmann::json GetPropertyHistory(DeviceId deviceId, absl::string_view propertyKey,
         const std::chrono::system_clock::time_point& start,
         absl::optional<const std::chrono::system_clock::time_point> end, std::time_t compression,
@@ -1103,7 +1103,8 @@ bool RuleConditions::RuleDeviceCondition::IsSatisfiedAfterEvent(const EventBase&
             "RuleDeviceCondition got wrong EventType: " + std::to_string(static_cast<int>(e.GetType())));
     }
     const auto& casted = EventCast<Events::DevicePropertyChangeEvent>(e);
-    if (casted.GetChanged().GetId() == m_deviceId && casted.GetChangedFields() == m_property)
+    const std::vector<std::string>& keys = casted.GetChangedFields();
+    if (casted.GetChanged().GetId() == m_deviceId && std::find(keys.begin(), keys.end(), m_property) != keys.end())
     {
         // This Event affects the rule
         nlohmann::json value = casted.GetChanged().GetProperty(m_property);
@@ -8,9 +8,13 @@
 #include <cryptopp/sha.h>
 
 constexpr std::chrono::seconds Authenticator::s_tokenExpiration;
+constexpr std::size_t Authenticator::s_tokenCacheSize;
 
 namespace
 {
+    // Margin for clock skew when checking token expiration
+    constexpr std::chrono::minutes expirationMargin{2};
+
     constexpr CryptoPP::byte key[] = {0x6A, 0x2D, 0xFC, 0xA3, 0x4B, 0xE8, 0xAE, 0x82, 0x96, 0x8B, 0x63, 0xE9, 0x6C, 0xD1, 0x9A,
         0xFE, 0x73, 0xC0, 0x2B, 0x09, 0xF8, 0xEA, 0x20, 0xAC, 0xF4, 0x26, 0x8B, 0x03, 0x5E, 0x2E, 0xE2, 0xEA};
 } // namespace
@@ -154,7 +158,7 @@ nlohmann::json Authenticator::ValidateJWTToken(const std::string& encoded) const
         // Check expiration time, with 2 minutes margin for clock skew
         std::chrono::system_clock::time_point expires
             = std::chrono::system_clock::time_point(std::chrono::seconds(payloadJson.at("exp")));
-        if (std::chrono::system_clock::now() > expires + std::chrono::minutes(2))
+        if (std::chrono::system_clock::now() > expires + expirationMargin)
         {
             return nullptr;
         }
@@ -170,6 +174,56 @@ nlohmann::json Authenticator::ValidateJWTToken(const std::string& encoded) const
     return nullptr;
 }
 
+absl::optional<UserId> Authenticator::ValidateUserToken(const std::string& encoded) const
+{
+    const std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_tokenCacheMutex);
+        auto it = m_tokenCacheIndex.find(encoded);
+        if (it != m_tokenCacheIndex.end())
+        {
+            if (now > it->second->expires)
+            {
+                m_tokenCache.erase(it->second);
+                m_tokenCacheIndex.erase(it);
+                return absl::nullopt;
+            }
+            m_tokenCache.splice(m_tokenCache.begin(), m_tokenCache, it->second);
+            return it->second->user;
+        }
+    }
+
+    nlohmann::json payload = ValidateJWTToken(encoded);
+    if (payload == nullptr)
+    {
+        return absl::nullopt;
+    }
+    absl::optional<UserId> user;
+    std::chrono::system_clock::time_point expires;
+    try
+    {
+        user = UserId(std::stoll(payload.at("sub").get<std::string>()));
+        expires = std::chrono::system_clock::time_point(std::chrono::seconds(payload.at("exp"))) + expirationMargin;
+    }
+    catch (...)
+    {
+        return absl::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(m_tokenCacheMutex);
+    if (m_tokenCacheIndex.count(encoded) == 0)
+    {
+        if (m_tokenCache.size() >= s_tokenCacheSize)
+        {
+            m_tokenCacheIndex.erase(m_tokenCache.back().token);
+            m_tokenCache.pop_back();
+        }
+        m_tokenCache.push_front(CachedToken{encoded, *user, expires});
+        m_tokenCacheIndex.emplace(encoded, m_tokenCache.begin());
+    }
+    return user;
+}
+
 std::string Authenticator::CreatePasswordHash(absl::string_view password) const
 {
     CryptoPP::PKCS5_PBKDF2_HMAC<CryptoPP::SHA256> pbkdf2;
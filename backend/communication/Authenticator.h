@@ -1,20 +1,44 @@
 #pragma once
 
 #include <chrono>
+#include <list>
+#include <mutex>
 #include <string>
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/string_view.h>
+#include <absl/types/optional.h>
 
 #include <json.hpp>
 
+#include "../api/User.h"
+
 class Authenticator
 {
 public:
     bool ValidatePassword(const std::string& password, const std::string& hash) const;
     std::string CreateJWTToken(nlohmann::json payload) const;
     nlohmann::json ValidateJWTToken(const std::string& encoded) const;
+    // Validates token and returns the user id in "sub", or nullopt if invalid.
+    // Valid tokens are cached until they expire, so clients resending the same token skip decoding and HMAC checks.
+    absl::optional<UserId> ValidateUserToken(const std::string& encoded) const;
 	std::string CreatePasswordHash(absl::string_view password) const;
 
 public:
     static constexpr std::chrono::seconds s_tokenExpiration = std::chrono::hours(2);
 	static constexpr unsigned int s_hashRounds = 6400;
-};
\ No newline at end of file
+    static constexpr std::size_t s_tokenCacheSize = 64;
+
+private:
+    struct CachedToken
+    {
+        std::string token;
+        UserId user;
+        std::chrono::system_clock::time_point expires;
+    };
+
+private:
+    // Most recently used token at front
+    mutable std::list<CachedToken> m_tokenCache;
+    mutable absl::flat_hash_map<std::string, std::list<CachedToken>::iterator> m_tokenCacheIndex;
+    mutable std::mutex m_tokenCacheMutex;
+};
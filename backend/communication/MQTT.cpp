@@ -21,27 +21,13 @@ MQTT::~MQTT()
 std::future<std::vector<int>> MQTT::Subscribe(
     const std::string& topic, const MQTTClient::Callback& messageCallback, const std::string& ip, int port, int qos)
 {
-    ClientConnection connection {ip, port};
-
-    if (!mClients.contains(connection))
-    {
-        mClients.emplace(std::piecewise_construct, std::forward_as_tuple(connection), std::forward_as_tuple(ip, port));
-    }
-
-    return mClients.find(connection)->second.Subscribe(topic, messageCallback, qos);
+    return GetClient(ip, port).Subscribe(topic, messageCallback, qos);
 }
 
 std::future<bool> MQTT::Publish(
     const std::string& topic, const std::string& payload, const std::string& ip, int port, int qos, bool retain)
 {
-    ClientConnection connection {ip, port};
-
-    if (!mClients.contains(connection))
-    {
-        mClients.emplace(std::piecewise_construct, std::forward_as_tuple(connection), std::forward_as_tuple(ip, port));
-    }
-
-    return mClients.find(connection)->second.Publish(topic, payload, qos, retain);
+    return GetClient(ip, port).Publish(topic, payload, qos, retain);
 }
 
 MQTTClient& MQTT::GetClient(const std::string& ip, int port)
@@ -50,7 +36,8 @@ MQTTClient& MQTT::GetClient(const std::string& ip, int port)
 
     if (!mClients.contains(connection))
     {
-        mClients.emplace(std::piecewise_construct, std::forward_as_tuple(connection), std::forward_as_tuple(ip, port));
+        mClients.emplace(std::piecewise_construct, std::forward_as_tuple(connection),
+            std::forward_as_tuple(ip, port, MQTTClient::s_defaultWorkerThreads, &mReactor));
     }
 
     return mClients.find(connection)->second;
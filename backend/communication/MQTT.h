@@ -57,6 +57,9 @@ private:
     };
 
 private:
+    ///
+    /// \brief Runs the network traffic of all clients on one thread, must be destroyed after the clients
+    MQTTReactor mReactor;
     ///
     /// \brief Maps connections to clients
     ///
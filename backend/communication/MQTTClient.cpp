@@ -5,9 +5,25 @@
 #include "../api/Resources.h"
 #include "../utility/Logger.h"
 
-MQTTClient::MQTTClient(const std::string& ip, int port)
+constexpr std::size_t MQTTClient::s_defaultWorkerThreads;
+
+MQTTClient::MQTTClient(const std::string& ip, int port, std::size_t workerThreads, MQTTReactor* reactor)
+    : m_reactor(reactor)
 {
+    if (m_reactor == nullptr)
+    {
+        m_ownReactor = std::make_unique<MQTTReactor>();
+        m_reactor = m_ownReactor.get();
+    }
+    if (workerThreads > 0)
+    {
+        m_workers = std::make_unique<MQTTWorkerPool>(
+            workerThreads, [this](const MQTTMessage& message) { OnMessage(message); });
+    }
     m_mosq = mosquitto_new("Home++", false, this);
+    // Publish and subscribe only queue packets which the reactor thread sends, so they never write to the socket
+    // while m_mutex is held and bursts of publishes are sent together
+    mosquitto_threaded_set(m_mosq, true);
     mosquitto_connect_callback_set(m_mosq, OnConnectWrapper);
     mosquitto_disconnect_callback_set(m_mosq, OnDisconnectWrapper);
     mosquitto_publish_callback_set(m_mosq, OnPublishWrapper);
@@ -15,31 +31,25 @@ MQTTClient::MQTTClient(const std::string& ip, int port)
     mosquitto_subscribe_callback_set(m_mosq, OnSubscribeWrapper);
     mosquitto_unsubscribe_callback_set(m_mosq, OnUnsubscribeWrapper);
     mosquitto_log_callback_set(m_mosq, OnLogWrapper);
+    // If the broker is not reachable, the reactor reconnects later
     mosquitto_connect(m_mosq, ip.c_str(), port, 60);
-
-    m_threadRunning = true;
-    m_thread = std::thread(&MQTTClient::Loop, this);
+    m_reactor->Add(m_mosq);
 
     Res::Logger().Debug("MQTTClient", "Client for broker " + ip + ":" + std::to_string(port) + " created");
 }
 
 MQTTClient::~MQTTClient()
 {
-    if (m_threadRunning)
-    {
-        m_threadRunning = false;
-        if (m_thread.joinable())
-        {
-            // Wait until the thread finishes if it is still running
-            m_thread.join();
-        }
-    }
+    // Waits until the reactor no longer calls callbacks
+    m_reactor->Remove(m_mosq);
+    // Stop workers before callbacks and subscriptions are destroyed
+    m_workers.reset();
     mosquitto_destroy(m_mosq);
 }
 
 bool MQTTClient::isSubscribed(const std::string& topic)
 {
-    return std::find(activeSubscriptions.begin(), activeSubscriptions.end(), topic) != activeSubscriptions.end();
+    return subscriptions.Contains(topic);
 }
 
 std::future<std::vector<int>> MQTTClient::Subscribe(const std::string& topic, const Callback& messageCallback, int qos)
@@ -53,14 +63,14 @@ std::future<std::vector<int>> MQTTClient::Subscribe(const std::string& topic, co
     {
         int messageId;
         handleErrorCode(mosquitto_subscribe(m_mosq, &messageId, topic.c_str(), qos));
-        subscriptions.push_back(std::make_pair(topic, messageCallback));
-        activeSubscriptions.push_back(topic);
+        subscriptions.Insert(topic, messageCallback);
 
         newSubscriptions.push_back(std::make_pair(messageId, std::move(promise)));
+        m_reactor->Wake();
     }
     else
     {
-        subscriptions.push_back(std::make_pair(topic, messageCallback));
+        subscriptions.Insert(topic, messageCallback);
 
         promise.set_value(std::vector<int> {0});
     }
@@ -70,51 +80,57 @@ std::future<std::vector<int>> MQTTClient::Subscribe(const std::string& topic, co
 
 std::future<bool> MQTTClient::Publish(const std::string& topic, const std::string& payload, int qos, bool retain)
 {
-    int messageId;
-    handleErrorCode(mosquitto_publish(m_mosq, &messageId, topic.c_str(), payload.size(), payload.c_str(), qos, retain));
-
     std::promise<bool> promise;
     auto future = promise.get_future();
 
+    // Locked before publishing, so OnPublish cannot run before the promise is stored
     std::lock_guard<std::mutex> guard(m_mutex);
-    newPublishes.push_back(std::make_pair(messageId, std::move(promise)));
+    int messageId;
+    const int code = mosquitto_publish(m_mosq, &messageId, topic.c_str(), payload.size(), payload.c_str(), qos, retain);
+    handleErrorCode(code);
+    if (code == MOSQ_ERR_SUCCESS)
+    {
+        m_pendingPublishes.emplace(messageId, std::move(promise));
+        m_reactor->Wake();
+    }
+    else
+    {
+        // Not connected, the message is dropped and OnPublish is never called for it
+        promise.set_value(false);
+    }
 
     return future;
 }
 
-void MQTTClient::handleErrorCode(int code)
+void MQTTClient::PublishAndForget(const std::string& topic, absl::string_view payload, int qos, bool retain)
 {
-    if (code != MOSQ_ERR_NO_CONN && code != MOSQ_ERR_SUCCESS)
-    {
-        throw std::runtime_error(mosquitto_strerror(code));
-    }
+    handleErrorCode(mosquitto_publish(m_mosq, NULL, topic.c_str(), payload.size(), payload.data(), qos, retain));
+    m_reactor->Wake();
 }
 
-bool MQTTClient::topicMatches(const std::string& subscription, const std::string& topic)
+void MQTTClient::PublishBatch(const std::vector<PublishMessage>& messages)
 {
-    bool result = false;
-    // mosquitto_topic_matches_sub2(subscription.c_str(), subscription.length(), topic.c_str(), topic.length(),
-    // &result);
-    mosquitto_topic_matches_sub(subscription.c_str(), topic.c_str(), &result);
-    return result;
+    for (const PublishMessage& message : messages)
+    {
+        const int code = mosquitto_publish(m_mosq, NULL, message.topic.c_str(), message.payload.size(),
+            message.payload.data(), message.qos, message.retain);
+        if (code != MOSQ_ERR_SUCCESS && code != MOSQ_ERR_NO_CONN)
+        {
+            // Send the messages which were already queued
+            m_reactor->Wake();
+            handleErrorCode(code);
+        }
+    }
+    // Wake once, so the reactor sends all messages together
+    m_reactor->Wake();
 }
 
-void MQTTClient::Loop()
+void MQTTClient::handleErrorCode(int code)
 {
-    Res::Logger().Debug("MQTTClient", "Thread started");
-    // std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-    while (m_threadRunning)
+    if (code != MOSQ_ERR_NO_CONN && code != MOSQ_ERR_SUCCESS)
     {
-        // std::this_thread::sleep_until(start + s_checkInterval);
-        int code = mosquitto_loop(m_mosq, -1, 1);
-        // handleReturnCode(code);
-        if (code)
-        {
-            mosquitto_reconnect(m_mosq);
-        }
-        // start = std::chrono::steady_clock::now();
+        throw std::runtime_error(mosquitto_strerror(code));
     }
-    Res::Logger().Debug("MQTTClient", "Thread stopped");
 }
 
 void MQTTClient::OnConnect(int returnCode) {}
@@ -124,53 +140,29 @@ void MQTTClient::OnDisconnect(int reason) {}
 void MQTTClient::OnPublish(int messageId)
 {
     std::lock_guard<std::mutex> guard(m_mutex);
-    auto ite = std::find_if(
-        newPublishes.begin(), newPublishes.end(), [&](const auto& cmp) { return cmp.first == messageId; });
-    if (ite != newPublishes.end())
+    auto ite = m_pendingPublishes.find(messageId);
+    if (ite != m_pendingPublishes.end())
     {
         ite->second.set_value(true);
-        newPublishes.erase(ite);
+        m_pendingPublishes.erase(ite);
     }
 }
 
-void MQTTClient::OnMessage(int messageId, std::string topic, std::string paylaod, int qos, bool retain)
+void MQTTClient::OnMessage(const MQTTMessage& message)
 {
-    // Res::Logger().Info("MQTTClient", "New message received " + topic + " : " + paylaod);
-    std::vector<std::reference_wrapper<Callback>> callbacks;
-    {
-        std::lock_guard<std::mutex> guard(m_mutex);
-        for (std::pair<std::string, Callback>& subscription : subscriptions)
-        {
-            if (topicMatches(subscription.first, topic))
+    subscriptions.Match(
+        message.topic, message.topicLevels, [&](auto handle, const std::shared_ptr<const Callback>& callback) {
+            if ((*callback)(message))
             {
-                callbacks.push_back(std::ref(subscription.second));
-            }
-        }
-    }
-
-    for (Callback& callback : callbacks)
-    {
-        if (callback(messageId, topic, paylaod, qos, retain))
-        {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto ite = std::find_if(
-                subscriptions.begin(), subscriptions.end(), [&](auto& cmp) { return &cmp.second == &callback; });
-            if (ite != subscriptions.end())
-            {
-                std::string subscribedTopic = ite->first;
-                subscriptions.erase(ite);
-
-                ite = std::find_if(subscriptions.begin(), subscriptions.end(),
-                    [&](auto& cmp) { return cmp.first == subscribedTopic; });
-                if (ite == subscriptions.end())
+                std::lock_guard<std::mutex> guard(m_mutex);
+                std::string unsubscribedTopic;
+                if (subscriptions.Remove(handle, &unsubscribedTopic) && !unsubscribedTopic.empty())
                 {
-                    auto aite = std::find(activeSubscriptions.begin(), activeSubscriptions.end(), subscribedTopic);
-                    activeSubscriptions.erase(aite);
-                    mosquitto_unsubscribe(m_mosq, NULL, subscribedTopic.c_str());
+                    mosquitto_unsubscribe(m_mosq, NULL, unsubscribedTopic.c_str());
+                    m_reactor->Wake();
                 }
             }
-        }
-    }
+        });
 }
 
 void MQTTClient::OnSubscribe(int messageId, std::vector<int> qos)
@@ -210,9 +202,20 @@ void MQTTClient::OnPublishWrapper(struct mosquitto* mosq, void* userdata, int me
 void MQTTClient::OnMessageWrapper(struct mosquitto* mosq, void* userdata, const struct mosquitto_message* message)
 {
     class MQTTClient* m = (class MQTTClient*)userdata;
-    m->OnMessage(message->mid, std::string(message->topic),
-        std::string(reinterpret_cast<const char*>(message->payload), message->payloadlen), message->qos,
-        message->retain);
+    const absl::string_view topic(message->topic);
+    // Split once for subscription matching and handlers
+    const MQTTTopicTree<Callback>::Levels levels = MQTTTopicTree<Callback>::Split(topic);
+    MQTTMessage msg {message->mid, topic,
+        absl::string_view(reinterpret_cast<const char*>(message->payload), message->payloadlen), message->qos,
+        message->retain, levels};
+    if (m->m_workers != nullptr)
+    {
+        m->m_workers->Push(msg);
+    }
+    else
+    {
+        m->OnMessage(msg);
+    }
 };
 
 void MQTTClient::OnSubscribeWrapper(
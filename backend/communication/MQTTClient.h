@@ -2,18 +2,55 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <future>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+#include <absl/types/span.h>
+
+#include "MQTTReactor.h"
+#include "MQTTTopicTree.h"
+#include "MQTTWorkerPool.h"
+
+///
+/// \brief Message received from the broker
+///
+/// topic, payload and topicLevels point into buffers owned by mosquitto and are only valid during the callback,
+/// handlers have to copy what they want to keep.
+struct MQTTMessage
+{
+    int messageId;
+    absl::string_view topic;
+    absl::string_view payload;
+    int qos;
+    bool retain;
+    /// topic split at '/'
+    absl::Span<const absl::string_view> topicLevels;
+};
+
+///
+/// \brief Outgoing message for MQTTClient::PublishBatch
+struct PublishMessage
+{
+    std::string topic;
+    std::string payload;
+    int qos = 0;
+    bool retain = false;
+};
+
 /// \see https://mosquitto.org/api/files/mosquitto-h.html
 class MQTTClient
 {
 public:
-    using Callback = std::function<bool(int, const std::string&, const std::string&, int, bool)>;
+    /// Return true to remove the subscription
+    using Callback = std::function<bool(const MQTTMessage&)>;
 
 public:
     ///
@@ -21,7 +58,11 @@ public:
     ///
     /// \param ip The ip address of the broker
     /// \param port The port of the broker
-    MQTTClient(const std::string& ip, int port = 1883);
+    /// \param workerThreads Number of threads which run the callbacks, 0 to run them on the network thread
+    /// \param reactor Reactor which runs the network thread, nullptr to create one only for this client. Must outlive
+    /// the client.
+    MQTTClient(const std::string& ip, int port = 1883, std::size_t workerThreads = s_defaultWorkerThreads,
+        MQTTReactor* reactor = nullptr);
 
     ///
     /// \brief MQTTClient destructor
@@ -43,13 +84,36 @@ public:
     /// \param payload The payload to publish
     /// \param qos The quality of service of the message
     /// \param retain True to have the message retained by the broker
+    /// \return Future which becomes true once the message was sent, or false if it was dropped because the client is
+    /// not connected
+    /// \throws std::runtime_error if the message could not be published for another reason
     std::future<bool> Publish(const std::string& topic, const std::string& payload, int qos = 0, bool retain = false);
 
+    ///
+    /// \brief Publish the given message/payload without waiting for or tracking the acknowledgement
+    ///
+    /// Use this when the result is not needed, it does not allocate a promise per message.
+    /// \param topic The topic to publish the message on
+    /// \param payload The payload to publish
+    /// \param qos The quality of service of the message
+    /// \param retain True to have the message retained by the broker
+    void PublishAndForget(const std::string& topic, absl::string_view payload, int qos = 0, bool retain = false);
+
+    ///
+    /// \brief Publish multiple messages at once without tracking their acknowledgements
+    ///
+    /// The messages are queued together and sent by the network thread in one burst, in the given order.
+    /// \param messages The messages to publish
+    /// \throws std::runtime_error if a message could not be published, the messages before it are still sent
+    void PublishBatch(const std::vector<PublishMessage>& messages);
+
+public:
+    static constexpr std::size_t s_defaultWorkerThreads = 2;
+
 private:
     ///
     /// \brief Check whether the given topic is already subscribed
     ///
-    /// Calls to this function must be locked by m_mutex
     /// \param topic The topic to check
     /// \return True if the topic is subscribed, false if nots
     bool isSubscribed(const std::string& topic);
@@ -59,13 +123,6 @@ private:
     ///
     void handleErrorCode(int code);
 
-    bool topicMatches(const std::string& subscription, const std::string& topic);
-
-    ///
-    /// \brief Internal loop handling MQTT connection
-    ///
-    void Loop();
-
     ///
     /// \brief Called when the broker sends a CONNACK message in response to a connection.
     ///
@@ -90,12 +147,8 @@ private:
     ///
     /// \brief Called when a message is received from the broker
     ///
-    /// \param messageId The message identifier of the received message
-    /// \param topic The topic on which the message was published
-    /// \param payload The payload that was published
-    /// \param qos The quality of service of the message
-    /// \param retain Whether the message should be retained
-    void OnMessage(int messageId, std::string topic, std::string paylaod, int qos, bool retain);
+    /// \param message The received message, without copies of topic and payload
+    void OnMessage(const MQTTMessage& message);
     ///
     /// \brief Called when the broker responds to a subscription request
     ///
@@ -159,13 +212,25 @@ private:
      */
     struct mosquitto* m_mosq;
     /*!
-     * \brief Indicates that thread is running (as opposed to single-threaded mode).
+     * \brief Reactor created for this client, if none was passed to the constructor
      */
-    std::atomic_bool m_threadRunning {false};
-    std::thread m_thread;
+    std::unique_ptr<MQTTReactor> m_ownReactor;
+    /*!
+     * \brief Reactor which runs the network traffic and callbacks of m_mosq
+     */
+    MQTTReactor* m_reactor;
     std::mutex m_mutex;
-    std::vector<std::pair<std::string, Callback>> subscriptions;
-    std::vector<std::string> activeSubscriptions;
+    /*!
+     * \brief Callbacks by subscribed topic, can be matched without locking m_mutex
+     */
+    MQTTTopicTree<Callback> subscriptions;
+    /*!
+     * \brief Runs callbacks off the network thread, nullptr if they are called directly
+     */
+    std::unique_ptr<MQTTWorkerPool> m_workers;
     std::vector<std::pair<int, std::promise<std::vector<int>>>> newSubscriptions;
-    std::vector<std::pair<int, std::promise<bool>>> newPublishes;
+    /*!
+     * \brief Promises of Publish by message id, until the broker acknowledged the message
+     */
+    absl::flat_hash_map<int, std::promise<bool>> m_pendingPublishes;
 };
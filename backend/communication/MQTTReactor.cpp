@@ -0,0 +1,278 @@
+#include "MQTTReactor.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <mosquitto.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "../api/Resources.h"
+#include "../utility/Logger.h"
+
+constexpr std::chrono::milliseconds MQTTReactor::s_minReconnectDelay;
+constexpr std::chrono::milliseconds MQTTReactor::s_maxReconnectDelay;
+constexpr std::chrono::milliseconds MQTTReactor::s_miscInterval;
+
+MQTTReactor::MQTTReactor()
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        throw std::runtime_error(std::string("MQTTReactor: epoll_create1 failed: ") + std::strerror(errno));
+    }
+    m_wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeup < 0)
+    {
+        close(m_epoll);
+        throw std::runtime_error(std::string("MQTTReactor: eventfd failed: ") + std::strerror(errno));
+    }
+    epoll_event event {};
+    event.events = EPOLLIN;
+    // nullptr marks the wakeup event, clients use their Client*
+    event.data.ptr = nullptr;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event);
+
+    m_thread = std::thread(&MQTTReactor::Run, this);
+}
+
+MQTTReactor::~MQTTReactor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    Wake();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    close(m_wakeup);
+    close(m_epoll);
+}
+
+void MQTTReactor::Add(struct mosquitto* mosq)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_added.push_back(mosq);
+    }
+    Wake();
+}
+
+void MQTTReactor::Remove(struct mosquitto* mosq)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_removed.push_back(mosq);
+    // Changes are applied with m_mutex locked, so the next generation has seen the removal
+    const std::size_t generation = m_generation + 1;
+    Wake();
+    m_changed.wait(lock, [&] { return m_generation >= generation || !m_running; });
+}
+
+void MQTTReactor::Wake()
+{
+    const uint64_t value = 1;
+    // Can only fail if the counter overflows, in which case the reactor is woken up anyways
+    (void)write(m_wakeup, &value, sizeof(value));
+}
+
+std::chrono::milliseconds MQTTReactor::NextReconnectDelay(std::chrono::milliseconds current)
+{
+    return std::max(s_minReconnectDelay, std::min(current * 2, s_maxReconnectDelay));
+}
+
+void MQTTReactor::Run()
+{
+    Res::Logger().Debug("MQTTReactor", "Thread started");
+    std::array<epoll_event, 16> events;
+    m_nextMisc = std::chrono::steady_clock::now() + s_miscInterval;
+    while (ApplyChanges())
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= m_nextMisc)
+        {
+            for (std::unique_ptr<Client>& client : m_clients)
+            {
+                if (!client->reconnectScheduled)
+                {
+                    // Sends keepalive pings and retries messages with qos > 0
+                    mosquitto_loop_misc(client->mosq);
+                }
+            }
+            m_nextMisc = now + s_miscInterval;
+        }
+        for (std::unique_ptr<Client>& client : m_clients)
+        {
+            Update(*client, now);
+        }
+
+        const int count = epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()), GetTimeout(now));
+        if (count < 0 && errno != EINTR)
+        {
+            Res::Logger().Error("MQTTReactor", std::string("epoll_wait failed: ") + std::strerror(errno));
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.ptr == nullptr)
+            {
+                uint64_t value;
+                (void)read(m_wakeup, &value, sizeof(value));
+            }
+            else
+            {
+                HandleEvent(*static_cast<Client*>(events[i].data.ptr), events[i].events);
+            }
+        }
+    }
+    Res::Logger().Debug("MQTTReactor", "Thread stopped");
+}
+
+bool MQTTReactor::ApplyChanges()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (struct mosquitto* mosq : m_added)
+    {
+        std::unique_ptr<Client> client = std::make_unique<Client>();
+        client->mosq = mosq;
+        m_clients.push_back(std::move(client));
+    }
+    for (struct mosquitto* mosq : m_removed)
+    {
+        auto it = std::find_if(m_clients.begin(), m_clients.end(),
+            [&](const std::unique_ptr<Client>& client) { return client->mosq == mosq; });
+        if (it != m_clients.end())
+        {
+            Unregister(**it);
+            m_clients.erase(it);
+        }
+    }
+    m_added.clear();
+    m_removed.clear();
+    ++m_generation;
+    m_changed.notify_all();
+    return m_running;
+}
+
+void MQTTReactor::HandleEvent(Client& client, uint32_t events)
+{
+    if (client.reconnectScheduled)
+    {
+        return;
+    }
+    int code = MOSQ_ERR_SUCCESS;
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+    {
+        code = mosquitto_loop_read(client.mosq, 1);
+        if (code == MOSQ_ERR_SUCCESS)
+        {
+            // The broker answered, so the connection works
+            client.reconnectDelay = std::chrono::milliseconds(0);
+        }
+    }
+    if (code == MOSQ_ERR_SUCCESS && (events & EPOLLOUT))
+    {
+        code = mosquitto_loop_write(client.mosq, 1);
+    }
+    if (code != MOSQ_ERR_SUCCESS)
+    {
+        Res::Logger().Debug("MQTTReactor", std::string("Connection lost: ") + mosquitto_strerror(code));
+        ScheduleReconnect(client, std::chrono::steady_clock::now());
+    }
+}
+
+void MQTTReactor::Update(Client& client, std::chrono::steady_clock::time_point now)
+{
+    if (client.reconnectScheduled)
+    {
+        if (now < client.nextReconnect)
+        {
+            return;
+        }
+        client.reconnectScheduled = false;
+        const int code = mosquitto_reconnect_async(client.mosq);
+        if (code != MOSQ_ERR_SUCCESS)
+        {
+            Res::Logger().Debug("MQTTReactor", std::string("Reconnect failed: ") + mosquitto_strerror(code));
+            ScheduleReconnect(client, now);
+            return;
+        }
+    }
+    const int socket = mosquitto_socket(client.mosq);
+    if (socket < 0)
+    {
+        ScheduleReconnect(client, now);
+        return;
+    }
+    const bool wantWrite = mosquitto_want_write(client.mosq);
+    if (socket == client.socket && wantWrite == client.wantWrite)
+    {
+        return;
+    }
+    epoll_event event {};
+    event.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.ptr = &client;
+    if (socket != client.socket)
+    {
+        Unregister(client);
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) != 0)
+        {
+            Res::Logger().Error("MQTTReactor", std::string("Failed to add socket: ") + std::strerror(errno));
+            return;
+        }
+        client.socket = socket;
+    }
+    else
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket, &event);
+    }
+    client.wantWrite = wantWrite;
+}
+
+void MQTTReactor::ScheduleReconnect(Client& client, std::chrono::steady_clock::time_point now)
+{
+    Unregister(client);
+    client.reconnectDelay = NextReconnectDelay(client.reconnectDelay);
+    client.nextReconnect = now + client.reconnectDelay;
+    client.reconnectScheduled = true;
+}
+
+void MQTTReactor::Unregister(Client& client)
+{
+    if (client.socket < 0)
+    {
+        return;
+    }
+    // The socket may have been closed already and its number reused by another client
+    const bool reused = std::any_of(m_clients.begin(), m_clients.end(),
+        [&](const std::unique_ptr<Client>& c) { return c.get() != &client && c->socket == client.socket; });
+    if (!reused)
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, client.socket, nullptr);
+    }
+    client.socket = -1;
+    client.wantWrite = false;
+}
+
+int MQTTReactor::GetTimeout(std::chrono::steady_clock::time_point now) const
+{
+    std::chrono::steady_clock::time_point next = m_nextMisc;
+    for (const std::unique_ptr<Client>& client : m_clients)
+    {
+        if (client->reconnectScheduled)
+        {
+            next = std::min(next, client->nextReconnect);
+        }
+    }
+    if (next <= now)
+    {
+        return 0;
+    }
+    // Round up, so the reactor does not wake up just before the deadline
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count()) + 1;
+}
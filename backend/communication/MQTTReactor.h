@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct mosquitto;
+
+///
+/// \brief Drives the network traffic of multiple mosquitto clients on a single epoll thread
+///
+/// Instead of one thread per broker running mosquitto_loop, the reactor waits for the sockets of all clients
+/// and calls mosquitto_loop_read/mosquitto_loop_write when they are ready and mosquitto_loop_misc about once per
+/// second. Lost connections are reconnected with exponential backoff, so a broker which is down does not cause a
+/// busy loop. All mosquitto callbacks are called on the reactor thread.
+class MQTTReactor
+{
+public:
+    static constexpr std::chrono::milliseconds s_minReconnectDelay {1000};
+    static constexpr std::chrono::milliseconds s_maxReconnectDelay {60000};
+    static constexpr std::chrono::milliseconds s_miscInterval {1000};
+
+public:
+    ///
+    /// \brief Starts the reactor thread
+    ///
+    /// \throws std::runtime_error if epoll is not available
+    MQTTReactor();
+
+    ///
+    /// \brief Stops the reactor thread, all clients must have been removed
+    ///
+    ~MQTTReactor();
+
+    MQTTReactor(const MQTTReactor&) = delete;
+    MQTTReactor& operator=(const MQTTReactor&) = delete;
+
+    ///
+    /// \brief Start driving the client
+    ///
+    /// The client should already be connecting (mosquitto_connect). If it is not connected, a reconnect is scheduled.
+    /// \param mosq The client, must stay valid until it is removed
+    void Add(struct mosquitto* mosq);
+
+    ///
+    /// \brief Stop driving the client
+    ///
+    /// Waits until the reactor thread no longer uses the client, so it can be destroyed afterwards.
+    /// Must not be called from a mosquitto callback.
+    /// \param mosq The client which was added
+    void Remove(struct mosquitto* mosq);
+
+    ///
+    /// \brief Wake up the reactor thread to send packets which were queued from another thread
+    ///
+    void Wake();
+
+    ///
+    /// \brief Get the delay before the next reconnect attempt
+    ///
+    /// \param current The delay before the last attempt, 0 if it is the first one
+    /// \return Double the current delay, within s_minReconnectDelay and s_maxReconnectDelay
+    static std::chrono::milliseconds NextReconnectDelay(std::chrono::milliseconds current);
+
+private:
+    struct Client
+    {
+        struct mosquitto* mosq;
+        // Socket registered in epoll, -1 if none
+        int socket = -1;
+        bool wantWrite = false;
+        std::chrono::milliseconds reconnectDelay {0};
+        std::chrono::steady_clock::time_point nextReconnect;
+        bool reconnectScheduled = false;
+    };
+
+private:
+    void Run();
+
+    // Applies pending Add/Remove calls, returns false when the reactor is stopped
+    bool ApplyChanges();
+
+    void HandleEvent(Client& client, uint32_t events);
+
+    // Keeps the epoll registration in sync with the socket of the client and reconnects it if necessary
+    void Update(Client& client, std::chrono::steady_clock::time_point now);
+
+    void ScheduleReconnect(Client& client, std::chrono::steady_clock::time_point now);
+
+    void Unregister(Client& client);
+
+    int GetTimeout(std::chrono::steady_clock::time_point now) const;
+
+private:
+    int m_epoll = -1;
+    int m_wakeup = -1;
+    std::thread m_thread;
+
+    // Only used on the reactor thread
+    std::vector<std::unique_ptr<Client>> m_clients;
+    std::chrono::steady_clock::time_point m_nextMisc;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<struct mosquitto*> m_added;
+    std::vector<struct mosquitto*> m_removed;
+    // Incremented after pending changes are applied
+    std::size_t m_generation = 0;
+    bool m_running = true;
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/inlined_vector.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/string_view.h>
+#include <absl/types/span.h>
+
+///
+/// \brief Stores values by MQTT topic filter and finds all values whose filter matches a topic
+///
+/// Filters may contain the wildcards '+' (exactly one level) and '#' (all remaining levels, including none).
+/// Matching takes O(topic depth) for filters without wildcards. Nodes are never modified once they are visible to
+/// readers: Insert and Remove copy the path to the changed node and atomically swap the root, so Match and Contains
+/// do not wait for writers. std::atomic_load of a shared_ptr is not lock-free in the common standard libraries, it
+/// briefly takes an internal lock while the root pointer is copied, but not while the tree is traversed.
+template <typename T>
+class MQTTTopicTree
+{
+public:
+    /// Identifies an inserted value, stays valid until it is removed
+    using Handle = uint64_t;
+    /// Topic split at '/', does not allocate for up to 8 levels
+    using Levels = absl::InlinedVector<absl::string_view, 8>;
+
+public:
+    ///
+    /// \brief Insert a value for the topic filter
+    ///
+    /// \return Handle to remove the value
+    Handle Insert(absl::string_view filter, T value)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        const Handle handle = ++m_lastHandle;
+        const Levels levels = Split(filter);
+        std::shared_ptr<const Node> root = std::atomic_load(&m_root);
+        std::atomic_store(&m_root,
+            std::shared_ptr<const Node>(
+                Insert(root.get(), levels, 0, handle, std::make_shared<const T>(std::move(value)))));
+        m_filters.emplace(handle, std::string(filter));
+        return handle;
+    }
+
+    ///
+    /// \brief Remove the value with the handle
+    ///
+    /// \param removedFilter Set to the filter of the value, if it was the last value with this filter
+    /// \return True if the handle was found
+    bool Remove(Handle handle, std::string* removedFilter = nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        auto filterIt = m_filters.find(handle);
+        if (filterIt == m_filters.end())
+        {
+            return false;
+        }
+        const Levels levels = Split(filterIt->second);
+        std::shared_ptr<const Node> root = std::atomic_load(&m_root);
+        bool filterEmpty = false;
+        std::atomic_store(&m_root, Remove(root.get(), levels, 0, handle, filterEmpty));
+        if (filterEmpty && removedFilter != nullptr)
+        {
+            *removedFilter = filterIt->second;
+        }
+        m_filters.erase(filterIt);
+        return true;
+    }
+
+    ///
+    /// \brief Check whether any value is stored with exactly this filter
+    bool Contains(absl::string_view filter) const
+    {
+        std::shared_ptr<const Node> root = std::atomic_load(&m_root);
+        const Node* node = root.get();
+        for (absl::string_view level : Split(filter))
+        {
+            if (node == nullptr)
+            {
+                return false;
+            }
+            auto it = node->children.find(level);
+            node = it == node->children.end() ? nullptr : it->second.get();
+        }
+        return node != nullptr && !node->values.empty();
+    }
+
+    ///
+    /// \brief Call visitor(Handle, const std::shared_ptr<const T>&) for every value whose filter matches topic
+    ///
+    /// The values are taken from a snapshot, so the visitor may insert or remove values.
+    template <typename Visitor>
+    void Match(absl::string_view topic, Visitor&& visitor) const
+    {
+        Match(topic, Split(topic), visitor);
+    }
+
+    ///
+    /// \brief Same as Match(topic, visitor), with levels already split by Split(topic)
+    template <typename Visitor>
+    void Match(absl::string_view topic, absl::Span<const absl::string_view> levels, Visitor&& visitor) const
+    {
+        std::shared_ptr<const Node> root = std::atomic_load(&m_root);
+        if (root != nullptr)
+        {
+            // Topics beginning with $ are not matched by wildcards on the first level
+            const bool systemTopic = !topic.empty() && topic.front() == '$';
+            Match(*root, levels, 0, systemTopic, visitor);
+        }
+    }
+
+    static Levels Split(absl::string_view topic) { return absl::StrSplit(topic, '/'); }
+
+private:
+    using ValuePtr = std::shared_ptr<const T>;
+
+    struct Node
+    {
+        absl::flat_hash_map<std::string, std::shared_ptr<const Node>> children;
+        std::vector<std::pair<Handle, ValuePtr>> values;
+    };
+
+private:
+    static std::shared_ptr<Node> Insert(
+        const Node* node, const Levels& levels, std::size_t i, Handle handle, const ValuePtr& value)
+    {
+        std::shared_ptr<Node> copy = node != nullptr ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+        if (i == levels.size())
+        {
+            copy->values.emplace_back(handle, value);
+        }
+        else
+        {
+            auto it = copy->children.find(levels[i]);
+            const Node* child = it != copy->children.end() ? it->second.get() : nullptr;
+            copy->children[std::string(levels[i])] = Insert(child, levels, i + 1, handle, value);
+        }
+        return copy;
+    }
+
+    // Returns nullptr if the node is empty after removal
+    static std::shared_ptr<const Node> Remove(
+        const Node* node, const Levels& levels, std::size_t i, Handle handle, bool& filterEmpty)
+    {
+        if (node == nullptr)
+        {
+            return nullptr;
+        }
+        std::shared_ptr<Node> copy = std::make_shared<Node>(*node);
+        if (i == levels.size())
+        {
+            copy->values.erase(std::remove_if(copy->values.begin(), copy->values.end(),
+                                   [&](const std::pair<Handle, ValuePtr>& v) { return v.first == handle; }),
+                copy->values.end());
+            filterEmpty = copy->values.empty();
+        }
+        else
+        {
+            auto it = copy->children.find(levels[i]);
+            if (it != copy->children.end())
+            {
+                std::shared_ptr<const Node> child = Remove(it->second.get(), levels, i + 1, handle, filterEmpty);
+                if (child == nullptr)
+                {
+                    copy->children.erase(it);
+                }
+                else
+                {
+                    it->second = std::move(child);
+                }
+            }
+        }
+        if (copy->values.empty() && copy->children.empty())
+        {
+            return nullptr;
+        }
+        return copy;
+    }
+
+    template <typename Visitor>
+    static void Match(const Node& node, absl::Span<const absl::string_view> levels, std::size_t i, bool systemTopic,
+        Visitor& visitor)
+    {
+        const bool allowWildcard = !(systemTopic && i == 0);
+        if (allowWildcard)
+        {
+            // '#' also matches the parent level
+            auto multiIt = node.children.find("#");
+            if (multiIt != node.children.end())
+            {
+                Visit(*multiIt->second, visitor);
+            }
+        }
+        if (i == levels.size())
+        {
+            Visit(node, visitor);
+            return;
+        }
+        auto it = node.children.find(levels[i]);
+        if (it != node.children.end())
+        {
+            Match(*it->second, levels, i + 1, systemTopic, visitor);
+        }
+        if (allowWildcard)
+        {
+            auto singleIt = node.children.find("+");
+            if (singleIt != node.children.end())
+            {
+                Match(*singleIt->second, levels, i + 1, systemTopic, visitor);
+            }
+        }
+    }
+
+    template <typename Visitor>
+    static void Visit(const Node& node, Visitor& visitor)
+    {
+        for (const std::pair<Handle, ValuePtr>& value : node.values)
+        {
+            visitor(value.first, value.second);
+        }
+    }
+
+private:
+    std::shared_ptr<const Node> m_root;
+    std::mutex m_writeMutex;
+    Handle m_lastHandle = 0;
+    absl::flat_hash_map<Handle, std::string> m_filters;
+};
@@ -0,0 +1,169 @@
+#include "MQTTWorkerPool.h"
+
+#include <algorithm>
+
+#include <absl/hash/hash.h>
+
+#include "MQTTClient.h"
+
+#include "../api/Resources.h"
+#include "../utility/Logger.h"
+
+constexpr std::size_t MQTTWorkerPool::s_defaultMaxQueueSize;
+constexpr std::chrono::seconds MQTTWorkerPool::s_reportInterval;
+constexpr std::chrono::milliseconds MQTTWorkerPool::s_lagWarning;
+
+MQTTWorkerPool::MQTTWorkerPool(std::size_t workerThreads, Handler handler, std::size_t maxQueueSize)
+    : m_handler(std::move(handler)),
+      m_maxQueueSize(std::max<std::size_t>(maxQueueSize, 1)),
+      m_lastReport(std::chrono::steady_clock::now())
+{
+    workerThreads = std::max<std::size_t>(workerThreads, 1);
+    m_workers.reserve(workerThreads);
+    for (std::size_t i = 0; i < workerThreads; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        worker->thread = std::thread(&MQTTWorkerPool::Run, this, std::ref(*worker));
+    }
+}
+
+MQTTWorkerPool::~MQTTWorkerPool()
+{
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        worker->running = false;
+        worker->queue.clear();
+        lock.unlock();
+        worker->cv.notify_all();
+    }
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+void MQTTWorkerPool::Push(const MQTTMessage& message)
+{
+    Worker& worker = *m_workers[GetShard(message)];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.queue.size() >= m_maxQueueSize)
+        {
+            // The queue holds messages of many devices, so only a queued message with the same topic is superseded.
+            // Otherwise the new message is dropped, the queued one may be the only update of its device
+            ++m_dropped;
+            auto sameTopic = std::find_if(worker.queue.begin(), worker.queue.end(),
+                [&](const QueuedMessage& queued) { return queued.topic == message.topic; });
+            if (sameTopic == worker.queue.end())
+            {
+                return;
+            }
+            // Moved to the back, so the order of the messages of the device is kept
+            worker.queue.erase(sameTopic);
+        }
+        worker.queue.push_back(QueuedMessage {message.messageId, std::string(message.topic),
+            std::string(message.payload), message.qos, message.retain, std::chrono::steady_clock::now()});
+    }
+    worker.cv.notify_one();
+    ReportIfDue();
+}
+
+std::size_t MQTTWorkerPool::GetQueueDepth() const
+{
+    std::size_t depth = 0;
+    for (const std::unique_ptr<Worker>& worker : m_workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        depth += worker->queue.size();
+    }
+    return depth;
+}
+
+std::chrono::milliseconds MQTTWorkerPool::GetLag() const
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::milliseconds lag {0};
+    for (const std::unique_ptr<Worker>& worker : m_workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (!worker->queue.empty())
+        {
+            lag = std::max(
+                lag, std::chrono::duration_cast<std::chrono::milliseconds>(now - worker->queue.front().received));
+        }
+    }
+    return lag;
+}
+
+uint64_t MQTTWorkerPool::GetDroppedCount() const
+{
+    return m_dropped;
+}
+
+void MQTTWorkerPool::Run(Worker& worker)
+{
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    while (worker.running)
+    {
+        worker.cv.wait(lock, [&] { return !worker.running || !worker.queue.empty(); });
+        if (!worker.running)
+        {
+            break;
+        }
+        QueuedMessage queued = std::move(worker.queue.front());
+        worker.queue.pop_front();
+        lock.unlock();
+
+        using Tree = MQTTTopicTree<MQTTClient::Callback>;
+        const Tree::Levels levels = Tree::Split(queued.topic);
+        const MQTTMessage message {queued.messageId, queued.topic, queued.payload, queued.qos, queued.retain, levels};
+        try
+        {
+            m_handler(message);
+        }
+        catch (const std::exception& e)
+        {
+            Res::Logger().Error("MQTTWorkerPool", std::string("Exception while handling message: ") + e.what());
+        }
+
+        lock.lock();
+    }
+}
+
+std::size_t MQTTWorkerPool::GetShard(const MQTTMessage& message) const
+{
+    const absl::string_view key = message.topicLevels.size() > 2 ? message.topicLevels[1] : message.topic;
+    return absl::Hash<absl::string_view>()(key) % m_workers.size();
+}
+
+void MQTTWorkerPool::ReportIfDue()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_reportMutex, std::try_to_lock);
+    if (!lock.owns_lock() || now - m_lastReport < s_reportInterval)
+    {
+        return;
+    }
+    m_lastReport = now;
+    const std::size_t depth = GetQueueDepth();
+    const std::chrono::milliseconds lag = GetLag();
+    const uint64_t dropped = m_dropped;
+    const std::string status = "Queue depth " + std::to_string(depth) + ", lag " + std::to_string(lag.count())
+        + "ms, dropped " + std::to_string(dropped - m_reportedDropped) + " messages";
+    if (dropped != m_reportedDropped || lag >= s_lagWarning)
+    {
+        Res::Logger().Warning("MQTTWorkerPool", status);
+    }
+    else
+    {
+        Res::Logger().Debug("MQTTWorkerPool", status);
+    }
+    m_reportedDropped = dropped;
+}
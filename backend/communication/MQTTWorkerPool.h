@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct MQTTMessage;
+
+///
+/// \brief Processes received MQTT messages on worker threads instead of the network thread
+///
+/// Messages are sharded by device: the second topic level for topics like "tele/<device>/STATE", the whole topic
+/// otherwise. All messages of one device are handled by the same worker in the order they were received.
+/// Each worker queue is bounded so the network thread never blocks. When it is full, a new message replaces a queued
+/// message with the same topic, or is dropped if there is none.
+/// Queue depth, lag and dropped messages are logged periodically.
+class MQTTWorkerPool
+{
+public:
+    using Handler = std::function<void(const MQTTMessage&)>;
+
+public:
+    static constexpr std::size_t s_defaultMaxQueueSize = 10000;
+    static constexpr std::chrono::seconds s_reportInterval {60};
+    static constexpr std::chrono::milliseconds s_lagWarning {1000};
+
+public:
+    ///
+    /// \brief Starts the worker threads
+    ///
+    /// \param workerThreads Number of workers, at least 1
+    /// \param handler Called on the worker threads for every message
+    /// \param maxQueueSize Maximum number of queued messages per worker, at least 1
+    MQTTWorkerPool(std::size_t workerThreads, Handler handler, std::size_t maxQueueSize = s_defaultMaxQueueSize);
+
+    ///
+    /// \brief Stops the workers, messages which are still queued are dropped
+    ///
+    ~MQTTWorkerPool();
+
+    ///
+    /// \brief Copy the message into the queue of its worker
+    ///
+    /// Only copies topic and payload, so the network thread does not wait on any handler.
+    /// If the queue is full, a queued message with the same topic is removed, or this message is dropped if there is
+    /// none.
+    void Push(const MQTTMessage& message);
+
+    ///
+    /// \brief Number of messages waiting in all queues
+    std::size_t GetQueueDepth() const;
+
+    ///
+    /// \brief Time the oldest queued message has been waiting
+    std::chrono::milliseconds GetLag() const;
+
+    ///
+    /// \brief Number of messages dropped or replaced because a queue was full
+    uint64_t GetDroppedCount() const;
+
+private:
+    struct QueuedMessage
+    {
+        int messageId;
+        std::string topic;
+        std::string payload;
+        int qos;
+        bool retain;
+        std::chrono::steady_clock::time_point received;
+    };
+    struct Worker
+    {
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<QueuedMessage> queue;
+        bool running = true;
+        std::thread thread;
+    };
+
+private:
+    void Run(Worker& worker);
+
+    std::size_t GetShard(const MQTTMessage& message) const;
+
+    // Logs depth, lag and dropped messages if s_reportInterval passed since the last report
+    void ReportIfDue();
+
+private:
+    Handler m_handler;
+    std::size_t m_maxQueueSize;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<uint64_t> m_dropped {0};
+    uint64_t m_reportedDropped = 0;
+    std::mutex m_reportMutex;
+    std::chrono::steady_clock::time_point m_lastReport;
+};
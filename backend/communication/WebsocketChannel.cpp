@@ -1,5 +1,8 @@
 #include "WebsocketChannel.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
 #include "WebsocketCommunication.h"
 
 #include "../api/Resources.h"
@@ -28,21 +31,27 @@ void WebsocketChannel::OnChannelEvent(const absl::variant<Events::SocketMessageE
             const Events::SocketMessageEvent& messageEvent = absl::get<Events::SocketMessageEvent>(e);
             if (CheckAuthenticated(messageEvent))
             {
-                const nlohmann::json& json = messageEvent.GetJsonPayload();
-
-                auto commandIt = json.find("command");
-                if (commandIt != json.end())
+                const std::string& command = messageEvent.GetCommand();
+                if (command == "subscribeChannel")
                 {
-                    if (*commandIt == "subscribeChannel")
+                    Subscribe(messageEvent.GetConnection());
+                    const nlohmann::json& json = messageEvent.GetJsonPayload();
+                    auto binaryIt = json.find("binary");
+                    // Subscribing again without binary switches back to json
+                    if (binaryIt != json.end() && binaryIt->is_boolean() && binaryIt->get<bool>())
                     {
-                        Subscribe(messageEvent.GetConnection());
-                        return;
+                        m_binaryClients.insert(messageEvent.GetConnection());
                     }
-                    else if (*commandIt == "unsubscribeChannel")
+                    else
                     {
-                        Unsubscribe(messageEvent.GetConnection());
-                        return;
+                        m_binaryClients.erase(messageEvent.GetConnection());
                     }
+                    return;
+                }
+                else if (command == "unsubscribeChannel")
+                {
+                    Unsubscribe(messageEvent.GetConnection());
+                    return;
                 }
                 m_eventEmitter.EmitEvent(messageEvent, *this);
             }
@@ -63,6 +72,28 @@ void WebsocketChannel::Broadcast(nlohmann::json value)
     }
 }
 
+void WebsocketChannel::Broadcast(nlohmann::json value, const messages::ChannelMessage& message)
+{
+    value["channel"] = m_name;
+    // Only encode what is actually needed
+    std::string frame;
+    for (const auto& connection : m_clients)
+    {
+        if (IsBinary(connection))
+        {
+            if (frame.empty())
+            {
+                frame = EncodeChannelFrame(m_name, message);
+            }
+            m_communication->SendBytes(connection, frame.data(), frame.size());
+        }
+        else
+        {
+            m_communication->Send(connection, value);
+        }
+    }
+}
+
 void WebsocketChannel::Send(Events::SocketMessageEvent::connection_hdl connection, nlohmann::json value)
 {
     // Value is copied so channel can be added
@@ -76,6 +107,12 @@ void WebsocketChannel::SendBytes(connection_hdl connection, const void* data, st
     m_communication->SendBytes(connection, data, length);
 }
 
+void WebsocketChannel::SendMessage(connection_hdl connection, const messages::ChannelMessage& message)
+{
+    std::string frame = EncodeChannelFrame(m_name, message);
+    m_communication->SendBytes(connection, frame.data(), frame.size());
+}
+
 void WebsocketChannel::Subscribe(WebsocketCommunication::connection_hdl connection)
 {
     m_clients.insert(connection);
@@ -87,6 +124,7 @@ void WebsocketChannel::Subscribe(WebsocketCommunication::connection_hdl connecti
 void WebsocketChannel::Unsubscribe(WebsocketCommunication::connection_hdl connection)
 {
     m_clients.erase(connection);
+    m_binaryClients.erase(connection);
     Res::Logger().Debug("Client " + std::to_string(reinterpret_cast<intptr_t>(connection.lock().get()))
         + " unsubscribed from channel " + m_name);
     m_eventEmitter.EmitEvent(Events::SocketDisconnectEvent{connection, absl::nullopt}, *this);
@@ -109,4 +147,18 @@ bool WebsocketChannel::CheckAuthenticated(const Events::SocketMessageEvent& e)
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+std::string EncodeChannelFrame(absl::string_view channel, const messages::ChannelMessage& message)
+{
+    std::string frame;
+    {
+        google::protobuf::io::StringOutputStream stringStream(&frame);
+        google::protobuf::io::CodedOutputStream output(&stringStream);
+        output.WriteVarint32(static_cast<uint32_t>(channel.size()));
+        output.WriteRaw(channel.data(), static_cast<int>(channel.size()));
+        output.WriteVarint32(static_cast<uint32_t>(message.ByteSizeLong()));
+        message.SerializeWithCachedSizes(&output);
+    }
+    return frame;
+}
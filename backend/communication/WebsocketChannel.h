@@ -9,6 +9,7 @@
 
 #include "../communication/Authenticator.h"
 #include "../events/SocketEvents.h"
+#include "communication/channel_messages.pb.h"
 
 class WebsocketChannel
 {
@@ -32,13 +33,20 @@ public:
     // Sends a message to the specified connection. Does not require connection to be subscribed
     // json by value so channel name can be added
     void Send(connection_hdl connection, nlohmann::json value);
+    // Broadcasts a message to all connections subscribed to this channel.
+    // Connections in binary mode receive message, all others receive value
+    void Broadcast(nlohmann::json value, const messages::ChannelMessage& message);
     // Sends a binary message to the specified connection. Does not require connection to be subscribed
     void SendBytes(connection_hdl connection, const void* data, std::size_t length);
+    // Sends a length-prefixed protobuf frame to the specified connection. Does not require connection to be subscribed
+    void SendMessage(connection_hdl connection, const messages::ChannelMessage& message);
 
     void Subscribe(connection_hdl connection);
     void Unsubscribe(connection_hdl connection);
     // Returs whether clients have subscribe. Can be used to avoid unneccessary operations
     bool HasSubscribers() const { return m_clients.size() > 0; }
+    // Returns whether the connection subscribed with binary mode and expects protobuf frames instead of json
+    bool IsBinary(connection_hdl connection) const { return m_binaryClients.count(connection) > 0; }
 
     // Add event handler to handle events
     // If evHandler accepts socketConnect or socketDisconnect events,
@@ -54,8 +62,13 @@ private:
     class WebsocketCommunication* m_communication;
     std::string m_name;
     std::set<connection_hdl, std::owner_less<connection_hdl>> m_clients;
+    std::set<connection_hdl, std::owner_less<connection_hdl>> m_binaryClients;
     EventEmitter<EventVariant, WebsocketChannel&> m_eventEmitter;
     RequireAuth m_requireAuth;
 };
 
+// Encodes a binary channel frame: varint length and name of the channel, followed by varint length and message.
+// Multiple frames of the same channel may be concatenated into one websocket message
+std::string EncodeChannelFrame(absl::string_view channel, const messages::ChannelMessage& message);
+
 #endif
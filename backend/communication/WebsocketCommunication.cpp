@@ -111,11 +111,10 @@ void WebsocketCommunication::OnMessage(connection_hdl hdl, server::message_ptr m
         "Message from " + std::to_string(reinterpret_cast<intptr_t>(hdl.lock().get())) + ":" + msg->get_payload());
 
     Events::SocketMessageEvent event = Events::SocketMessageEvent::Parse(hdl, msg, m_authenticator);
-    const nlohmann::json& json = event.GetJsonPayload();
-    auto it = json.find("channel");
-    if (it != json.end())
+    const std::string& channel = event.GetChannel();
+    if (!channel.empty())
     {
-        auto channelIt = m_channels.find(*it);
+        auto channelIt = m_channels.find(channel);
         if (channelIt == m_channels.end())
         {
             Res::Logger().Warning("WebsocketCommunication", "Command to unknown channel will be ignored");
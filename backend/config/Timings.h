@@ -7,6 +7,8 @@ namespace Timings
 {
     constexpr std::chrono::duration<long long> LoadRequestHandlerLoadDuration() { return std::chrono::seconds(1); }
     constexpr std::chrono::duration<long long> LoadRequestHandlerTempDuration() { return std::chrono::seconds(10); }
+    // Default interval in which property changes are coalesced before being pushed to subscribers
+    constexpr std::chrono::milliseconds PropertyDeltaInterval() { return std::chrono::milliseconds(100); }
 
 #ifdef C_PLUS_PLUS_TESTING
     constexpr std::chrono::steady_clock::duration NodeCommunicationSendDelay() { return std::chrono::milliseconds(0); }
@@ -9,7 +9,29 @@
 #include "../events/RulesSocketHandler.h"
 #include "../events/WebsocketEventHandler.h"
 
-void CoreDeviceAPI::Initialize(nlohmann::json&) {}
+void CoreDeviceAPI::Initialize(nlohmann::json& config)
+{
+    // Interval in milliseconds in which property changes are coalesced for subscribed clients
+    auto intervalIt = config.find("propertyDeltaInterval");
+    if (intervalIt != config.end())
+    {
+        m_propertyDeltaInterval = std::chrono::milliseconds(intervalIt->get<int64_t>());
+    }
+    else
+    {
+        config["propertyDeltaInterval"] = m_propertyDeltaInterval.count();
+    }
+    // Number of devices per message in response to GET_DEVICES
+    auto chunkSizeIt = config.find("devicesChunkSize");
+    if (chunkSizeIt != config.end())
+    {
+        m_devicesChunkSize = chunkSizeIt->get<std::size_t>();
+    }
+    else
+    {
+        config["devicesChunkSize"] = m_devicesChunkSize;
+    }
+}
 
 void CoreDeviceAPI::Start()
 {
@@ -17,6 +39,10 @@ void CoreDeviceAPI::Start()
     {
         m_loadReqHandler->StartThread();
     }
+    if (m_propertyDeltaHandler)
+    {
+        m_propertyDeltaHandler->StartThread();
+    }
 }
 
 void CoreDeviceAPI::Shutdown()
@@ -25,6 +51,10 @@ void CoreDeviceAPI::Shutdown()
     {
         m_loadReqHandler->StopThread();
     }
+    if (m_propertyDeltaHandler)
+    {
+        m_propertyDeltaHandler->StopThread();
+    }
 }
 
 void CoreDeviceAPI::RegisterEventHandlers(EventSystem& evSys)
@@ -44,11 +74,15 @@ void CoreDeviceAPI::RegisterEventHandlers(EventSystem& evSys)
     // evSys.AddHandler(std::make_shared<DBEventHandler>(*m_dbHandler, *m_actionSer, *m_ruleSer));
     m_loadReqHandler
         = std::make_unique<LoadRequestHandler>(WebsocketChannelAccessor(*m_sockComm, statsChannel.GetName()));
+    m_propertyDeltaHandler = std::make_unique<PropertyDeltaHandler>(
+        WebsocketChannelAccessor(*m_sockComm, devicesChannel.GetName()), m_deviceReg->GetStorage(),
+        m_propertyDeltaInterval);
 
     statsChannel.AddEventHandler([this](const WebsocketChannel::EventVariant& e, WebsocketChannel& channel) {
         return m_loadReqHandler->HandleEvent(e, channel);
     });
-    devicesChannel.AddEventHandler(DevicesSocketHandler(*m_dbHandler, m_deviceReg->GetStorage(), *m_deviceTypeReg));
+    devicesChannel.AddEventHandler(DevicesSocketHandler(
+        *m_dbHandler, m_deviceReg->GetStorage(), *m_deviceTypeReg, m_propertyDeltaHandler.get(), m_devicesChunkSize));
     actionsChannel.AddEventHandler(ActionsSocketHandler(
         Res::ActionRegistry(), ActionStorage(*m_actionSer, m_actionChanges), *m_deviceReg, notificationsAccessor));
     rulesChannel.AddEventHandler(RulesSocketHandler(RuleStorage(*m_ruleSer, m_ruleChanges)));
@@ -61,6 +95,9 @@ void CoreDeviceAPI::RegisterEventHandlers(EventSystem& evSys)
         DeviceWebsocketEventHandler(WebsocketChannelAccessor(*m_sockComm, devicesChannel.GetName())));
     m_propertyChanges->AddHandler(
         DeviceWebsocketEventHandler(WebsocketChannelAccessor(*m_sockComm, devicesChannel.GetName())));
+    m_propertyChanges->AddHandler([this](const Events::DevicePropertyChangeEvent& e) {
+        return m_propertyDeltaHandler->HandlePropertyChange(e);
+    });
 
     m_sockComm->AddChannel(std::move(statsChannel));
     m_sockComm->AddChannel(std::move(devicesChannel));
@@ -8,7 +8,9 @@
 #include "../communication/Authenticator.h"
 #include "../communication/WebsocketCommunication.h"
 #include "../database/DBHandler.h"
+#include "../events/DevicesSocketHandler.h"
 #include "../events/LoadRequestHandler.h"
+#include "../events/PropertyDeltaHandler.h"
 
 class CoreDeviceAPI : public IDeviceAPI
 {
@@ -53,6 +55,9 @@ private:
     IRuleSerialize* m_ruleSer;
     Authenticator* m_authenticator;
     std::unique_ptr<LoadRequestHandler> m_loadReqHandler;
+    std::unique_ptr<PropertyDeltaHandler> m_propertyDeltaHandler;
+    std::chrono::milliseconds m_propertyDeltaInterval = Timings::PropertyDeltaInterval();
+    std::size_t m_devicesChunkSize = DevicesSocketHandler::s_defaultChunkSize;
     EventEmitter<Events::RuleChangeEvent> m_ruleChanges;
     EventEmitter<Events::ActionChangeEvent> m_actionChanges;
     EventEmitter<Events::DeviceChangeEvent>* m_deviceChanges;
@@ -225,4 +225,7 @@ struct SubActionsTable
     static constexpr const char* createStatement
         = "CREATE TABLE IF NOT EXISTS sub_actions(sub_action_id INTEGER PRIMARY KEY NOT NULL, action_id INTEGER NOT NULL REFERENCES "
           "actions(action_id) ON DELETE CASCADE, action_type INTEGER NOT NULL, data BLOB, timeout INTEGER DEFAULT 0, transition INTEGER DEFAULT 0);";
+    // Used to get the sub actions of an action and to delete them with it
+    static constexpr const char* createIndexStatement
+        = "CREATE INDEX IF NOT EXISTS sub_actions_action_id ON sub_actions(action_id);";
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "ConnectionPool.h"
+
+#include <stdexcept>
+
+ConnectionPool::Lease::~Lease()
+{
+    if (m_pool != nullptr && m_database != nullptr)
+    {
+        m_pool->Release(m_database);
+    }
+}
+
+ConnectionPool::ConnectionPool(
+    const std::string& filename, int busyTimeout, std::size_t maxConnections, const SqlitePragmas& pragmas)
+    : m_filename(filename), m_busyTimeout(busyTimeout), m_maxConnections(maxConnections), m_pragmas(pragmas)
+{
+    if (maxConnections == 0)
+    {
+        throw std::invalid_argument("ConnectionPool: maxConnections must not be 0");
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::Acquire()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cvRelease.wait(lock, [&] { return !m_idle.empty() || m_connections.size() < m_maxConnections; });
+    if (!m_idle.empty())
+    {
+        SqliteDatabase* database = m_idle.back();
+        m_idle.pop_back();
+        return Lease(this, *database);
+    }
+    m_connections.push_back(std::make_unique<SqliteDatabase>(m_filename, m_busyTimeout, true, m_pragmas));
+    return Lease(this, *m_connections.back());
+}
+
+std::size_t ConnectionPool::GetOpenConnections() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_connections.size();
+}
+
+void ConnectionPool::Release(SqliteDatabase* database)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.push_back(database);
+    }
+    m_cvRelease.notify_one();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SQLiteDatabase.h"
+
+// Pool of read only connections to one database file.
+// Connections are opened on demand, up to the maximum count.
+class ConnectionPool
+{
+public:
+    // Connection borrowed from the pool, returned when destroyed
+    class Lease
+    {
+    public:
+        // pool can be nullptr for a connection which is not pooled
+        Lease(ConnectionPool* pool, SqliteDatabase& database) : m_pool(pool), m_database(&database) {}
+        // Connection which is not pooled and shared with other threads, lock is held until the lease is destroyed
+        Lease(SqliteDatabase& database, std::unique_lock<std::recursive_mutex> lock)
+            : m_pool(nullptr), m_database(&database), m_lock(std::move(lock))
+        {}
+        Lease(Lease&& other) : m_pool(other.m_pool), m_database(other.m_database), m_lock(std::move(other.m_lock))
+        {
+            other.m_database = nullptr;
+        }
+        Lease& operator=(Lease&& other) = delete;
+        ~Lease();
+
+        sqlpp::sqlite3::connection& operator*() const { return m_database->GetDatabase(); }
+        sqlpp::sqlite3::connection* operator->() const { return &m_database->GetDatabase(); }
+
+    private:
+        ConnectionPool* m_pool;
+        SqliteDatabase* m_database;
+        std::unique_lock<std::recursive_mutex> m_lock;
+    };
+
+public:
+    ConnectionPool(const std::string& filename, int busyTimeout, std::size_t maxConnections,
+        const SqlitePragmas& pragmas = SqlitePragmas());
+
+    // Returns a free connection, blocks while all connections are in use
+    Lease Acquire();
+
+    std::size_t GetMaxConnections() const { return m_maxConnections; }
+    // Number of connections which are currently open
+    std::size_t GetOpenConnections() const;
+
+private:
+    void Release(SqliteDatabase* database);
+
+private:
+    std::string m_filename;
+    int m_busyTimeout;
+    std::size_t m_maxConnections;
+    SqlitePragmas m_pragmas;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cvRelease;
+    std::vector<std::unique_ptr<SqliteDatabase>> m_connections;
+    std::vector<SqliteDatabase*> m_idle;
+};
\ No newline at end of file
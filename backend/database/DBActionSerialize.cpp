@@ -7,6 +7,8 @@
 #include <sqlpp11/transaction.h>
 #include <sqlpp11/update.h>
 
+#include "LikeEscape.h"
+
 namespace
 {
     constexpr ActionsTable actions;
@@ -51,13 +53,14 @@ namespace
 
 absl::optional<Action> DBActionSerialize::GetAction(uint64_t actionId, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetAction(actionId, { user, transaction }), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAction(actionId, {user, transaction, *connection}), transaction);
 }
 
 absl::optional<Action> DBActionSerialize::GetAction(uint64_t actionId, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     auto result = GetActionsFromQuery(db,
         db(select(
             actions.actionId, actions.actionName, actions.actionIconName, actions.actionColor, actions.actionVisible)
@@ -76,29 +79,38 @@ absl::optional<Action> DBActionSerialize::GetAction(uint64_t actionId, const Use
 
 std::vector<Action> DBActionSerialize::GetAllActions(const Filter& filter, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetAllActions(filter, { user, transaction }), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAllActions(filter, {user, transaction, *connection}), transaction);
 }
 
 std::vector<Action> DBActionSerialize::GetAllActions(const Filter& filter, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
+    const std::string search = filter.getSearchString();
     auto result = db(
         select(actions.actionId, actions.actionName, actions.actionIconName, actions.actionColor, actions.actionVisible)
             .from(actions)
-            .unconditionally());
+            .where(sqlpp::value(search.empty()) or ContainsSearch(actions.actionName, filter))
+            .order_by(actions.actionId.asc())
+            .limit(filter.getQueryLimit())
+            .offset(static_cast<uint64_t>(filter.getStartIndex())));
     return GetActionsFromQuery(db, std::move(result), transaction);
 }
 
 uint64_t DBActionSerialize::AddAction(const Action& action, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(AddAction(action, { user, transaction }), transaction);
+    return m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            return CommitAndReturn(AddAction(action, {user, transaction, db}), transaction);
+        })
+        .get();
 }
 
 uint64_t DBActionSerialize::AddAction(const Action& action, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     const int64_t actionId = AddActionOnly(action, transaction );
 
     // Add SubActions
@@ -134,13 +146,17 @@ uint64_t DBActionSerialize::AddAction(const Action& action, const UserHeldTransa
 
 uint64_t DBActionSerialize::AddActionOnly(const Action& action, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(AddActionOnly(action, { user, transaction }), transaction);
+    return m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            return CommitAndReturn(AddActionOnly(action, {user, transaction, db}), transaction);
+        })
+        .get();
 }
 
-uint64_t DBActionSerialize::AddActionOnly(const Action& action, const UserHeldTransaction&)
+uint64_t DBActionSerialize::AddActionOnly(const Action& action, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
 
     int64_t actionId = action.GetId();
     bool actionExists = actionId != 0;
@@ -180,14 +196,18 @@ uint64_t DBActionSerialize::AddActionOnly(const Action& action, const UserHeldTr
 
 void DBActionSerialize::RemoveAction(uint64_t actionId, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-	RemoveAction(actionId, { user, transaction });
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            RemoveAction(actionId, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBActionSerialize::RemoveAction(uint64_t actionId, const UserHeldTransaction&)
+void DBActionSerialize::RemoveAction(uint64_t actionId, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
 
     db(remove_from(actions).where(actions.actionId == actionId));
 }
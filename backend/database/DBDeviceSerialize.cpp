@@ -1,16 +1,21 @@
 #include "DBDeviceSerialize.h"
 
+#include <algorithm>
 #include <chrono>
 
+#include <absl/container/flat_hash_map.h>
 #include <google/protobuf/wrappers.pb.h>
 #include <hinnant-date/include/date/tz.h>
+#include <sqlpp11/functions.h>
 #include <sqlpp11/insert.h>
 #include <sqlpp11/remove.h>
 #include <sqlpp11/select.h>
 #include <sqlpp11/transaction.h>
 #include <sqlpp11/update.h>
+#include <sqlpp11/value_list.h>
 
 #include "DevicesTable.h"
+#include "LikeEscape.h"
 
 #include "../utility/AnyJson.h"
 #include "../utility/RDPAlgorithm.h"
@@ -21,6 +26,7 @@ namespace
     constexpr DeviceGroupsTable deviceGroups;
     constexpr PropertiesTable propertiesTable;
     constexpr PropertiesLogTable propertiesLogTable;
+    constexpr DevicesGenerationTable devicesGeneration;
 
     template <typename T, typename Db>
     std::remove_reference_t<T> CommitAndReturn(T&& value, sqlpp::transaction_t<Db>& transaction)
@@ -28,18 +34,137 @@ namespace
         transaction.commit();
         return std::forward<T>(value);
     }
+
+    template <typename Field>
+    nlohmann::json ReadPropertyValue(const Field& value)
+    {
+        if (value.is_null())
+        {
+            return nullptr;
+        }
+        google::protobuf::Any any;
+        if (!any.ParseFromArray(value.blob, value.len))
+        {
+            throw std::runtime_error("DBDeviceSerialize: Invalid property blob data");
+        }
+        return UnpackAny(any);
+    }
+
+    template <typename Db>
+    int64_t ReadGeneration(Db& db)
+    {
+        auto result = db(select(devicesGeneration.generation).from(devicesGeneration).unconditionally());
+        return result.empty() ? 0 : result.front().generation.value();
+    }
+
+    // Properties without value are stored as empty Any in snapshots
+    nlohmann::json ReadSnapshotValue(const google::protobuf::Any& any)
+    {
+        if (any.type_url().empty())
+        {
+            return nullptr;
+        }
+        return UnpackAny(any);
+    }
+
+    // Only adds used conditions, so filtering by group can search the ids instead of scanning all devices
+    template <typename Query>
+    void AddFilterConditions(Query& query, const Filter& filter)
+    {
+        const std::string search = filter.getSearchString();
+        const std::string group = filter.getGroup();
+        if (!search.empty())
+        {
+            query.where.add(ContainsSearch(devices.deviceName, filter));
+        }
+        if (!group.empty())
+        {
+            query.where.add(devices.deviceId.in(
+                select(deviceGroups.deviceId).from(deviceGroups).where(deviceGroups.groupName == group)));
+        }
+    }
+
+    // Device row, until its groups and properties are loaded
+    struct DeviceRow
+    {
+        std::string m_name;
+        std::string m_icon;
+        std::vector<std::string> m_groups;
+        std::string m_type;
+        absl::flat_hash_map<std::string, nlohmann::json> m_values;
+        std::string m_api;
+    };
+
+    // Loads groups and properties of deviceRows with one join query each.
+    // makeCondition is called with the ids of deviceRows and returns the condition on devices for the join queries.
+    // Groups and properties of other devices matching the condition are ignored
+    template <typename Db, typename DeviceRows, typename MakeCondition>
+    std::vector<std::pair<DeviceId, Device::Data>> LoadDevices(
+        Db& db, const DeviceTypeRegistry& types, DeviceRows&& deviceRows, MakeCondition makeCondition)
+    {
+        std::vector<int64_t> ids;
+        absl::flat_hash_map<int64_t, DeviceRow> rows;
+        for (const auto& row : deviceRows)
+        {
+            if (!types.HasDeviceType(row.deviceType.value()))
+            {
+                continue;
+            }
+            ids.push_back(row.deviceId.value());
+            rows.emplace(row.deviceId.value(),
+                DeviceRow {row.deviceName, row.deviceIcon, {}, row.deviceType, {}, row.deviceApi});
+        }
+        if (ids.empty())
+        {
+            return {};
+        }
+        const auto condition = makeCondition(ids);
+        for (const auto& row : db(select(deviceGroups.deviceId, deviceGroups.groupName)
+                                      .from(deviceGroups.join(devices).on(deviceGroups.deviceId == devices.deviceId))
+                                      .where(condition)))
+        {
+            auto it = rows.find(row.deviceId.value());
+            if (it != rows.end())
+            {
+                it->second.m_groups.push_back(row.groupName);
+            }
+        }
+        for (const auto& row :
+            db(select(propertiesTable.deviceId, propertiesTable.propertyKey, propertiesTable.propertyValue)
+                    .from(propertiesTable.join(devices).on(propertiesTable.deviceId == devices.deviceId))
+                    .where(condition)))
+        {
+            auto it = rows.find(row.deviceId.value());
+            if (it != rows.end())
+            {
+                it->second.m_values.emplace(row.propertyKey, ReadPropertyValue(row.propertyValue));
+            }
+        }
+        std::vector<std::pair<DeviceId, Device::Data>> result;
+        result.reserve(ids.size());
+        for (int64_t id : ids)
+        {
+            DeviceRow& row = rows.at(id);
+            Properties properties = Properties::FromRawData(std::move(row.m_values), types.GetDeviceType(row.m_type));
+            result.emplace_back(DeviceId(id),
+                Device::Data {std::move(row.m_name), std::move(row.m_icon), std::move(row.m_groups),
+                    std::move(row.m_type), std::move(properties), std::move(row.m_api)});
+        }
+        return result;
+    }
 } // namespace
 
 absl::optional<Device::Data> DBDeviceSerialize::GetDeviceData(DeviceId deviceId, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetDeviceData(deviceId, {user, transaction}), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetDeviceData(deviceId, {user, transaction, *connection}), transaction);
 }
 
 absl::optional<Device::Data> DBDeviceSerialize::GetDeviceData(
     DeviceId deviceId, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     auto result = db(select(devices.deviceName, devices.deviceIcon, devices.deviceType, devices.deviceApi)
                          .from(devices)
                          .where(devices.deviceId == deviceId.GetValue()));
@@ -54,58 +179,99 @@ absl::optional<Device::Data> DBDeviceSerialize::GetDeviceData(
 
 DeviceId DBDeviceSerialize::AddDevice(const Device::Data& deviceData, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(AddDevice(deviceData, {user, transaction}), transaction);
+    return m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            return CommitAndReturn(AddDevice(deviceData, {user, transaction, db}), transaction);
+        })
+        .get();
 }
 DeviceId DBDeviceSerialize::AddDevice(const Device::Data& deviceData, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     uint64_t id
         = db(insert_into(devices).set(devices.deviceName = deviceData.m_name, devices.deviceIcon = deviceData.m_icon,
             devices.deviceApi = deviceData.m_api, devices.deviceType = deviceData.m_type));
     DeviceId deviceId(id);
+    InvalidateSnapshot(deviceId, deviceData.m_api);
     InsertDeviceGroups(deviceId, deviceData.m_groups, transaction);
     AddProperties(deviceId, deviceData.m_properties, transaction);
     return deviceId;
 }
 
-void DBDeviceSerialize::UpdateDevice(DeviceId id, const Device::Data& data, UserId user)
+void DBDeviceSerialize::UpdateDevice(DeviceId id, const Device::Data& data, Events::DeviceFields fields, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    UpdateDevice(id, data, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            UpdateDevice(id, data, fields, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBDeviceSerialize::UpdateDevice(DeviceId id, const Device::Data& data, const UserHeldTransaction& transaction)
+void DBDeviceSerialize::UpdateDevice(
+    DeviceId id, const Device::Data& data, Events::DeviceFields fields, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
-    auto result = db(select(devices.deviceId).from(devices).where(devices.deviceId == id.GetValue()));
-    if (!result.empty())
+    InvalidateSnapshot(id, data.m_api);
+    auto& db = transaction.GetDatabase();
+    auto result = db(select(devices.deviceName, devices.deviceIcon, devices.deviceApi, devices.deviceType)
+                         .from(devices)
+                         .where(devices.deviceId == id.GetValue()));
+    if (result.empty())
+    {
+        throw std::runtime_error("DBDeviceSerialize::UpdateDevice on non-existent device");
+    }
+    const bool all = fields == Events::DeviceFields::ALL;
+    const auto& row = result.front();
+    // Only set columns which changed
+    auto statement = dynamic_update(db, devices).dynamic_set().where(devices.deviceId == id.GetValue());
+    bool changed = false;
+    if ((all || fields == Events::DeviceFields::NAME) && row.deviceName.value() != data.m_name)
     {
-        db(remove_from(deviceGroups).where(deviceGroups.deviceId == id.GetValue()));
-        db(remove_from(propertiesTable).where(propertiesTable.deviceId == id.GetValue()));
-        db(update(devices)
-                .set(devices.deviceName = data.m_name, devices.deviceIcon = data.m_icon, devices.deviceApi = data.m_api,
-                    devices.deviceType = data.m_type)
-                .where(devices.deviceId == id.GetValue()));
-        AddProperties(id, data.m_properties, transaction);
-        InsertDeviceGroups(id, data.m_groups, transaction);
+        statement.assignments.add(devices.deviceName = data.m_name);
+        changed = true;
     }
-    else
+    if (all && row.deviceIcon.value() != data.m_icon)
     {
-        throw std::runtime_error("DBDeviceSerialize::UpdateDevice on non-existent device");
+        statement.assignments.add(devices.deviceIcon = data.m_icon);
+        changed = true;
+    }
+    if (all && row.deviceApi.value() != data.m_api)
+    {
+        statement.assignments.add(devices.deviceApi = data.m_api);
+        changed = true;
+    }
+    if (all && row.deviceType.value() != data.m_type)
+    {
+        statement.assignments.add(devices.deviceType = data.m_type);
+        changed = true;
+    }
+    if (changed)
+    {
+        db(statement);
+    }
+    if (all || fields == Events::DeviceFields::GROUPS)
+    {
+        UpdateDeviceGroups(id, data.m_groups, transaction);
+    }
+    if (all)
+    {
+        UpdateProperties(id, data.m_properties, transaction);
     }
 }
 
 std::vector<DeviceId> DBDeviceSerialize::GetAPIDeviceIds(absl::string_view apiId, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetAPIDeviceIds(apiId, {user, transaction}), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAPIDeviceIds(apiId, {user, transaction, *connection}), transaction);
 }
 
-std::vector<DeviceId> DBDeviceSerialize::GetAPIDeviceIds(absl::string_view apiId, const UserHeldTransaction&) const
+std::vector<DeviceId> DBDeviceSerialize::GetAPIDeviceIds(
+    absl::string_view apiId, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     std::string apiIdStr(apiId);
     auto result = db(select(devices.deviceId).from(devices).where(devices.deviceApi == apiIdStr));
     std::vector<DeviceId> ids;
@@ -118,14 +284,23 @@ std::vector<DeviceId> DBDeviceSerialize::GetAPIDeviceIds(absl::string_view apiId
 
 std::vector<DeviceId> DBDeviceSerialize::GetAllDeviceIds(const Filter& filter, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetAllDeviceIds(filter, {user, transaction}), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAllDeviceIds(filter, {user, transaction, *connection}), transaction);
 }
 
-std::vector<DeviceId> DBDeviceSerialize::GetAllDeviceIds(const Filter& filter, const UserHeldTransaction&) const
+std::vector<DeviceId> DBDeviceSerialize::GetAllDeviceIds(
+    const Filter& filter, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
-    auto result = db(select(devices.deviceId).from(devices).unconditionally());
+    auto& db = transaction.GetDatabase();
+    auto query = dynamic_select(db, devices.deviceId)
+                     .from(devices)
+                     .dynamic_where()
+                     .order_by(devices.deviceId.asc())
+                     .limit(filter.getQueryLimit())
+                     .offset(static_cast<uint64_t>(filter.getStartIndex()));
+    AddFilterConditions(query, filter);
+    auto result = db(query);
     std::vector<DeviceId> ids;
     for (const auto& row : result)
     {
@@ -134,15 +309,75 @@ std::vector<DeviceId> DBDeviceSerialize::GetAllDeviceIds(const Filter& filter, c
     return ids;
 }
 
+std::vector<std::pair<DeviceId, Device::Data>> DBDeviceSerialize::GetAPIDevices(
+    absl::string_view apiId, UserId user) const
+{
+    absl::optional<std::vector<std::pair<DeviceId, Device::Data>>> snapshotDevices = TakeSnapshotDevices(apiId);
+    if (snapshotDevices)
+    {
+        return std::move(snapshotDevices).value();
+    }
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAPIDevices(apiId, {user, transaction, *connection}), transaction);
+}
+
+std::vector<std::pair<DeviceId, Device::Data>> DBDeviceSerialize::GetAPIDevices(
+    absl::string_view apiId, const UserHeldTransaction& transaction) const
+{
+    auto& db = transaction.GetDatabase();
+    std::string apiIdStr(apiId);
+    return LoadDevices(db, m_deviceTypes,
+        db(select(all_of(devices)).from(devices).where(devices.deviceApi == apiIdStr).order_by(devices.deviceId.asc())),
+        [&](const std::vector<int64_t>&) { return devices.deviceApi == apiIdStr; });
+}
+
+std::vector<std::pair<DeviceId, Device::Data>> DBDeviceSerialize::GetAllDevices(
+    const Filter& filter, UserId user) const
+{
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAllDevices(filter, {user, transaction, *connection}), transaction);
+}
+
+std::vector<std::pair<DeviceId, Device::Data>> DBDeviceSerialize::GetAllDevices(
+    const Filter& filter, const UserHeldTransaction& transaction) const
+{
+    auto& db = transaction.GetDatabase();
+    auto query = dynamic_select(db, all_of(devices))
+                     .from(devices)
+                     .dynamic_where()
+                     .order_by(devices.deviceId.asc())
+                     .limit(filter.getQueryLimit())
+                     .offset(static_cast<uint64_t>(filter.getStartIndex()));
+    AddFilterConditions(query, filter);
+    if (filter.getSearchString().empty() && filter.getGroup().empty())
+    {
+        // Devices are ordered by id, so the page contains every device in its id range
+        return LoadDevices(db, m_deviceTypes, db(query), [](const std::vector<int64_t>& ids) {
+            return devices.deviceId >= ids.front() && devices.deviceId <= ids.back();
+        });
+    }
+    // Devices in the id range of a filtered page may not match the filter
+    return LoadDevices(db, m_deviceTypes, db(query),
+        [](const std::vector<int64_t>& ids) { return devices.deviceId.in(sqlpp::value_list(ids)); });
+}
+
 void DBDeviceSerialize::RemoveDevice(DeviceId deviceId, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    RemoveDevice(deviceId, {user, transaction});
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            RemoveDevice(deviceId, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBDeviceSerialize::RemoveDevice(DeviceId deviceId, const UserHeldTransaction&)
+void DBDeviceSerialize::RemoveDevice(DeviceId deviceId, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    InvalidateSnapshot(deviceId);
+    auto& db = transaction.GetDatabase();
     // Constraints take care of rest
     db(remove_from(devices).where(devices.deviceId == deviceId.GetValue()));
 }
@@ -150,15 +385,20 @@ void DBDeviceSerialize::RemoveDevice(DeviceId deviceId, const UserHeldTransactio
 void DBDeviceSerialize::SetDeviceProperty(
     DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    SetDeviceProperty(deviceId, propertyKey, properties, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            SetDeviceProperty(deviceId, propertyKey, properties, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBDeviceSerialize::SetDeviceProperty(
-    DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, const UserHeldTransaction&)
+void DBDeviceSerialize::SetDeviceProperty(DeviceId deviceId, absl::string_view propertyKey,
+    const Properties& properties, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    InvalidateSnapshot(deviceId);
+    auto& db = transaction.GetDatabase();
     std::string keyStr(propertyKey);
 
     const MetadataEntry& meta = properties.GetMetadataEntry(propertyKey);
@@ -184,15 +424,20 @@ void DBDeviceSerialize::SetDeviceProperty(
 void DBDeviceSerialize::InsertDeviceProperty(
     DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    InsertDeviceProperty(deviceId, propertyKey, properties, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            InsertDeviceProperty(deviceId, propertyKey, properties, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBDeviceSerialize::InsertDeviceProperty(
-    DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, const UserHeldTransaction&)
+void DBDeviceSerialize::InsertDeviceProperty(DeviceId deviceId, absl::string_view propertyKey,
+    const Properties& properties, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    InvalidateSnapshot(deviceId);
+    auto& db = transaction.GetDatabase();
     std::string keyStr(propertyKey);
 
     const MetadataEntry& meta = properties.GetMetadataEntry(propertyKey);
@@ -298,7 +543,9 @@ nlohmann::json DBDeviceSerialize::GetPropertyHistory(DeviceId deviceId, absl::st
     const std::chrono::system_clock::time_point& start, absl::optional<const std::chrono::system_clock::time_point> end,
     std::time_t compression, const Properties& properties, UserId user)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    // History queries can be slow, so they do not block the writer
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto& db = *connection;
 
     const int64_t devId = deviceId.GetValue();
     const std::string propertyStr = std::string(propertyKey);
@@ -332,15 +579,19 @@ nlohmann::json DBDeviceSerialize::GetPropertyHistory(DeviceId deviceId, absl::st
 void DBDeviceSerialize::LogDeviceProperty(
     DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    LogDeviceProperty(deviceId, propertyKey, properties, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            LogDeviceProperty(deviceId, propertyKey, properties, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBDeviceSerialize::LogDeviceProperty(
-    DeviceId deviceId, absl::string_view propertyKey, const Properties& properties, const UserHeldTransaction&)
+void DBDeviceSerialize::LogDeviceProperty(DeviceId deviceId, absl::string_view propertyKey,
+    const Properties& properties, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     std::string keyStr(propertyKey);
 
     const MetadataEntry& meta = properties.GetMetadataEntry(propertyKey);
@@ -369,10 +620,169 @@ void DBDeviceSerialize::LogDeviceProperty(
     db(preparedStatement);
 }
 
+void DBDeviceSerialize::SetDeviceProperties(
+    DeviceId deviceId, const std::vector<PropertyWrite>& writes, const Properties& properties, UserId user)
+{
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            SetDeviceProperties(deviceId, writes, properties, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
+}
+
+void DBDeviceSerialize::SetDeviceProperties(DeviceId deviceId, const std::vector<PropertyWrite>& writes,
+    const Properties& properties, const UserHeldTransaction& transaction)
+{
+    for (const PropertyWrite& write : writes)
+    {
+        if (write.insert)
+        {
+            InsertDeviceProperty(deviceId, write.key, properties, transaction);
+        }
+        else
+        {
+            SetDeviceProperty(deviceId, write.key, properties, transaction);
+        }
+        if (write.log)
+        {
+            LogDeviceProperty(deviceId, write.key, properties, transaction);
+        }
+    }
+}
+
+int64_t DBDeviceSerialize::GetGeneration() const
+{
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    return ReadGeneration(*connection);
+}
+
+messages::DeviceSnapshot DBDeviceSerialize::CreateSnapshot()
+{
+    // A single read transaction sees the generation and the devices of the same state, without blocking writes
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto& db = *connection;
+    auto transaction = sqlpp::start_transaction(db);
+    messages::DeviceSnapshot snapshot;
+    snapshot.set_generation(ReadGeneration(db));
+    absl::flat_hash_map<int64_t, messages::SnapshotDevice*> snapshotDevices;
+    for (const auto& row : db(select(all_of(devices)).from(devices).unconditionally().order_by(devices.deviceId.asc())))
+    {
+        messages::SnapshotDevice* device = snapshot.add_devices();
+        device->set_id(row.deviceId.value());
+        device->set_name(row.deviceName.value());
+        device->set_icon(row.deviceIcon.value());
+        device->set_type(row.deviceType.value());
+        device->set_api(row.deviceApi.value());
+        snapshotDevices.emplace(row.deviceId.value(), device);
+    }
+    for (const auto& row :
+        db(select(deviceGroups.deviceId, deviceGroups.groupName).from(deviceGroups).unconditionally()))
+    {
+        auto it = snapshotDevices.find(row.deviceId.value());
+        if (it != snapshotDevices.end())
+        {
+            it->second->add_groups(row.groupName.value());
+        }
+    }
+    for (const auto& row :
+        db(select(propertiesTable.deviceId, propertiesTable.propertyKey, propertiesTable.propertyValue)
+                .from(propertiesTable)
+                .unconditionally()))
+    {
+        auto it = snapshotDevices.find(row.deviceId.value());
+        if (it == snapshotDevices.end())
+        {
+            continue;
+        }
+        google::protobuf::Any& any = (*it->second->mutable_properties())[row.propertyKey.value()];
+        if (!row.propertyValue.is_null() && !any.ParseFromArray(row.propertyValue.blob, row.propertyValue.len))
+        {
+            throw std::runtime_error("DBDeviceSerialize: Invalid property blob data");
+        }
+    }
+    transaction.commit();
+    return snapshot;
+}
+
+void DBDeviceSerialize::SetSnapshot(const messages::DeviceSnapshot& snapshot)
+{
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    m_snapshotDevices.clear();
+    m_snapshotApis.clear();
+    for (const messages::SnapshotDevice& device : snapshot.devices())
+    {
+        m_snapshotDevices[device.api()].push_back(device);
+        m_snapshotApis.emplace(DeviceId(device.id()), device.api());
+    }
+}
+
+void DBDeviceSerialize::ClearSnapshot()
+{
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    m_snapshotDevices.clear();
+    m_snapshotApis.clear();
+}
+
+absl::optional<std::vector<std::pair<DeviceId, Device::Data>>> DBDeviceSerialize::TakeSnapshotDevices(
+    absl::string_view apiId) const
+{
+    std::vector<messages::SnapshotDevice> snapshotDevices;
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        auto it = m_snapshotDevices.find(std::string(apiId));
+        if (it == m_snapshotDevices.end())
+        {
+            return absl::nullopt;
+        }
+        snapshotDevices = std::move(it->second);
+        m_snapshotDevices.erase(it);
+    }
+    std::vector<std::pair<DeviceId, Device::Data>> result;
+    result.reserve(snapshotDevices.size());
+    for (const messages::SnapshotDevice& device : snapshotDevices)
+    {
+        // Same as loading from the database
+        if (!m_deviceTypes.HasDeviceType(device.type()))
+        {
+            continue;
+        }
+        absl::flat_hash_map<std::string, nlohmann::json> values;
+        for (const auto& property : device.properties())
+        {
+            values.emplace(property.first, ReadSnapshotValue(property.second));
+        }
+        result.emplace_back(DeviceId(device.id()),
+            Device::Data {device.name(), device.icon(),
+                std::vector<std::string>(device.groups().begin(), device.groups().end()), device.type(),
+                Properties::FromRawData(std::move(values), m_deviceTypes.GetDeviceType(device.type())), device.api()});
+    }
+    return result;
+}
+
+void DBDeviceSerialize::InvalidateSnapshot(DeviceId id, absl::string_view api)
+{
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    if (m_snapshotDevices.empty())
+    {
+        return;
+    }
+    auto it = m_snapshotApis.find(id);
+    if (it != m_snapshotApis.end())
+    {
+        m_snapshotDevices.erase(it->second);
+    }
+    if (!api.empty())
+    {
+        m_snapshotDevices.erase(std::string(api));
+    }
+}
+
 void DBDeviceSerialize::InsertDeviceGroups(
-    DeviceId id, const std::vector<std::string>& groups, const UserHeldTransaction&)
+    DeviceId id, const std::vector<std::string>& groups, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     auto preparedStatement = db.prepare(insert_into(deviceGroups)
                                             .set(deviceGroups.deviceId = id.GetValue(),
                                                 deviceGroups.groupName = sqlpp::parameter(deviceGroups.groupName)));
@@ -383,9 +793,10 @@ void DBDeviceSerialize::InsertDeviceGroups(
     }
 }
 
-void DBDeviceSerialize::AddProperties(DeviceId deviceId, const Properties& properties, const UserHeldTransaction&)
+void DBDeviceSerialize::AddProperties(
+    DeviceId deviceId, const Properties& properties, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     auto preparedStatement
         = db.prepare(insert_into(propertiesTable)
                          .set(propertiesTable.deviceId = deviceId.GetValue(),
@@ -409,9 +820,111 @@ void DBDeviceSerialize::AddProperties(DeviceId deviceId, const Properties& prope
     }
 }
 
-std::vector<std::string> DBDeviceSerialize::GetDeviceGroups(DeviceId deviceId, const UserHeldTransaction&) const
+void DBDeviceSerialize::UpdateDeviceGroups(
+    DeviceId id, const std::vector<std::string>& groups, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
+    std::vector<std::string> stored = GetDeviceGroups(id, transaction);
+    for (const std::string& group : stored)
+    {
+        if (std::find(groups.begin(), groups.end(), group) == groups.end())
+        {
+            db(remove_from(deviceGroups)
+                    .where(deviceGroups.deviceId == id.GetValue() && deviceGroups.groupName == group));
+        }
+    }
+    std::vector<std::string> added;
+    for (const std::string& group : groups)
+    {
+        if (std::find(stored.begin(), stored.end(), group) == stored.end())
+        {
+            added.push_back(group);
+        }
+    }
+    InsertDeviceGroups(id, added, transaction);
+}
+
+void DBDeviceSerialize::UpdateProperties(
+    DeviceId deviceId, const Properties& properties, const UserHeldTransaction& transaction)
+{
+    auto& db = transaction.GetDatabase();
+    // Serialized values of the stored properties, nullopt for null
+    absl::flat_hash_map<std::string, absl::optional<std::vector<uint8_t>>> stored;
+    for (const auto& row : db(select(propertiesTable.propertyKey, propertiesTable.propertyValue)
+                                  .from(propertiesTable)
+                                  .where(propertiesTable.deviceId == deviceId.GetValue())))
+    {
+        absl::optional<std::vector<uint8_t>> value;
+        if (!row.propertyValue.is_null())
+        {
+            value.emplace(row.propertyValue.blob, row.propertyValue.blob + row.propertyValue.len);
+        }
+        stored.emplace(row.propertyKey, std::move(value));
+    }
+
+    auto insertStatement
+        = db.prepare(insert_into(propertiesTable)
+                         .set(propertiesTable.deviceId = deviceId.GetValue(),
+                             propertiesTable.propertyKey = parameter(propertiesTable.propertyKey),
+                             propertiesTable.propertyValue = parameter(propertiesTable.propertyValue)));
+    auto updateStatement
+        = db.prepare(update(propertiesTable)
+                         .set(propertiesTable.propertyValue = parameter(propertiesTable.propertyValue))
+                         .where(propertiesTable.deviceId == deviceId.GetValue()
+                             && propertiesTable.propertyKey == parameter(propertiesTable.propertyKey)));
+    for (const auto& p : properties.GetAll())
+    {
+        absl::optional<std::vector<uint8_t>> value;
+        if (p.second != nullptr)
+        {
+            google::protobuf::Any any = JsonToAny(p.second);
+            value.emplace(any.ByteSize());
+            any.SerializeToArray(value->data(), value->size());
+        }
+        auto it = stored.find(p.first);
+        if (it == stored.end())
+        {
+            insertStatement.params.propertyKey = p.first;
+            if (value)
+            {
+                insertStatement.params.propertyValue = *value;
+            }
+            else
+            {
+                insertStatement.params.propertyValue.set_null();
+            }
+            db(insertStatement);
+        }
+        else
+        {
+            if (it->second != value)
+            {
+                updateStatement.params.propertyKey = p.first;
+                if (value)
+                {
+                    updateStatement.params.propertyValue = *value;
+                }
+                else
+                {
+                    updateStatement.params.propertyValue.set_null();
+                }
+                db(updateStatement);
+            }
+            stored.erase(it);
+        }
+    }
+    // Properties which no longer exist
+    for (const auto& p : stored)
+    {
+        db(remove_from(propertiesTable)
+                .where(propertiesTable.deviceId == deviceId.GetValue() && propertiesTable.propertyKey == p.first));
+    }
+}
+
+std::vector<std::string> DBDeviceSerialize::GetDeviceGroups(
+    DeviceId deviceId, const UserHeldTransaction& transaction) const
+{
+    auto& db = transaction.GetDatabase();
     auto result
         = db(select(deviceGroups.groupName).from(deviceGroups).where(deviceGroups.deviceId == deviceId.GetValue()));
     std::vector<std::string> groups;
@@ -423,30 +936,16 @@ std::vector<std::string> DBDeviceSerialize::GetDeviceGroups(DeviceId deviceId, c
 }
 
 Properties DBDeviceSerialize::GetDeviceProperties(
-    DeviceId deviceId, const DeviceType& type, const UserHeldTransaction&) const
+    DeviceId deviceId, const DeviceType& type, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     auto result = db(select(propertiesTable.propertyKey, propertiesTable.propertyValue)
                          .from(propertiesTable)
                          .where(propertiesTable.deviceId == deviceId.GetValue()));
     absl::flat_hash_map<std::string, nlohmann::json> values;
     for (const auto& row : result)
     {
-        nlohmann::json json;
-        if (row.propertyValue.is_null())
-        {
-            json = nullptr;
-        }
-        else
-        {
-            google::protobuf::Any any;
-            if (!any.ParseFromArray(row.propertyValue.blob, row.propertyValue.len))
-            {
-                throw std::runtime_error("DBDeviceSerialize::GetDeviceProperties: Invalid blob data");
-            }
-            json = UnpackAny(any);
-        }
-        values.emplace(row.propertyKey, std::move(json));
+        values.emplace(row.propertyKey, ReadPropertyValue(row.propertyValue));
     }
 
     return Properties::FromRawData(std::move(values), type);
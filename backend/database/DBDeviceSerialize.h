@@ -1,7 +1,12 @@
 #pragma once
 
+#include <mutex>
+
+#include <absl/container/flat_hash_map.h>
+
 #include "DBHandler.h"
 #include "HeldTransaction.h"
+#include "database/snapshot.pb.h"
 
 #include "../api/DeviceType.h"
 #include "../api/IDeviceSerialize.h"
@@ -19,14 +24,21 @@ public:
     // Adds a device, returns the id
     DeviceId AddDevice(const Device::Data& deviceData, UserId user) override;
     DeviceId AddDevice(const Device::Data& deviceData, const UserHeldTransaction&) override;
-    // Updates an existing device
-    void UpdateDevice(DeviceId id, const Device::Data& data, UserId user) override;
-    void UpdateDevice(DeviceId id, const Device::Data& data, const UserHeldTransaction&) override;
+    // Updates an existing device, only changed columns, groups and properties are written
+    void UpdateDevice(DeviceId id, const Device::Data& data, Events::DeviceFields fields, UserId user) override;
+    void UpdateDevice(
+        DeviceId id, const Device::Data& data, Events::DeviceFields fields, const UserHeldTransaction&) override;
 
     std::vector<DeviceId> GetAPIDeviceIds(absl::string_view apiId, UserId user) const override;
     std::vector<DeviceId> GetAPIDeviceIds(absl::string_view apiId, const UserHeldTransaction&) const override;
     std::vector<DeviceId> GetAllDeviceIds(const Filter& filter, UserId user) const override;
     std::vector<DeviceId> GetAllDeviceIds(const Filter& filter, const UserHeldTransaction&) const override;
+    std::vector<std::pair<DeviceId, Device::Data>> GetAPIDevices(absl::string_view apiId, UserId user) const override;
+    std::vector<std::pair<DeviceId, Device::Data>> GetAPIDevices(
+        absl::string_view apiId, const UserHeldTransaction&) const override;
+    std::vector<std::pair<DeviceId, Device::Data>> GetAllDevices(const Filter& filter, UserId user) const override;
+    std::vector<std::pair<DeviceId, Device::Data>> GetAllDevices(
+        const Filter& filter, const UserHeldTransaction&) const override;
     // Removes a device
     void RemoveDevice(DeviceId deviceId, UserId user) override;
     void RemoveDevice(DeviceId deviceId, const UserHeldTransaction&) override;
@@ -47,18 +59,47 @@ public:
     void LogDeviceProperty(DeviceId deviceId, absl::string_view propertyKey, const Properties& properties,
         const UserHeldTransaction&) override;
 
+    void SetDeviceProperties(DeviceId deviceId, const std::vector<PropertyWrite>& writes,
+        const Properties& properties, UserId user) override;
+    void SetDeviceProperties(DeviceId deviceId, const std::vector<PropertyWrite>& writes,
+        const Properties& properties, const UserHeldTransaction&) override;
+
     nlohmann::json GetPropertyHistory(DeviceId deviceId, absl::string_view propertyKey,
         const std::chrono::system_clock::time_point& start,
         absl::optional<const std::chrono::system_clock::time_point> end, std::time_t compression,
         const Properties& properties, UserId user) override;
 
+    // Returns the counter which is increased by every change of devices, groups or properties.
+    // Changes are only counted if DBConfig::m_deviceGeneration is set
+    int64_t GetGeneration() const;
+    // Returns all devices and the generation, read in one transaction
+    messages::DeviceSnapshot CreateSnapshot();
+    // GetAPIDevices returns the devices of an api from the snapshot once, instead of querying the database.
+    // The snapshot must have the current generation. Devices of an api which changed are loaded from the database
+    void SetSnapshot(const messages::DeviceSnapshot& snapshot);
+    // Releases the devices of the snapshot which were not loaded
+    void ClearSnapshot();
+
 private:
+    // Returns the devices of the api from the snapshot and removes them from it
+    absl::optional<std::vector<std::pair<DeviceId, Device::Data>>> TakeSnapshotDevices(absl::string_view apiId) const;
+    // Removes the api of the device and api from the snapshot, because they are changed
+    void InvalidateSnapshot(DeviceId id, absl::string_view api = absl::string_view());
     void InsertDeviceGroups(DeviceId id, const std::vector<std::string>& groups, const UserHeldTransaction&);
     void AddProperties(DeviceId deviceId, const Properties& properties, const UserHeldTransaction&);
+    // Removes and inserts groups which differ from the stored ones
+    void UpdateDeviceGroups(DeviceId id, const std::vector<std::string>& groups, const UserHeldTransaction&);
+    // Inserts, updates and removes only properties which differ from the stored ones, keeps their property_uid
+    void UpdateProperties(DeviceId deviceId, const Properties& properties, const UserHeldTransaction&);
     std::vector<std::string> GetDeviceGroups(DeviceId deviceId, const UserHeldTransaction&) const;
     Properties GetDeviceProperties(DeviceId deviceId, const DeviceType& meta, const UserHeldTransaction&) const;
 
 private:
     DBHandler& m_dbHandler;
     DeviceTypeRegistry& m_deviceTypes;
+    mutable std::mutex m_snapshotMutex;
+    // Devices of the snapshot by api
+    mutable absl::flat_hash_map<std::string, std::vector<messages::SnapshotDevice>> m_snapshotDevices;
+    // Api of each device in the snapshot
+    absl::flat_hash_map<DeviceId, std::string> m_snapshotApis;
 };
\ No newline at end of file
@@ -18,21 +18,80 @@ namespace
     constexpr UsersTable users;
 } // namespace
 
-DBHandler::DBHandler(const std::string& filename) : m_filename(filename), m_sqliteDatabase(filename, 5000) {}
+DBHandler::DBHandler(const std::string& filename, const DBConfig& config)
+    : m_filename(filename),
+      m_sqliteDatabase(filename, config.m_busyTimeout, false, config.m_pragmas),
+      m_migrations(GetDatabaseMigrations()),
+      m_deviceGeneration(config.m_deviceGeneration)
+{
+    // Every connection to an in memory database opens a new, empty database
+    const bool inMemory
+        = filename.empty() || filename == ":memory:" || filename.find("mode=memory") != std::string::npos;
+    if (!inMemory)
+    {
+        // Reads on the writing connection would deadlock with a write waited for while reading
+        m_readPool = std::make_unique<ConnectionPool>(filename, config.m_busyTimeout,
+            std::max<std::size_t>(config.m_readConnections, 1), config.m_pragmas);
+    }
+}
+
+DBHandler::~DBHandler()
+{
+    // Queued backfill chunks return immediately, so m_writer does not wait for the whole backfill
+    m_stopping = true;
+}
+
+DBHandler::ReadConnection DBHandler::GetReadConnection()
+{
+    if (m_readPool == nullptr)
+    {
+        return ReadConnection(m_sqliteDatabase, std::unique_lock<std::recursive_mutex>(m_mutex));
+    }
+    return m_readPool->Acquire();
+}
 
 void DBHandler::CreateTables(const Authenticator& authenticator)
 {
+    // Runs before the writer thread is used, reads without pool must still wait
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     auto& db = m_sqliteDatabase.GetDatabase();
+    const bool created = !SchemaMigrations::HasTable(db, "devices");
+    if (!created)
+    {
+        // Before creating new tables, which may depend on the migrated schema
+        m_migrations.Migrate(db);
+    }
     auto transaction = sqlpp::start_transaction(db);
 
     db.execute(ActionsTable::createStatement);
     db.execute(SubActionsTable::createStatement);
+    db.execute(SubActionsTable::createIndexStatement);
     db.execute(DevicesTable::createStatement);
+    db.execute(DevicesTable::createIndexStatement);
     db.execute(DeviceGroupsTable::createStatement);
+    db.execute(DeviceGroupsTable::createIndexStatement);
     db.execute(PropertiesTable::createStatement);
     db.execute(PropertiesLogTable::createStatement);
+    db.execute(DevicesGenerationTable::createStatement);
+    db.execute(DevicesGenerationTable::insertStatement);
+    for (const char* table : {"devices", "device_groups", "properties"})
+    {
+        for (const char* operation : {"insert", "update", "delete"})
+        {
+            // The triggers add an update to every property write, so they only exist while snapshots are used
+            db.execute(m_deviceGeneration ? DevicesGenerationTable::CreateTriggerStatement(table, operation)
+                                          : DevicesGenerationTable::DropTriggerStatement(table, operation));
+        }
+    }
+    if (!m_deviceGeneration)
+    {
+        // Changes are not counted from now on, so a snapshot written before is never valid again
+        db.execute(DevicesGenerationTable::incrementStatement);
+    }
     db.execute(RuleConditionsTable::createStatement);
     db.execute(RulesTable::createStatement);
+    db.execute(RulesTable::createConditionIndexStatement);
+    db.execute(RulesTable::createActionIndexStatement);
     db.execute(UsersTable::createStatement);
 
     auto result = db(select(users.userId).from(users).unconditionally().limit(1u));
@@ -51,4 +110,46 @@ void DBHandler::CreateTables(const Authenticator& authenticator)
     }
 
     transaction.commit();
+    if (created)
+    {
+        m_migrations.SetLatestVersion(db);
+    }
+    QueueBackfillChunk();
+}
+
+void DBHandler::QueueBackfillChunk()
+{
+    m_writer.Send([this] {
+        if (m_stopping)
+        {
+            return;
+        }
+        try
+        {
+            auto progress = [this](const Migration& migration, int64_t done, int64_t total) {
+                ReportBackfillProgress(migration, done, total);
+            };
+            std::unique_lock<std::recursive_mutex> lock(m_mutex);
+            if (m_migrations.RunBackfillChunk(GetDatabase(), progress))
+            {
+                QueueBackfillChunk();
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Res::Logger().Error("DBHandler", std::string("Backfill failed: ") + e.what());
+        }
+    });
+}
+
+void DBHandler::ReportBackfillProgress(const Migration& migration, int64_t done, int64_t total)
+{
+    const int64_t percent = total > 0 ? done * 100 / total : 100;
+    if (percent == m_backfillPercent)
+    {
+        return;
+    }
+    m_backfillPercent = percent == 100 ? -1 : percent;
+    Res::Logger().Info("DBHandler",
+        "Backfill of version " + std::to_string(migration.m_version) + ": " + std::to_string(percent) + "%");
 }
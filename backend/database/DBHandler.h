@@ -1,7 +1,9 @@
 #ifndef _DB_HANDLER_H
 #define _DB_HANDLER_H
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -11,10 +13,13 @@
 #include <absl/types/variant.h>
 #include <sqlpp11/select.h>
 
+#include "ConnectionPool.h"
 #include "SQLiteDatabase.h"
+#include "SchemaMigrations.h"
 
 #include "../api/Resources.h"
 #include "../communication/Authenticator.h"
+#include "../utility/Active.h"
 #include "../utility/Logger.h"
 
 class DBValue
@@ -62,24 +67,90 @@ private:
     absl::variant<int, int64_t, std::string, std::vector<uint8_t>> m_value;
 };
 
+struct DBConfig
+{
+    // Milliseconds a connection waits for a lock held by another connection
+    int m_busyTimeout = 5000;
+    // Maximum number of read only connections, file databases use at least one
+    std::size_t m_readConnections = 4;
+    // Count changes of devices in devices_generation, only needed for device snapshots
+    bool m_deviceGeneration = false;
+    SqlitePragmas m_pragmas;
+};
+
 class DBHandler
 {
 public:
     using DatabaseConnection = sqlpp::sqlite3::connection;
     using Transaction = sqlpp::transaction_t<DatabaseConnection>;
+    // Only in memory databases share the writing connection with reads. Such a lease blocks all writes until it is
+    // destroyed, so the thread holding it must not wait for a write
+    using ReadConnection = ConnectionPool::Lease;
 
     // Creates an DBHandler by the arguments
-    explicit DBHandler(const std::string& filename);
+    explicit DBHandler(const std::string& filename, const DBConfig& config = DBConfig());
+    // Unfinished backfills continue on the next start
+    ~DBHandler();
 
+    // Creates the tables of a new database or migrates an existing one.
+    // Backfills of the migrations run in the background between other writes
     void CreateTables(const Authenticator& authenticator);
 
-    DatabaseConnection& GetDatabase() { return m_sqliteDatabase.GetDatabase(); }
+    // The only connection which writes to the database, only used on the writer thread (see Write)
+    DatabaseConnection& GetDatabase()
+    {
+        assert(m_writer.IsActiveThread());
+        return m_sqliteDatabase.GetDatabase();
+    }
+    // Returns a read only connection, blocks while all are in use.
+    // Reads run in parallel to the writer, but do not see its uncommitted changes.
+    // In memory databases return the writing connection, see ReadConnection
+    ReadConnection GetReadConnection();
+
+    // Queues f to be called with the writing connection on the writer thread.
+    // Writes are executed in order, the returned future holds the result or exception of f.
+    // Called on the writer thread, f is executed immediately
+    template <typename F>
+    auto Write(F&& f) -> std::future<std::result_of_t<std::decay_t<F>&(DatabaseConnection&)>>
+    {
+        using Result = std::result_of_t<std::decay_t<F>&(DatabaseConnection&)>;
+        auto task = std::make_shared<std::packaged_task<Result()>>([this, f = std::forward<F>(f)]() mutable {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            return f(GetDatabase());
+        });
+        std::future<Result> result = task->get_future();
+        if (m_writer.IsActiveThread())
+        {
+            (*task)();
+        }
+        else
+        {
+            m_writer.Send([task] { (*task)(); });
+        }
+        return result;
+    }
+
+protected:
+    // Executes one backfill chunk on the writer thread and queues the next one
+    void QueueBackfillChunk();
+    void ReportBackfillProgress(const Migration& migration, int64_t done, int64_t total);
 
 protected:
     // The filename of the database
     std::string m_filename;
     SqliteDatabase m_sqliteDatabase;
-    mutable std::recursive_mutex m_mutex;
+    // nullptr if the database is in memory
+    std::unique_ptr<ConnectionPool> m_readPool;
+    // Locked while the writing connection is used, reads share it if there is no m_readPool
+    std::recursive_mutex m_mutex;
+    SchemaMigrations m_migrations;
+    // See DBConfig::m_deviceGeneration
+    bool m_deviceGeneration;
+    std::atomic<bool> m_stopping {false};
+    // Last reported percentage of the running backfill, only used on the writer thread
+    int64_t m_backfillPercent = -1;
+    // Declared last, so queued writes finish before the connections are closed
+    Active m_writer;
 };
 
 template <typename Table, typename... Columns>
@@ -1,10 +1,13 @@
 #include "DBRuleSerialize.h"
 
+#include <sqlpp11/functions.h>
 #include <sqlpp11/insert.h>
 #include <sqlpp11/remove.h>
 #include <sqlpp11/select.h>
 #include <sqlpp11/update.h>
 
+#include "LikeEscape.h"
+
 namespace
 {
     constexpr RulesTable rules;
@@ -19,13 +22,14 @@ namespace
 
 absl::optional<Rule> DBRuleSerialize::GetRule(uint64_t ruleId, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetRule(ruleId, {user, transaction}), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetRule(ruleId, {user, transaction, *connection}), transaction);
 }
 
 absl::optional<Rule> DBRuleSerialize::GetRule(uint64_t ruleId, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
 
     std::vector<Rule> result = GetRulesFromQuery(db,
         db(select(rules.ruleId, rules.ruleName, rules.ruleIconName, rules.ruleColor, rules.conditionId, rules.actionId,
@@ -47,31 +51,40 @@ absl::optional<Rule> DBRuleSerialize::GetRule(uint64_t ruleId, const UserHeldTra
 
 std::vector<Rule> DBRuleSerialize::GetAllRules(const Filter& filter, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetAllRules(filter, {user, transaction}), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetAllRules(filter, {user, transaction, *connection}), transaction);
 }
 
 std::vector<Rule> DBRuleSerialize::GetAllRules(const Filter& filter, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
+    const std::string search = filter.getSearchString();
     return GetRulesFromQuery(db,
         db(select(rules.ruleId, rules.ruleName, rules.ruleIconName, rules.ruleColor, rules.conditionId, rules.actionId,
             rules.ruleEnabled)
                 .from(rules)
-                .unconditionally()),
+                .where(sqlpp::value(search.empty()) or ContainsSearch(rules.ruleName, filter))
+                .order_by(rules.ruleId.asc())
+                .limit(filter.getQueryLimit())
+                .offset(static_cast<uint64_t>(filter.getStartIndex()))),
         transaction);
 }
 
 void DBRuleSerialize::AddRule(Rule& rule, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    AddRule(rule, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            AddRule(rule, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
 void DBRuleSerialize::AddRule(Rule& rule, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     m_rulePermissions.VerifyGeneralPermission(RulePermissions::Permission::addRule, transaction.GetUser());
     int64_t ruleId = 0;
 
@@ -99,9 +112,13 @@ void DBRuleSerialize::AddRule(Rule& rule, const UserHeldTransaction& transaction
 
 void DBRuleSerialize::UpdateRule(Rule& rule, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    UpdateRule(rule, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            UpdateRule(rule, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
 void DBRuleSerialize::UpdateRule(Rule& rule, const UserHeldTransaction& transaction)
@@ -112,13 +129,17 @@ void DBRuleSerialize::UpdateRule(Rule& rule, const UserHeldTransaction& transact
 
 uint64_t DBRuleSerialize::AddRuleOnly(const Rule& rule, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(AddRuleOnly(rule, {user, transaction}), transaction);
+    return m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            return CommitAndReturn(AddRuleOnly(rule, {user, transaction, db}), transaction);
+        })
+        .get();
 }
 
 uint64_t DBRuleSerialize::AddRuleOnly(const Rule& rule, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     int64_t ruleId = rule.GetId();
     bool ruleExists = ruleId != 0;
 	if (ruleExists) {
@@ -154,9 +175,13 @@ uint64_t DBRuleSerialize::AddRuleOnly(const Rule& rule, const UserHeldTransactio
 
 void DBRuleSerialize::RemoveRule(uint64_t ruleId, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    RemoveRule(ruleId, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            RemoveRule(ruleId, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
 void DBRuleSerialize::RemoveRule(uint64_t ruleId, const UserHeldTransaction& transaction)
@@ -174,14 +199,18 @@ void DBRuleSerialize::RemoveRule(uint64_t ruleId, const UserHeldTransaction& tra
 
 void DBRuleSerialize::RemoveRule(const Rule& rule, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    RemoveRule(rule, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            RemoveRule(rule, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
 void DBRuleSerialize::RemoveRule(const Rule& rule, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     // requires transaction
 
     // Delete the rule first, then the condition and effect because of constraints
@@ -214,10 +243,13 @@ std::vector<Rule> DBRuleSerialize::GetRulesFromQuery(
 
 void DBRuleConditionSerialize::AddRuleCondition(RuleConditions::RuleCondition& condition, UserId user)
 {
-
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    AddRuleCondition(condition, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            AddRuleCondition(condition, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
 void DBRuleConditionSerialize::AddRuleCondition(
@@ -230,14 +262,15 @@ void DBRuleConditionSerialize::AddRuleCondition(
 
 RuleConditions::Ptr DBRuleConditionSerialize::GetRuleCondition(uint64_t conditionId, UserId user) const
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    return CommitAndReturn(GetRuleCondition(conditionId, {user, transaction}), transaction);
+    DBHandler::ReadConnection connection = m_dbHandler.GetReadConnection();
+    auto transaction = sqlpp::start_transaction(*connection);
+    return CommitAndReturn(GetRuleCondition(conditionId, {user, transaction, *connection}), transaction);
 }
 
 RuleConditions::Ptr DBRuleConditionSerialize::GetRuleCondition(
     uint64_t conditionId, const UserHeldTransaction& transaction) const
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
 
     RuleConditions::Ptr result;
     {
@@ -261,14 +294,19 @@ RuleConditions::Ptr DBRuleConditionSerialize::GetRuleCondition(
 
 void DBRuleConditionSerialize::InsertRuleCondition(RuleConditions::RuleCondition& condition, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    InsertRuleCondition(condition, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            InsertRuleCondition(condition, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
-void DBRuleConditionSerialize::InsertRuleCondition(RuleConditions::RuleCondition& condition, const UserHeldTransaction&)
+void DBRuleConditionSerialize::InsertRuleCondition(
+    RuleConditions::RuleCondition& condition, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
 
     {
         auto insertStatement
@@ -315,15 +353,19 @@ void DBRuleConditionSerialize::InsertRuleCondition(RuleConditions::RuleCondition
 
 void DBRuleConditionSerialize::RemoveRuleCondition(const RuleConditions::RuleCondition& condition, UserId user)
 {
-    auto transaction = sqlpp::start_transaction(m_dbHandler.GetDatabase());
-    RemoveRuleCondition(condition, {user, transaction});
-    transaction.commit();
+    m_dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            auto transaction = sqlpp::start_transaction(db);
+            RemoveRuleCondition(condition, {user, transaction, db});
+            transaction.commit();
+        })
+        .get();
 }
 
 void DBRuleConditionSerialize::RemoveRuleCondition(
-    const RuleConditions::RuleCondition& condition, const UserHeldTransaction&)
+    const RuleConditions::RuleCondition& condition, const UserHeldTransaction& transaction)
 {
-    auto& db = m_dbHandler.GetDatabase();
+    auto& db = transaction.GetDatabase();
     {
         auto remove = db.prepare(
             remove_from(ruleConditions).where(ruleConditions.conditionId == parameter(ruleConditions.conditionId)));
@@ -0,0 +1,86 @@
+#include "DeviceSnapshot.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../api/Resources.h"
+#include "../utility/Logger.h"
+
+constexpr uint32_t DeviceSnapshot::s_format;
+
+namespace
+{
+    // Parses the whole file in one pass
+    bool ParseFile(const std::string& filename, messages::DeviceSnapshot& snapshot)
+    {
+#ifndef _MSC_VER
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        bool parsed = false;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            // Mapping avoids copying the file into a buffer before parsing
+            void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                parsed = snapshot.ParseFromArray(data, static_cast<int>(info.st_size));
+                munmap(data, info.st_size);
+            }
+        }
+        close(fd);
+        return parsed;
+#else
+        std::ifstream file(filename, std::ios::binary);
+        return file && snapshot.ParseFromIstream(&file);
+#endif
+    }
+} // namespace
+
+void DeviceSnapshot::Write(messages::DeviceSnapshot snapshot) const
+{
+    snapshot.set_format(s_format);
+    const std::string tmpFilename = m_filename + ".tmp";
+    {
+        std::ofstream file(tmpFilename, std::ios::binary | std::ios::trunc);
+        if (!file || !snapshot.SerializeToOstream(&file) || !file.flush())
+        {
+            std::remove(tmpFilename.c_str());
+            throw std::runtime_error("DeviceSnapshot: Failed to write " + tmpFilename);
+        }
+    }
+    // Readers either see the old or the new snapshot
+    if (std::rename(tmpFilename.c_str(), m_filename.c_str()) != 0)
+    {
+        std::remove(tmpFilename.c_str());
+        throw std::runtime_error("DeviceSnapshot: Failed to replace " + m_filename);
+    }
+}
+
+absl::optional<messages::DeviceSnapshot> DeviceSnapshot::Read(int64_t generation) const
+{
+    messages::DeviceSnapshot snapshot;
+    if (!ParseFile(m_filename, snapshot))
+    {
+        return absl::nullopt;
+    }
+    if (snapshot.format() != s_format || snapshot.generation() != generation)
+    {
+        Res::Logger().Info("DeviceSnapshot",
+            "Snapshot of generation " + std::to_string(snapshot.generation()) + " is outdated, database is at "
+                + std::to_string(generation));
+        return absl::nullopt;
+    }
+    return snapshot;
+}
\ No newline at end of file
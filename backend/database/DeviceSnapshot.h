@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <absl/types/optional.h>
+
+#include "database/snapshot.pb.h"
+
+// Binary file with the state of all devices, which is loaded at startup instead of querying the database.
+// A snapshot is only valid while the database has the generation it was created at
+class DeviceSnapshot
+{
+public:
+    // Increased when the meaning of the stored fields changes
+    static constexpr uint32_t s_format = 1;
+
+public:
+    explicit DeviceSnapshot(std::string filename) : m_filename(std::move(filename)) {}
+
+    const std::string& GetFilename() const { return m_filename; }
+    // Replaces the file, a failed write keeps the previous snapshot.
+    // Throws std::runtime_error if the file could not be written
+    void Write(messages::DeviceSnapshot snapshot) const;
+    // Returns nullopt if there is no valid snapshot for the generation
+    absl::optional<messages::DeviceSnapshot> Read(int64_t generation) const;
+
+private:
+    std::string m_filename;
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include <sqlpp11/char_sequence.h>
 #include <sqlpp11/data_types.h>
 #include <sqlpp11/table.h>
@@ -107,6 +109,9 @@ struct DevicesTable : sqlpp::table_t<DevicesTable, Devices_::DeviceId, Devices_:
         = "CREATE TABLE IF NOT EXISTS devices(device_id INTEGER PRIMARY KEY NOT NULL, "
           "device_name VARCHAR NOT NULL, device_icon VARCHAR NOT NULL, device_api VARCHAR NOT NULL, device_type "
           "VARCHAR NOT NULL);";
+    // Used to get the devices of an api
+    static constexpr const char* createIndexStatement
+        = "CREATE INDEX IF NOT EXISTS devices_device_api ON devices(device_api);";
 };
 
 namespace DeviceGroups_
@@ -160,9 +165,12 @@ struct DeviceGroupsTable : sqlpp::table_t<DeviceGroupsTable, DeviceGroups_::Devi
         };
     };
     static constexpr const char* createStatement
-        = "CREATE TABLE IF NOT EXISTS device_groups(device_id INTEGER PRIMARY KEY NOT NULL REFERENCES "
+        = "CREATE TABLE IF NOT EXISTS device_groups(device_id INTEGER NOT NULL REFERENCES "
           "devices(device_id) ON DELETE "
-          "CASCADE, group_name VARCHAR NOT NULL, UNIQUE(device_id, group_name));";
+          "CASCADE, group_name VARCHAR NOT NULL, PRIMARY KEY(device_id, group_name));";
+    // Used to filter devices by group
+    static constexpr const char* createIndexStatement
+        = "CREATE INDEX IF NOT EXISTS device_groups_group_name ON device_groups(group_name, device_id);";
 };
 
 namespace Properties_
@@ -294,3 +302,56 @@ struct PropertiesLogTable : sqlpp::table_t<PropertiesLogTable, Properties_::Devi
                                                    "property_date DATETIME NOT NULL,"
                                                    "UNIQUE(device_id, property_key, property_date));";
 };
+
+namespace DevicesGeneration_
+{
+    struct Generation
+    {
+        struct _alias_t
+        {
+            static constexpr const char _literal[] = "generation";
+            using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+            template <typename T>
+            struct _member_t
+            {
+                T generation;
+                T& operator()() { return generation; }
+                const T& operator()() const { return generation; }
+            };
+        };
+        using _traits = sqlpp::make_traits<sqlpp::integer, sqlpp::tag::require_insert>;
+    };
+} // namespace DevicesGeneration_
+
+// Single row with a counter which is increased by triggers on every change of devices, groups or properties
+struct DevicesGenerationTable : sqlpp::table_t<DevicesGenerationTable, DevicesGeneration_::Generation>
+{
+    struct _alias_t
+    {
+        static constexpr const char _literal[] = "devices_generation";
+        using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+        template <typename T>
+        struct _member_t
+        {
+            T devicesGeneration;
+            T& operator()() { return devicesGeneration; }
+            const T& operator()() const { return devicesGeneration; }
+        };
+    };
+    static constexpr const char* createStatement
+        = "CREATE TABLE IF NOT EXISTS devices_generation(id INTEGER PRIMARY KEY NOT NULL CHECK(id = 0), "
+          "generation INTEGER NOT NULL);";
+    static constexpr const char* insertStatement
+        = "INSERT OR IGNORE INTO devices_generation(id, generation) VALUES(0, 0);";
+    // operation is insert, update or delete
+    static std::string CreateTriggerStatement(const std::string& table, const std::string& operation)
+    {
+        return "CREATE TRIGGER IF NOT EXISTS " + table + "_" + operation + "_generation AFTER " + operation + " ON "
+            + table + " BEGIN UPDATE devices_generation SET generation = generation + 1; END;";
+    }
+    static std::string DropTriggerStatement(const std::string& table, const std::string& operation)
+    {
+        return "DROP TRIGGER IF EXISTS " + table + "_" + operation + "_generation;";
+    }
+    static constexpr const char* incrementStatement = "UPDATE devices_generation SET generation = generation + 1;";
+};
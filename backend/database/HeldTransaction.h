@@ -2,6 +2,7 @@
 
 #include <type_traits>
 
+#include <sqlpp11/sqlite3/connection.h>
 #include <sqlpp11/transaction.h>
 #include "../api/User.h"
 
@@ -25,13 +26,18 @@ public:
 class UserHeldTransaction
 {
 public:
+    // db is the connection the transaction was started on
     template <typename T, typename Enable = std::enable_if_t<IsTransaction<T>::value>>
-    UserHeldTransaction(UserId user, T& transaction) : m_user(user), m_transaction(transaction)
+    UserHeldTransaction(UserId user, T& transaction, sqlpp::sqlite3::connection& db)
+        : m_user(user), m_transaction(transaction), m_db(&db)
     {}
     const HeldTransaction& GetTransaction() const { return m_transaction; }
     UserId GetUser() const { return m_user; }
+    // Statements of the transaction have to run on this connection
+    sqlpp::sqlite3::connection& GetDatabase() const { return *m_db; }
 
 private:
     UserId m_user;
     HeldTransaction m_transaction;
+    sqlpp::sqlite3::connection* m_db;
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+
+#include <sqlpp11/char_sequence.h>
+#include <sqlpp11/like.h>
+#include <sqlpp11/wrap_operand.h>
+
+#include "../api/Filter.h"
+
+namespace sqlpp
+{
+    // operand LIKE(pattern) ESCAPE 'escape', sqlpp11 has no ESCAPE clause for like
+    template <typename Operand, typename Pattern>
+    struct like_escape_t : public expression_operators<like_escape_t<Operand, Pattern>, boolean>,
+                           public alias_operators<like_escape_t<Operand, Pattern>>
+    {
+        using _traits = make_traits<boolean, tag::is_expression, tag::is_selectable>;
+        using _nodes = detail::type_vector<Operand, Pattern>;
+
+        struct _alias_t
+        {
+            static constexpr const char _literal[] = "like_escape_";
+            using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+            template <typename T>
+            struct _member_t
+            {
+                T like_escape;
+                T& operator()() { return like_escape; }
+                const T& operator()() const { return like_escape; }
+            };
+        };
+
+        like_escape_t(Operand operand, Pattern pattern, char escape)
+            : _operand(operand), _pattern(pattern), _escape(escape)
+        {}
+
+        like_escape_t(const like_escape_t&) = default;
+        like_escape_t(like_escape_t&&) = default;
+        like_escape_t& operator=(const like_escape_t&) = default;
+        like_escape_t& operator=(like_escape_t&&) = default;
+        ~like_escape_t() = default;
+
+        Operand _operand;
+        Pattern _pattern;
+        char _escape;
+    };
+
+    template <typename Context, typename Operand, typename Pattern>
+    struct serializer_t<Context, like_escape_t<Operand, Pattern>>
+    {
+        using _serialize_check = serialize_check_of<Context, Operand, Pattern>;
+        using T = like_escape_t<Operand, Pattern>;
+
+        static Context& _(const T& t, Context& context)
+        {
+            serialize(t._operand, context);
+            context << " LIKE(";
+            serialize(t._pattern, context);
+            // Only used with '\\' or other characters which need no quoting
+            context << ") ESCAPE '" << t._escape << "'";
+            return context;
+        }
+    };
+} // namespace sqlpp
+
+// Condition which is true if the text column contains the search string of filter
+template <typename Column>
+sqlpp::like_escape_t<Column, sqlpp::wrap_operand_t<std::string>> ContainsSearch(
+    const Column& column, const Filter& filter)
+{
+    return sqlpp::like_escape_t<Column, sqlpp::wrap_operand_t<std::string>>(
+        column, sqlpp::wrap_operand_t<std::string>(filter.getSearchPattern()), Filter::s_likeEscape);
+}
\ No newline at end of file
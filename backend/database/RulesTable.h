@@ -139,6 +139,11 @@ struct RulesTable : sqlpp::table_t<RulesTable, Rules_::RuleId, Rules_::RuleName,
         = "CREATE TABLE IF NOT EXISTS rules(rule_id INTEGER PRIMARY KEY NOT NULL, rule_name VARCHAR, rule_icon_name VARCHAR, "
           "rule_color INTEGER, condition_id INTEGER REFERENCES rule_conditions(condition_id) ON DELETE SET NULL, "
           "action_id INTEGER REFERENCES actions(action_id) ON DELETE SET NULL, rule_enabled INTEGER DEFAULT 1);";
+    // Used to find the rules referencing a condition or action when it is deleted
+    static constexpr const char* createConditionIndexStatement
+        = "CREATE INDEX IF NOT EXISTS rules_condition_id ON rules(condition_id);";
+    static constexpr const char* createActionIndexStatement
+        = "CREATE INDEX IF NOT EXISTS rules_action_id ON rules(action_id);";
 };
 namespace RuleConditions_
 {
@@ -1,11 +1,43 @@
 #include "SQLiteDatabase.h"
 
+#include <stdexcept>
+
 namespace sql = sqlpp::sqlite3;
 
-SqliteDatabase::SqliteDatabase(const std::string& filename, int busyTimeout, bool readOnly)
+namespace
+{
+    // Unlike connection::execute, this also works for pragmas which return a row
+    void ExecutePragma(sqlite3* db, const std::string& pragma)
+    {
+        char* error = nullptr;
+        if (sqlite3_exec(db, pragma.c_str(), nullptr, nullptr, &error) != SQLITE_OK)
+        {
+            std::string message = "SqliteDatabase: " + pragma + " failed: " + (error ? error : "unknown error");
+            sqlite3_free(error);
+            throw std::runtime_error(message);
+        }
+    }
+} // namespace
+
+SqliteDatabase::SqliteDatabase(
+    const std::string& filename, int busyTimeout, bool readOnly, const SqlitePragmas& pragmas)
     : m_database(sql::connection_config(
           filename, readOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)))
 {
-    sqlite3_busy_timeout(m_database.native_handle(), busyTimeout);
+    if (pragmas.m_synchronous != "OFF" && pragmas.m_synchronous != "NORMAL" && pragmas.m_synchronous != "FULL"
+        && pragmas.m_synchronous != "EXTRA")
+    {
+        throw std::invalid_argument("SqliteDatabase: Invalid synchronous mode: " + pragmas.m_synchronous);
+    }
+    sqlite3* db = m_database.native_handle();
+    sqlite3_busy_timeout(db, busyTimeout);
     m_database.execute("PRAGMA foreign_keys = ON;");
+    // The journal mode is stored in the database file, so only the writer can change it
+    if (pragmas.m_wal && !readOnly)
+    {
+        ExecutePragma(db, "PRAGMA journal_mode = WAL;");
+    }
+    ExecutePragma(db, "PRAGMA synchronous = " + pragmas.m_synchronous + ";");
+    ExecutePragma(db, "PRAGMA cache_size = " + std::to_string(pragmas.m_cacheSize) + ";");
+    ExecutePragma(db, "PRAGMA mmap_size = " + std::to_string(pragmas.m_mmapSize) + ";");
 }
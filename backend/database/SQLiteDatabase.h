@@ -1,13 +1,30 @@
 #ifndef SQLITE_DATABASE_H
 #define SQLITE_DATABASE_H
 
+#include <cstdint>
+#include <string>
+
 #include <sqlite3.h>
 #include <sqlpp11/sqlite3/connection.h>
 
+// Pragmas applied to every connection, see https://www.sqlite.org/pragma.html
+struct SqlitePragmas
+{
+    // Write ahead log, allows reading connections in parallel to the writer
+    bool m_wal = true;
+    // OFF, NORMAL, FULL or EXTRA. NORMAL is safe with the write ahead log
+    std::string m_synchronous = "NORMAL";
+    // Page cache size per connection, negative values are in KiB
+    int64_t m_cacheSize = -2000;
+    // Maximum bytes of the database file accessed through memory mapping, 0 disables it
+    int64_t m_mmapSize = 0;
+};
+
 class SqliteDatabase
 {
 public:
-    SqliteDatabase(const std::string& filename, int busyTimeout, bool readOnly = false);
+    SqliteDatabase(const std::string& filename, int busyTimeout, bool readOnly = false,
+        const SqlitePragmas& pragmas = SqlitePragmas());
 
     sqlpp::sqlite3::connection& GetDatabase() { return m_database; }
 
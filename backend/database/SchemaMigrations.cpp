@@ -0,0 +1,244 @@
+#include "SchemaMigrations.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <sqlite3.h>
+
+#include "../api/Resources.h"
+#include "../utility/Logger.h"
+
+constexpr std::size_t SchemaMigrations::s_defaultChunkSize;
+
+namespace
+{
+    void Execute(sqlite3* db, const std::string& sql)
+    {
+        char* error = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK)
+        {
+            std::string message = "SchemaMigrations: " + sql + " failed: " + (error ? error : "unknown error");
+            sqlite3_free(error);
+            throw std::runtime_error(message);
+        }
+    }
+
+    // Prepared statement, finalized when destroyed
+    class Statement
+    {
+    public:
+        Statement(sqlite3* db, const std::string& sql) : m_db(db)
+        {
+            if (sqlite3_prepare_v2(db, sql.c_str(), -1, &m_statement, nullptr) != SQLITE_OK)
+            {
+                throw std::runtime_error("SchemaMigrations: Failed to prepare " + sql + ": " + sqlite3_errmsg(db));
+            }
+        }
+        Statement(const Statement&) = delete;
+        ~Statement() { sqlite3_finalize(m_statement); }
+
+        Statement& Bind(int index, int64_t value)
+        {
+            sqlite3_bind_int64(m_statement, index, value);
+            return *this;
+        }
+        Statement& Bind(int index, const std::string& value)
+        {
+            sqlite3_bind_text(m_statement, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+            return *this;
+        }
+        // Returns whether a row is available
+        bool Step()
+        {
+            const int code = sqlite3_step(m_statement);
+            if (code == SQLITE_ROW)
+            {
+                return true;
+            }
+            if (code != SQLITE_DONE)
+            {
+                throw std::runtime_error(std::string("SchemaMigrations: ") + sqlite3_errmsg(m_db));
+            }
+            return false;
+        }
+        void Run()
+        {
+            while (Step())
+            {}
+        }
+        int64_t GetInt(int column) { return sqlite3_column_int64(m_statement, column); }
+
+    private:
+        sqlite3* m_db;
+        sqlite3_stmt* m_statement = nullptr;
+    };
+
+    // Rolls back if it was not committed
+    class Transaction
+    {
+    public:
+        explicit Transaction(sqlite3* db) : m_db(db) { Execute(db, "BEGIN IMMEDIATE;"); }
+        Transaction(const Transaction&) = delete;
+        ~Transaction()
+        {
+            if (!m_committed)
+            {
+                sqlite3_exec(m_db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            }
+        }
+
+        void Commit()
+        {
+            Execute(m_db, "COMMIT;");
+            m_committed = true;
+        }
+
+    private:
+        sqlite3* m_db;
+        bool m_committed = false;
+    };
+} // namespace
+
+SchemaMigrations::SchemaMigrations(std::vector<Migration> migrations, std::size_t chunkSize)
+    : m_migrations(std::move(migrations)), m_chunkSize(chunkSize)
+{
+    // Versions must be unique, otherwise a migration would be skipped
+    const bool sorted = std::adjacent_find(m_migrations.begin(), m_migrations.end(),
+                            [](const Migration& lhs, const Migration& rhs) { return lhs.m_version >= rhs.m_version; })
+        == m_migrations.end();
+    if (!sorted || chunkSize == 0)
+    {
+        throw std::invalid_argument("SchemaMigrations: Migrations must be sorted and chunkSize must not be 0");
+    }
+}
+
+int SchemaMigrations::GetLatestVersion() const
+{
+    return m_migrations.empty() ? 0 : m_migrations.back().m_version;
+}
+
+void SchemaMigrations::SetLatestVersion(Connection& db) const
+{
+    Execute(db.native_handle(), createBackfillsStatement);
+    Execute(db.native_handle(), "PRAGMA user_version = " + std::to_string(GetLatestVersion()) + ";");
+}
+
+void SchemaMigrations::Migrate(Connection& connection) const
+{
+    sqlite3* db = connection.native_handle();
+    Execute(db, createBackfillsStatement);
+    const int version = GetVersion(connection);
+    if (version > GetLatestVersion())
+    {
+        throw std::runtime_error("SchemaMigrations: Database version " + std::to_string(version)
+            + " is newer than the supported version " + std::to_string(GetLatestVersion()));
+    }
+    for (const Migration& migration : m_migrations)
+    {
+        if (migration.m_version <= version)
+        {
+            continue;
+        }
+        Res::Logger().Info("SchemaMigrations",
+            "Migrating database to version " + std::to_string(migration.m_version) + ": " + migration.m_description);
+        Transaction transaction(db);
+        for (const std::string& statement : migration.m_statements)
+        {
+            Execute(db, statement);
+        }
+        if (!migration.m_backfillTable.empty())
+        {
+            // Rows added after this are written by code which already knows the new schema
+            Statement range(
+                db, "SELECT IFNULL(MIN(rowid), 0), IFNULL(MAX(rowid), 0) + 1 FROM " + migration.m_backfillTable + ";");
+            range.Step();
+            Statement(db, "INSERT INTO schema_backfills(version, start, position, end) VALUES(?1, ?2, ?2, ?3);")
+                .Bind(1, migration.m_version)
+                .Bind(2, range.GetInt(0))
+                .Bind(3, range.GetInt(1))
+                .Run();
+        }
+        Execute(db, "PRAGMA user_version = " + std::to_string(migration.m_version) + ";");
+        transaction.Commit();
+    }
+}
+
+bool SchemaMigrations::RunBackfillChunk(Connection& connection, const Progress& progress) const
+{
+    sqlite3* db = connection.native_handle();
+    int64_t version;
+    int64_t start;
+    int64_t position;
+    int64_t end;
+    {
+        Statement next(db, "SELECT version, start, position, end FROM schema_backfills ORDER BY version LIMIT 1;");
+        if (!next.Step())
+        {
+            return false;
+        }
+        version = next.GetInt(0);
+        start = next.GetInt(1);
+        position = next.GetInt(2);
+        end = next.GetInt(3);
+    }
+    const Migration& migration = GetMigration(static_cast<int>(version));
+    const int64_t chunkEnd = std::min(end, position + static_cast<int64_t>(m_chunkSize));
+
+    Transaction transaction(db);
+    Statement(db, migration.m_backfillStatement).Bind(1, position).Bind(2, chunkEnd).Run();
+    if (chunkEnd >= end)
+    {
+        Statement(db, "DELETE FROM schema_backfills WHERE version = ?1;").Bind(1, version).Run();
+    }
+    else
+    {
+        Statement(db, "UPDATE schema_backfills SET position = ?2 WHERE version = ?1;")
+            .Bind(1, version)
+            .Bind(2, chunkEnd)
+            .Run();
+    }
+    transaction.Commit();
+    if (progress)
+    {
+        progress(migration, chunkEnd - start, end - start);
+    }
+    return true;
+}
+
+int SchemaMigrations::GetVersion(Connection& db)
+{
+    Statement statement(db.native_handle(), "PRAGMA user_version;");
+    statement.Step();
+    return static_cast<int>(statement.GetInt(0));
+}
+
+bool SchemaMigrations::HasTable(Connection& db, const std::string& table)
+{
+    Statement statement(db.native_handle(), "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?1;");
+    return statement.Bind(1, table).Step();
+}
+
+const Migration& SchemaMigrations::GetMigration(int version) const
+{
+    auto it = std::find_if(m_migrations.begin(), m_migrations.end(),
+        [&](const Migration& migration) { return migration.m_version == version; });
+    if (it == m_migrations.end())
+    {
+        throw std::runtime_error("SchemaMigrations: Unknown backfill of version " + std::to_string(version));
+    }
+    return *it;
+}
+
+std::vector<Migration> GetDatabaseMigrations()
+{
+    // Statements must not be changed once released, they have to create the same schema on every database
+    return {
+        // device_id was the primary key, so every device could only be in one group
+        {1, "Allow multiple groups per device",
+            {"CREATE TABLE device_groups_new(device_id INTEGER NOT NULL REFERENCES devices(device_id) ON DELETE "
+             "CASCADE, group_name VARCHAR NOT NULL, PRIMARY KEY(device_id, group_name));",
+                "INSERT INTO device_groups_new(device_id, group_name) SELECT device_id, group_name FROM device_groups;",
+                "DROP TABLE device_groups;", "ALTER TABLE device_groups_new RENAME TO device_groups;",
+                "CREATE INDEX IF NOT EXISTS device_groups_group_name ON device_groups(group_name, device_id);"}},
+    };
+}
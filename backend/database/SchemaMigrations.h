@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <sqlpp11/sqlite3/connection.h>
+
+// One step of the database schema, identified by the user_version it sets
+struct Migration
+{
+    // user_version after this migration
+    int m_version;
+    std::string m_description;
+    // Schema changes, executed in one transaction together with setting user_version
+    std::vector<std::string> m_statements;
+    // Table of the optional backfill, which is executed in chunks after the schema changes
+    std::string m_backfillTable;
+    // Executed for each chunk with ?1 as first and ?2 as end rowid of the chunk
+    std::string m_backfillStatement;
+};
+
+// Applies migrations based on the user_version of the database.
+// Backfills can take long on big tables, so they run in small transactions which are remembered in the database.
+// Other writes can be executed between the chunks, and an interrupted backfill continues on the next start.
+class SchemaMigrations
+{
+public:
+    using Connection = sqlpp::sqlite3::connection;
+    // Called after each backfill chunk, done and total are rowids of the backfill table
+    using Progress = std::function<void(const Migration& migration, int64_t done, int64_t total)>;
+
+    static constexpr std::size_t s_defaultChunkSize = 5000;
+    static constexpr const char* createBackfillsStatement
+        = "CREATE TABLE IF NOT EXISTS schema_backfills(version INTEGER PRIMARY KEY NOT NULL, "
+          "start INTEGER NOT NULL, position INTEGER NOT NULL, end INTEGER NOT NULL);";
+
+public:
+    // migrations must be sorted by version without duplicates
+    explicit SchemaMigrations(std::vector<Migration> migrations, std::size_t chunkSize = s_defaultChunkSize);
+
+    int GetLatestVersion() const;
+    // Marks a newly created database, which already has the latest schema
+    void SetLatestVersion(Connection& db) const;
+    // Applies the schema changes of all migrations newer than the database and queues their backfills.
+    // Throws std::runtime_error if the database is newer than the latest migration
+    void Migrate(Connection& db) const;
+    // Executes the next chunk of the oldest queued backfill, returns false if there are none left
+    bool RunBackfillChunk(Connection& db, const Progress& progress = nullptr) const;
+
+    static int GetVersion(Connection& db);
+    static bool HasTable(Connection& db, const std::string& table);
+
+private:
+    const Migration& GetMigration(int version) const;
+
+private:
+    std::vector<Migration> m_migrations;
+    std::size_t m_chunkSize;
+};
+
+// Migrations of the homeplusplus database
+std::vector<Migration> GetDatabaseMigrations();
\ No newline at end of file
@@ -14,8 +14,16 @@ ActionsSocketHandler::ActionsSocketHandler(SubActionRegistry& actionRegistry, co
     : m_subActionRegistry(&actionRegistry),
       m_actionStorage(actionStorage),
       m_deviceReg(&deviceReg),
-      m_channelAccessor(std::move(notificationsChannelAccessor))
-{}
+      m_channelAccessor(std::move(notificationsChannelAccessor)),
+      m_router("ActionsSocketHandler")
+{
+    m_router.AddCommand(s_addAction, &ActionsSocketHandler::AddAction);
+    m_router.AddCommand(s_getActions, &ActionsSocketHandler::GetActions);
+    m_router.AddCommand(s_getAction, &ActionsSocketHandler::GetAction);
+    m_router.AddCommand(s_deleteAction, &ActionsSocketHandler::DeleteAction);
+    m_router.AddCommand(s_execAction, &ActionsSocketHandler::ExecAction);
+    m_router.AddCommand(s_getActionTypes, &ActionsSocketHandler::GetActionTypes);
+}
 
 PostEventState ActionsSocketHandler::operator()(const WebsocketChannel::EventVariant& event, WebsocketChannel& channel)
 {
@@ -29,87 +37,79 @@ PostEventState ActionsSocketHandler::operator()(const WebsocketChannel::EventVar
 PostEventState ActionsSocketHandler::HandleSocketMessage(
     const Events::SocketMessageEvent& event, WebsocketChannel& channel)
 {
-    try
+    return m_router.Dispatch(*this, event, channel);
+}
+
+PostEventState ActionsSocketHandler::AddAction(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    const nlohmann::json& value = event.GetJsonPayload().at("actionJSON");
+    Action action = Action::Parse(value, *m_subActionRegistry);
+    m_actionStorage.AddAction(action, event.GetUser().value());
+
+    return PostEventState::handled;
+}
+
+PostEventState ActionsSocketHandler::GetActions(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    std::vector<Action> actionList = m_actionStorage.GetAllActions(Filter(), event.GetUser().value());
+    for (const Action& action : actionList)
     {
-        const nlohmann::json& payload = event.GetJsonPayload();
-        auto it = payload.find("command");
-        if (it == payload.end())
-        {
-            return PostEventState::notHandled;
-        }
-        const std::string& command = *it;
-        if (command == s_addAction)
-        {
-            const nlohmann::json& value = payload.at("actionJSON");
-            Action action = Action::Parse(value, *m_subActionRegistry);
-            m_actionStorage.AddAction(action, event.GetUser().value());
+        channel.Send(event.GetConnection(), nlohmann::json {{"action", action.ToJson()}});
+    }
+    if (actionList.empty())
+    {
+        channel.Send(event.GetConnection(), nlohmann::json {{"actions", nlohmann::json::array()}});
+    }
+    return PostEventState::handled;
+}
 
-            return PostEventState::handled;
-        }
-        else if (command == s_getActions)
-        {
-            std::vector<Action> actionList = m_actionStorage.GetAllActions(Filter(), event.GetUser().value());
-            for (const Action& action : actionList)
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"action", action.ToJson()}});
-            }
-            if (actionList.empty())
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"actions", nlohmann::json::array()}});
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_getAction)
-        {
-            absl::optional<Action> action = m_actionStorage.GetAction(payload.at("id"), event.GetUser().value());
-            if (action)
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"action", action->ToJson()}});
-            }
-            else
-            {
-                // TODO: Send action not found
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_deleteAction)
-        {
-            absl::optional<Action> action = m_actionStorage.GetAction(payload.at("id"), event.GetUser().value());
-            if (action)
-            {
-                m_actionStorage.RemoveAction(action->GetId(), event.GetUser().value());
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_execAction)
-        {
-            WebsocketChannel& notificationsChannel = m_channelAccessor.Get();
-            absl::optional<Action> action = m_actionStorage.GetAction(payload.at("id"), event.GetUser().value());
-            if (action)
-            {
-                action->Execute(m_actionStorage, notificationsChannel, *m_deviceReg, event.GetUser().value());
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_getActionTypes)
-        {
-            const std::vector<SubActionInfo>& registered = m_subActionRegistry->GetRegistered();
-            nlohmann::json result = nlohmann::json::array();
-            for (std::size_t i = 0; i < registered.size(); ++i)
-            {
-                if (registered[i] != nullptr)
-                {
-                    result.push_back(nlohmann::json {{"id", i}, {"name", registered[i].name}});
-                }
-            }
-            channel.Send(event.GetConnection(), nlohmann::json {{"actionTypes", result}});
-            return PostEventState::handled;
-        }
+PostEventState ActionsSocketHandler::GetAction(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    absl::optional<Action> action = m_actionStorage.GetAction(event.GetJsonPayload().at("id"), event.GetUser().value());
+    if (action)
+    {
+        channel.Send(event.GetConnection(), nlohmann::json {{"action", action->ToJson()}});
     }
-    catch (const std::exception& e)
+    else
     {
-        Res::Logger().Error("ActionsSocketHandler", std::string("Exception while processing message: ") + e.what());
-        return PostEventState::error;
+        // TODO: Send action not found
     }
-    return PostEventState::notHandled;
+    return PostEventState::handled;
+}
+
+PostEventState ActionsSocketHandler::DeleteAction(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    absl::optional<Action> action = m_actionStorage.GetAction(event.GetJsonPayload().at("id"), event.GetUser().value());
+    if (action)
+    {
+        m_actionStorage.RemoveAction(action->GetId(), event.GetUser().value());
+    }
+    return PostEventState::handled;
+}
+
+PostEventState ActionsSocketHandler::ExecAction(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    WebsocketChannel& notificationsChannel = m_channelAccessor.Get();
+    absl::optional<Action> action = m_actionStorage.GetAction(event.GetJsonPayload().at("id"), event.GetUser().value());
+    if (action)
+    {
+        action->Execute(m_actionStorage, notificationsChannel, *m_deviceReg, event.GetUser().value());
+    }
+    return PostEventState::handled;
+}
+
+PostEventState ActionsSocketHandler::GetActionTypes(
+    const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    const std::vector<SubActionInfo>& registered = m_subActionRegistry->GetRegistered();
+    nlohmann::json result = nlohmann::json::array();
+    for (std::size_t i = 0; i < registered.size(); ++i)
+    {
+        if (registered[i] != nullptr)
+        {
+            result.push_back(nlohmann::json {{"id", i}, {"name", registered[i].name}});
+        }
+    }
+    channel.Send(event.GetConnection(), nlohmann::json {{"actionTypes", result}});
+    return PostEventState::handled;
 }
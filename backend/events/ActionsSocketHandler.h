@@ -5,6 +5,7 @@
 #include "../api/ActionStorage.h"
 #include "../api/IActionSerialize.h"
 #include "../communication/WebsocketCommunication.h"
+#include "CommandRouter.h"
 
 class ActionsSocketHandler
 {
@@ -24,11 +25,20 @@ public:
     static constexpr const char* s_execAction = "EXEC_ACTION";
     static constexpr const char* s_getActionTypes = "GET_ACTION_TYPES";
 
+private:
+    PostEventState AddAction(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetActions(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetAction(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState DeleteAction(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState ExecAction(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetActionTypes(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+
 private:
     SubActionRegistry* m_subActionRegistry;
     ActionStorage m_actionStorage;
     DeviceRegistry* m_deviceReg;
     WebsocketChannelAccessor m_channelAccessor;
+    CommandRouter<ActionsSocketHandler> m_router;
 };
 
 #endif
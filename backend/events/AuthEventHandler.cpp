@@ -47,7 +47,8 @@ PostEventState AuthEventHandler::HandleSocketMessage(const Events::SocketMessage
                 nlohmann::json{{"idToken", token},
                     {"expiresIn", std::chrono::duration_cast<std::chrono::seconds>(s_tokenExpiration).count()}});
 
-            auto& db = m_dbHandler->GetDatabase();
+            DBHandler::ReadConnection connection = m_dbHandler->GetReadConnection();
+            auto& db = *connection;
             UsersTable users;
 
             auto result = db(select(users.userId, users.picture).from(users).where(users.userName == username));
@@ -76,7 +77,8 @@ PostEventState AuthEventHandler::HandleSocketMessage(const Events::SocketMessage
 
 std::string AuthEventHandler::ValidateLogin(const std::string& username, const std::string& password)
 {
-    auto& db = m_dbHandler->GetDatabase();
+    DBHandler::ReadConnection connection = m_dbHandler->GetReadConnection();
+    auto& db = *connection;
     UsersTable users;
     auto result = db(select(users.userPwhash, users.userId).from(users).where(users.userName == username));
     if (!result.empty())
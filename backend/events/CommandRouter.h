@@ -0,0 +1,149 @@
+#ifndef _COMMAND_ROUTER_H
+#define _COMMAND_ROUTER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "EventSystem.h"
+#include "SocketEvents.h"
+
+#include "../api/Resources.h"
+#include "../communication/WebsocketChannel.h"
+#include "../utility/Logger.h"
+
+// Call statistics of a single socket command
+struct CommandStats
+{
+    std::string command;
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    std::chrono::microseconds totalTime {0};
+    std::chrono::microseconds maxTime {0};
+};
+
+// Dispatches socket messages to member functions of Owner by their command.
+// Commands are looked up by their hash (EventTypes::GetEventType) instead of comparing against every command.
+// Copies of the router share the same statistics, so it can be a member of handlers which are copied into channels.
+// The statistics of all commands of a channel are sent as response to s_getCommandStats.
+template <typename Owner>
+class CommandRouter
+{
+public:
+    using Handler = PostEventState (Owner::*)(const Events::SocketMessageEvent&, WebsocketChannel&);
+
+    static constexpr const char* s_getCommandStats = "GET_COMMAND_STATS";
+
+    // name is used as tag when logging exceptions
+    explicit CommandRouter(std::string name) : m_name(std::move(name)), m_stats(std::make_shared<SharedStats>()) {}
+
+    // command must have static storage duration, like the s_xxx constants of the handlers.
+    // Throws std::logic_error if command is already registered or collides with another command
+    void AddCommand(const char* command, Handler handler)
+    {
+        const EventType hash = EventTypes::GetEventType(command);
+        if (m_commands.count(hash) != 0)
+        {
+            throw std::logic_error(std::string("CommandRouter: duplicate command ") + command);
+        }
+        std::lock_guard<std::mutex> lock(m_stats->mutex);
+        m_commands.emplace(hash, Entry {command, handler, m_stats->stats.size()});
+        CommandStats stats;
+        stats.command = command;
+        m_stats->stats.push_back(std::move(stats));
+    }
+
+    // Returns notHandled if the command is not registered.
+    // Exceptions thrown by the handler are logged and result in PostEventState::error.
+    PostEventState Dispatch(Owner& owner, const Events::SocketMessageEvent& event, WebsocketChannel& channel) const
+    {
+        const std::string& command = event.GetCommand();
+        if (command.empty())
+        {
+            return PostEventState::notHandled;
+        }
+        if (command == s_getCommandStats)
+        {
+            channel.Send(event.GetConnection(), nlohmann::json {{"commandStats", StatsToJson(GetStats())}});
+            return PostEventState::handled;
+        }
+        auto it = m_commands.find(EventTypes::GetEventType(command.c_str()));
+        if (it == m_commands.end() || command != it->second.command)
+        {
+            return PostEventState::notHandled;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        PostEventState result = PostEventState::error;
+        try
+        {
+            result = (owner.*(it->second.handler))(event, channel);
+        }
+        catch (const std::exception& e)
+        {
+            Res::Logger().Error(m_name, std::string("Exception while processing message: ") + e.what());
+            result = PostEventState::error;
+        }
+        const auto duration
+            = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        std::lock_guard<std::mutex> lock(m_stats->mutex);
+        CommandStats& stats = m_stats->stats[it->second.statsIndex];
+        ++stats.calls;
+        if ((result & PostEventState::error) == PostEventState::error)
+        {
+            ++stats.errors;
+        }
+        stats.totalTime += duration;
+        stats.maxTime = std::max(stats.maxTime, duration);
+        return result;
+    }
+
+    // Returns statistics of all commands in order of registration
+    std::vector<CommandStats> GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_stats->mutex);
+        return m_stats->stats;
+    }
+
+    // Converts stats to an array of {command, calls, errors, totalTime, maxTime}, times are in microseconds
+    static nlohmann::json StatsToJson(const std::vector<CommandStats>& stats)
+    {
+        nlohmann::json result = nlohmann::json::array();
+        for (const CommandStats& s : stats)
+        {
+            result.push_back({{"command", s.command}, {"calls", s.calls}, {"errors", s.errors},
+                {"totalTime", s.totalTime.count()}, {"maxTime", s.maxTime.count()}});
+        }
+        return result;
+    }
+
+private:
+    struct Entry
+    {
+        const char* command;
+        Handler handler;
+        std::size_t statsIndex;
+    };
+    struct SharedStats
+    {
+        std::mutex mutex;
+        std::vector<CommandStats> stats;
+    };
+
+private:
+    std::string m_name;
+    absl::flat_hash_map<EventType, Entry> m_commands;
+    std::shared_ptr<SharedStats> m_stats;
+};
+
+template <typename Owner>
+constexpr const char* CommandRouter<Owner>::s_getCommandStats;
+
+#endif
@@ -1,8 +1,12 @@
 #include "DevicesSocketHandler.h"
 
+#include <algorithm>
+
 #include <hinnant-date/include/date/date.h>
 #include <hinnant-date/include/date/tz.h>
 
+#include "PropertyDeltaHandler.h"
+
 #include "../api/Resources.h"
 #include "../database/DevicesTable.h"
 #include "../utility/Logger.h"
@@ -10,11 +14,41 @@
 constexpr const char* DevicesSocketHandler::s_getDevices;
 constexpr const char* DevicesSocketHandler::s_getDevice;
 constexpr const char* DevicesSocketHandler::s_getSensorData;
+constexpr const char* DevicesSocketHandler::s_deleteDevice;
+constexpr const char* DevicesSocketHandler::s_setName;
+constexpr const char* DevicesSocketHandler::s_setGroups;
+constexpr const char* DevicesSocketHandler::s_setProperty;
+constexpr const char* DevicesSocketHandler::s_getMeta;
+constexpr const char* DevicesSocketHandler::s_getAllMeta;
+constexpr const char* DevicesSocketHandler::s_getPropertyLog;
+constexpr const char* DevicesSocketHandler::s_subscribeProperties;
+constexpr const char* DevicesSocketHandler::s_unsubscribeProperties;
+constexpr std::size_t DevicesSocketHandler::s_defaultChunkSize;
 
-DevicesSocketHandler::DevicesSocketHandler(
-    DBHandler& dbHandler, DeviceStorage& deviceStorage, DeviceTypeRegistry& typeRegistry)
-    : m_dbHandler(&dbHandler), m_deviceStorage(&deviceStorage), m_typeRegistry(&typeRegistry)
-{}
+DevicesSocketHandler::DevicesSocketHandler(DBHandler& dbHandler, DeviceStorage& deviceStorage,
+    DeviceTypeRegistry& typeRegistry, PropertyDeltaHandler* deltaHandler, std::size_t chunkSize)
+    : m_dbHandler(&dbHandler),
+      m_deviceStorage(&deviceStorage),
+      m_typeRegistry(&typeRegistry),
+      m_deltaHandler(deltaHandler),
+      m_chunkSize(std::max<std::size_t>(chunkSize, 1)),
+      m_router("DevicesSocketHandler")
+{
+    m_router.AddCommand(s_getDevices, &DevicesSocketHandler::GetDevices);
+    m_router.AddCommand(s_getDevice, &DevicesSocketHandler::GetDevice);
+    m_router.AddCommand(s_deleteDevice, &DevicesSocketHandler::DeleteDevice);
+    m_router.AddCommand(s_setName, &DevicesSocketHandler::SetName);
+    m_router.AddCommand(s_setGroups, &DevicesSocketHandler::SetGroups);
+    m_router.AddCommand(s_setProperty, &DevicesSocketHandler::SetProperty);
+    m_router.AddCommand(s_getMeta, &DevicesSocketHandler::GetMeta);
+    m_router.AddCommand(s_getAllMeta, &DevicesSocketHandler::GetAllMeta);
+    m_router.AddCommand(s_getPropertyLog, &DevicesSocketHandler::GetPropertyLog);
+    if (m_deltaHandler != nullptr)
+    {
+        m_router.AddCommand(s_subscribeProperties, &DevicesSocketHandler::SubscribeProperties);
+        m_router.AddCommand(s_unsubscribeProperties, &DevicesSocketHandler::UnsubscribeProperties);
+    }
+}
 
 PostEventState DevicesSocketHandler::operator()(const WebsocketChannel::EventVariant& event, WebsocketChannel& channel)
 {
@@ -22,6 +56,10 @@ PostEventState DevicesSocketHandler::operator()(const WebsocketChannel::EventVar
     {
         return HandleSocketMessage(absl::get<Events::SocketMessageEvent>(event), channel);
     }
+    else if (absl::holds_alternative<Events::SocketDisconnectEvent>(event) && m_deltaHandler != nullptr)
+    {
+        m_deltaHandler->Unsubscribe(absl::get<Events::SocketDisconnectEvent>(event).GetConnection());
+    }
     return PostEventState::notHandled;
 }
 
@@ -51,171 +89,249 @@ absl::optional<std::chrono::system_clock::time_point> getEnd(const nlohmann::jso
 PostEventState DevicesSocketHandler::HandleSocketMessage(
     const Events::SocketMessageEvent& event, WebsocketChannel& channel)
 {
-    try
+    return m_router.Dispatch(*this, event, channel);
+}
+
+PostEventState DevicesSocketHandler::GetDevices(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    // request = {command: "GET_DEVICES", search: string, start: int, max: int}, all optional
+    const Filter filter = Filter::FromJson(event.GetJsonPayload());
+    std::vector<Device> devices = m_deviceStorage->GetAllDevices(filter, event.GetUser().value());
+    SendDevices(event.GetConnection(), devices, filter.getStartIndex(), channel);
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::GetDevice(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    absl::optional<const Device> device = m_deviceStorage->GetDevice(
+        DeviceId(event.GetJsonPayload().at("id").get<int64_t>()), event.GetUser().value());
+    if (device && channel.IsBinary(event.GetConnection()))
     {
-        const nlohmann::json& payload = event.GetJsonPayload();
-        auto it = payload.find("command");
-        if (it == payload.end())
-        {
-            return PostEventState::notHandled;
-        }
-        const std::string& command = *it;
-        UserId user = event.GetUser().value();
-        if (command == s_getDevices)
-        {
-            std::vector<Device> devices = m_deviceStorage->GetAllDevices(user);
-            for (const Device& device : devices)
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"device", device.ToJson()}});
-            }
-            if (devices.empty())
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"devices", nlohmann::json::array()}});
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_getDevice)
-        {
-            absl::optional<const Device> device
-                = m_deviceStorage->GetDevice(DeviceId(payload.at("id").get<int64_t>()), user);
-            if (device)
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"device", device->ToJson()}});
-            }
-            else
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"device", nullptr}});
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_deleteDevice)
+        messages::ChannelMessage message;
+        *message.mutable_device() = device->Serialize();
+        channel.SendMessage(event.GetConnection(), message);
+    }
+    else if (device)
+    {
+        channel.Send(event.GetConnection(), nlohmann::json {{"device", device->ToJson()}});
+    }
+    else
+    {
+        channel.Send(event.GetConnection(), nlohmann::json {{"device", nullptr}});
+    }
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::DeleteDevice(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    UserId user = event.GetUser().value();
+    DeviceId id {event.GetJsonPayload().at("id").get<int64_t>()};
+    absl::optional<const Device> device = m_deviceStorage->GetDevice(id, user);
+    if (device && m_typeRegistry->HasDeviceType(device->GetType()))
+    {
+        const DeviceType& type = m_typeRegistry->GetDeviceType(device->GetType());
+        if (type.CanRemoveDevice())
         {
-            DeviceId id {payload.at("id").get<int64_t>()};
-            absl::optional<const Device> device = m_deviceStorage->GetDevice(id, user);
-            if (device && m_typeRegistry->HasDeviceType(device->GetType()))
-            {
-                const DeviceType& type = m_typeRegistry->GetDeviceType(device->GetType());
-                if (type.CanRemoveDevice())
-                {
-                    m_deviceStorage->RemoveDevice(id, user);
-                }
-                else
-                {
-                    Res::Logger().Warning("Cannot remove device " + std::to_string(id.GetValue()));
-                }
-            }
-            return PostEventState::handled;
+            m_deviceStorage->RemoveDevice(id, user);
         }
-        else if (command == s_setName)
+        else
         {
-            DeviceId id {payload.at("id").get<int64_t>()};
-            std::string name = payload.at("name");
-            absl::optional<Device> device = m_deviceStorage->GetDevice(id, user);
-            if (!device)
-            {
-                Res::Logger().Warning("Could not find device " + std::to_string(id.GetValue()));
-                return PostEventState::error;
-            }
-            device->SetName(name);
-            m_deviceStorage->ChangeDevice(*device, user);
+            Res::Logger().Warning("Cannot remove device " + std::to_string(id.GetValue()));
         }
-        else if (command == s_setGroups)
+    }
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::SetName(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    const nlohmann::json& payload = event.GetJsonPayload();
+    UserId user = event.GetUser().value();
+    DeviceId id {payload.at("id").get<int64_t>()};
+    std::string name = payload.at("name");
+    absl::optional<Device> device = m_deviceStorage->GetDevice(id, user);
+    if (!device)
+    {
+        Res::Logger().Warning("Could not find device " + std::to_string(id.GetValue()));
+        return PostEventState::error;
+    }
+    device->SetName(name);
+    m_deviceStorage->ChangeDevice(*device, user, Events::DeviceFields::NAME);
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::SetGroups(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    const nlohmann::json& payload = event.GetJsonPayload();
+    UserId user = event.GetUser().value();
+    DeviceId id {payload.at("id").get<int64_t>()};
+    const nlohmann::json& groups = payload.at("groups");
+    std::vector<std::string> groupVector;
+    groupVector.reserve(groups.size());
+    for (const auto& g : groups)
+    {
+        groupVector.push_back(g);
+    }
+    absl::optional<Device> device = m_deviceStorage->GetDevice(id, user);
+    if (!device)
+    {
+        Res::Logger().Warning("Could not find device " + std::to_string(id.GetValue()));
+        return PostEventState::error;
+    }
+    device->SetGroups(groupVector);
+    m_deviceStorage->ChangeDevice(*device, user, Events::DeviceFields::GROUPS);
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::SetProperty(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    const nlohmann::json& payload = event.GetJsonPayload();
+    UserId user = event.GetUser().value();
+    DeviceId devId {payload.at("id").get<int64_t>()};
+    std::string key = payload.at("property");
+    const nlohmann::json& val = payload.at("value");
+    absl::optional<Device> device = m_deviceStorage->GetDevice(devId, user);
+    if (!device)
+    {
+        Res::Logger().Warning("Could not find device " + std::to_string(devId.GetValue()));
+        return PostEventState::error;
+    }
+    if (!device->SetProperty(key, val, *m_deviceStorage, user))
+    {
+        Res::Logger().Warning("Could not set device property");
+        return PostEventState::error;
+    }
+
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::GetMeta(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    std::string type = event.GetJsonPayload().at("type");
+    channel.Send(event.GetConnection(), BuildMetaJson(type));
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::GetAllMeta(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    nlohmann::json arr;
+    for (const std::string& type : m_typeRegistry->GetRegisteredTypes())
+    {
+        arr.emplace_back(BuildMetaJson(type));
+    }
+    channel.Send(event.GetConnection(), nlohmann::json {{"allTypes", arr}});
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::GetPropertyLog(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    // request = {command: "GET_PROPERTY_LOG", properties: {<deviceid> : [properties]}}
+    const nlohmann::json& payload = event.GetJsonPayload();
+    UserId user = event.GetUser().value();
+    const nlohmann::json& type = payload.at("properties");
+    const time_t time = payload.at("start");
+    auto start = std::chrono::system_clock::from_time_t(time);
+    absl::optional<std::chrono::system_clock::time_point> end = getEnd(payload);
+    std::time_t compression;
+    if (payload.count("compression"))
+    {
+        compression = payload.at("compression");
+    }
+    else
+    {
+        compression = 0;
+    }
+    nlohmann::json data;
+    for (auto it = type.begin(); it != type.end(); ++it)
+    {
+        DeviceId devId {std::stoi(it.key())};
+        nlohmann::json& deviceJson = data[it.key()];
+
+        absl::optional<Device> device = m_deviceStorage->GetDevice(devId, user);
+        if (device)
         {
-            DeviceId id {payload.at("id").get<int64_t>()};
-            nlohmann::json groups = payload.at("groups");
-            std::vector<std::string> groupVector;
-            groupVector.reserve(groups.size());
-            for (const auto& g : groups)
-            {
-                groupVector.push_back(g);
-            }
-            absl::optional<Device> device = m_deviceStorage->GetDevice(id, user);
-            if (!device)
+            for (auto propertyIt : it.value())
             {
-                Res::Logger().Warning("Could not find device " + std::to_string(id.GetValue()));
-                return PostEventState::error;
+                deviceJson[propertyIt.get<std::string>()]
+                    = device->GetPropertyHistory(propertyIt, start, end, compression, *m_deviceStorage, user);
             }
-            device->SetGroups(groupVector);
-            m_deviceStorage->ChangeDevice(*device, user);
         }
-        else if (command == s_setProperty)
-        {
-            DeviceId devId {payload.at("id").get<int64_t>()};
-            std::string key = payload.at("property");
-            nlohmann::json val = payload.at("value");
-            absl::optional<Device> device = m_deviceStorage->GetDevice(devId, user);
-            if (!device)
-            {
-                Res::Logger().Warning("Could not find device " + std::to_string(devId.GetValue()));
-                return PostEventState::error;
-            }
-            if (!device->SetProperty(key, val, *m_deviceStorage, user))
-            {
-                Res::Logger().Warning("Could not set device property");
-                return PostEventState::error;
-            }
+    }
+    if (channel.IsBinary(event.GetConnection()))
+    {
+        channel.SendMessage(event.GetConnection(), BuildPropertyLogMessage(data));
+    }
+    else
+    {
+        channel.Send(event.GetConnection(), nlohmann::json {{"log", data}});
+    }
+    return PostEventState::handled;
+}
 
-            return PostEventState::handled;
-        }
-        else if (command == s_getMeta)
+PostEventState DevicesSocketHandler::SubscribeProperties(
+    const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    // request = {command: "SUBSCRIBE_PROPERTIES", devices: [ids], properties: [keys], binary: bool}
+    // devices and properties are optional, missing means all
+    const nlohmann::json& payload = event.GetJsonPayload();
+    std::vector<DeviceId> devices;
+    auto devicesIt = payload.find("devices");
+    if (devicesIt != payload.end())
+    {
+        for (const auto& id : *devicesIt)
         {
-            std::string type = payload.at("type");
-            channel.Send(event.GetConnection(), BuildMetaJson(type));
+            devices.emplace_back(id.get<int64_t>());
         }
-        else if (command == s_getAllMeta)
+    }
+    std::vector<std::string> properties;
+    auto propertiesIt = payload.find("properties");
+    if (propertiesIt != payload.end())
+    {
+        properties = propertiesIt->get<std::vector<std::string>>();
+    }
+    const bool binary = payload.value("binary", channel.IsBinary(event.GetConnection()));
+    m_deltaHandler->Subscribe(event.GetConnection(), devices, properties, binary, event.GetUser().value(), channel);
+    return PostEventState::handled;
+}
+
+PostEventState DevicesSocketHandler::UnsubscribeProperties(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    m_deltaHandler->Unsubscribe(event.GetConnection());
+    return PostEventState::handled;
+}
+
+void DevicesSocketHandler::SendDevices(Events::SocketMessageEvent::connection_hdl hdl,
+    const std::vector<Device>& devices, int startIndex, WebsocketChannel& channel) const
+{
+    const bool binary = channel.IsBinary(hdl);
+    std::size_t begin = 0;
+    do
+    {
+        const std::size_t end = std::min(begin + m_chunkSize, devices.size());
+        if (binary)
         {
-            nlohmann::json arr;
-            for (const std::string& type : m_typeRegistry->GetRegisteredTypes())
+            messages::ChannelMessage message;
+            messages::DeviceList* deviceList = message.mutable_devices();
+            for (std::size_t i = begin; i < end; ++i)
             {
-                arr.emplace_back(BuildMetaJson(type));
+                *deviceList->add_devices() = devices[i].Serialize();
             }
-            channel.Send(event.GetConnection(), nlohmann::json {{"allTypes", arr}});
+            deviceList->set_start(startIndex + begin);
+            deviceList->set_last(end == devices.size());
+            channel.SendMessage(hdl, message);
         }
-        else if (command == s_getPropertyLog)
+        else
         {
-            // request = {command: "GET_PROPERTY_LOG", properties: {<deviceid> : [properties]}}
-            auto type = payload.at("properties");
-            const time_t time = payload.at("start");
-            auto start = std::chrono::system_clock::from_time_t(time);
-            absl::optional<std::chrono::system_clock::time_point> end = getEnd(payload);
-            std::time_t compression;
-            if (payload.count("compression"))
-            {
-                compression = payload.at("compression");
-            }
-            else
+            nlohmann::json chunk = nlohmann::json::array();
+            for (std::size_t i = begin; i < end; ++i)
             {
-                compression = 0;
+                chunk.push_back(devices[i].ToJson());
             }
-            nlohmann::json data;
-            for (auto it = type.begin(); it != type.end(); ++it)
-            {
-                DeviceId devId {std::stoi(it.key())};
-                nlohmann::json& deviceJson = data[it.key()];
-
-                absl::optional<Device> device = m_deviceStorage->GetDevice(devId, user);
-                if (device)
-                {
-                    for (auto propertyIt : it.value())
-                    {
-                        deviceJson[propertyIt.get<std::string>()]
-                            = device->GetPropertyHistory(propertyIt, start, end, compression, *m_deviceStorage, user);
-                    }
-                }
-            }
-            channel.Send(event.GetConnection(), nlohmann::json {{"log", data}});
+            channel.Send(hdl,
+                nlohmann::json {
+                    {"devices", std::move(chunk)}, {"start", startIndex + begin}, {"last", end == devices.size()}});
         }
-        /*else if (command == s_getSensorData)
-        {
-            return SendSensorData(event.GetConnection(), payload);
-        }*/
-    }
-    catch (const std::exception& e)
-    {
-        Res::Logger().Error("DevicesSocketHandler", std::string("Exception while processing message: ") + e.what());
-        return PostEventState::error;
-    }
-    return PostEventState::notHandled;
+        begin = end;
+    } while (begin < devices.size());
 }
 
 PostEventState DevicesSocketHandler::SendSensorData(
@@ -315,7 +431,8 @@ namespace
 nlohmann::json DevicesSocketHandler::BuildPropertyLogJson(
     const DeviceId deviceId, const nlohmann::json& properties) const
 {
-    auto& db = m_dbHandler->GetDatabase();
+    DBHandler::ReadConnection connection = m_dbHandler->GetReadConnection();
+    auto& db = *connection;
 
     nlohmann::json dataJson;
     const int64_t devId = deviceId.GetValue();
@@ -359,3 +476,30 @@ nlohmann::json DevicesSocketHandler::BuildPropertyLogJson(
 
     return dataJson;
 }
+
+messages::ChannelMessage DevicesSocketHandler::BuildPropertyLogMessage(const nlohmann::json& log) const
+{
+    // log = {<deviceid>: {<property>: {<time>: value}}}
+    messages::ChannelMessage message;
+    messages::PropertyLogList* logList = message.mutable_log();
+    for (auto deviceIt = log.begin(); deviceIt != log.end(); ++deviceIt)
+    {
+        const uint64_t deviceId = std::stoull(deviceIt.key());
+        for (auto propertyIt = deviceIt->begin(); propertyIt != deviceIt->end(); ++propertyIt)
+        {
+            messages::PropertyLog* propertyLog = logList->add_logs();
+            propertyLog->set_device_id(deviceId);
+            propertyLog->set_key(propertyIt.key());
+            for (auto entryIt = propertyIt->begin(); entryIt != propertyIt->end(); ++entryIt)
+            {
+                messages::PropertyLogEntry* entry = propertyLog->add_entries();
+                entry->set_time(entryIt.key());
+                if (!entryIt->is_null())
+                {
+                    *entry->mutable_value() = JsonToAnyOrDump(*entryIt);
+                }
+            }
+        }
+    }
+    return message;
+}
@@ -4,11 +4,15 @@
 #include "../api/DeviceRegistry.h"
 #include "../communication/WebsocketChannel.h"
 #include "../database/DBHandler.h"
+#include "CommandRouter.h"
+
+class PropertyDeltaHandler;
 
 class DevicesSocketHandler
 {
 public:
-    DevicesSocketHandler(DBHandler& dbHandler, DeviceStorage& deviceStorage, DeviceTypeRegistry& typeRegistry);
+    DevicesSocketHandler(DBHandler& dbHandler, DeviceStorage& deviceStorage, DeviceTypeRegistry& typeRegistry,
+        PropertyDeltaHandler* deltaHandler = nullptr, std::size_t chunkSize = s_defaultChunkSize);
 
     PostEventState operator()(const WebsocketChannel::EventVariant& event, WebsocketChannel& channel);
 
@@ -25,8 +29,29 @@ public:
     static constexpr const char* s_getMeta = "GET_TYPE_META";
     static constexpr const char* s_getAllMeta = "GET_ALL_TYPES";
     static constexpr const char* s_getPropertyLog = "GET_PROPERTY_LOG";
+    static constexpr const char* s_subscribeProperties = "SUBSCRIBE_PROPERTIES";
+    static constexpr const char* s_unsubscribeProperties = "UNSUBSCRIBE_PROPERTIES";
+
+    // Number of devices per message in response to GET_DEVICES
+    static constexpr std::size_t s_defaultChunkSize = 50;
 
 private:
+    PostEventState GetDevices(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetDevice(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState DeleteDevice(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState SetName(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState SetGroups(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState SetProperty(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetMeta(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetAllMeta(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetPropertyLog(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState SubscribeProperties(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState UnsubscribeProperties(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+
+    // Sends devices in chunks of m_chunkSize as {devices: [...], start, last}, always at least one message
+    void SendDevices(Events::SocketMessageEvent::connection_hdl hdl, const std::vector<Device>& devices,
+        int startIndex, WebsocketChannel& channel) const;
+
     PostEventState SendSensorData(
         Events::SocketMessageEvent::connection_hdl hdl, const nlohmann::json& request, WebsocketChannel& channel);
 
@@ -34,10 +59,16 @@ private:
 
     nlohmann::json BuildPropertyLogJson(const DeviceId deviceId, const nlohmann::json& properties) const;
 
+    // Converts the json built for GET_PROPERTY_LOG into a binary message
+    messages::ChannelMessage BuildPropertyLogMessage(const nlohmann::json& log) const;
+
 private:
     DBHandler* m_dbHandler;
     DeviceStorage* m_deviceStorage;
     DeviceTypeRegistry* m_typeRegistry;
+    PropertyDeltaHandler* m_deltaHandler;
+    std::size_t m_chunkSize;
+    CommandRouter<DevicesSocketHandler> m_router;
 };
 
 #endif
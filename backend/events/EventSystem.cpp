@@ -51,7 +51,13 @@ void EventSystem::RemoveHandler(const EventHandler<EventBase>* handler)
 void EventSystem::HandleEvent(const EventBase& e)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    Res::Logger().Debug("Handle event with type: " + std::to_string(static_cast<int>(e.GetType())));
+    auto& log = Res::Logger();
+    // Only build debug messages when they are written
+    const bool debug = log.IsEnabled(Logger::LEVEL_DEBUG);
+    if (debug)
+    {
+        log.Debug("Handle event with type: " + std::to_string(static_cast<int>(e.GetType())));
+    }
     bool innerLoop = false;
     {
         if (m_inLoop)
@@ -82,13 +88,13 @@ void EventSystem::HandleEvent(const EventBase& e)
             }
             catch (const std::exception& exc)
             {
-                Res::Logger().Error("Exception in EventSystem HandleEvent: EventType: "
+                log.Error("Exception in EventSystem HandleEvent: EventType: "
                     + std::to_string(static_cast<int>(e.GetType())) + " Message: " + exc.what());
             }
         }
-        if (handledCount == 0)
+        if (handledCount == 0 && debug)
         {
-            Res::Logger().Debug("Unhandled event with type: " + std::to_string(static_cast<int>(e.GetType())));
+            log.Debug("Unhandled event with type: " + std::to_string(static_cast<int>(e.GetType())));
         }
         if (!innerLoop)
         {
@@ -116,6 +116,7 @@ namespace Events
     typedef ChangeEvent<Action, EventTypes::actionChange, ActionFields> ActionChangeEvent;
     typedef ChangeEvent<Rule, EventTypes::ruleChange, RuleFields> RuleChangeEvent;
     typedef ChangeEvent<Device, EventTypes::deviceChange, DeviceFields> DeviceChangeEvent;
-    typedef ChangeEvent<Device, EventTypes::devicePropertyChange, std::string> DevicePropertyChangeEvent;
+    // Changed fields are the keys of all properties changed by one update
+    typedef ChangeEvent<Device, EventTypes::devicePropertyChange, std::vector<std::string>> DevicePropertyChangeEvent;
 } // namespace Events
 #endif
\ No newline at end of file
@@ -33,8 +33,7 @@ PostEventState LoadRequestHandler::HandleEvent(const WebsocketChannel::EventVari
     {
         const Events::SocketMessageEvent& messageEvent = absl::get<Events::SocketMessageEvent>(event);
 
-        nlohmann::json payload = messageEvent.GetJsonPayload();
-        if (payload.at("command") == "LOAD_REQ")
+        if (messageEvent.GetCommand() == "LOAD_REQ")
         {
             return HandleLoadRequest(messageEvent.GetConnection(), channel);
         }
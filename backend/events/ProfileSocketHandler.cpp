@@ -11,6 +11,22 @@
 #include "../communication/CookieVerify.h"
 #include "../database/UsersTable.h"
 
+constexpr const char* ProfileSocketHandler::s_checkPassword;
+constexpr const char* ProfileSocketHandler::s_changePassword;
+constexpr const char* ProfileSocketHandler::s_changePicture;
+constexpr const char* ProfileSocketHandler::s_getPicture;
+constexpr const char* ProfileSocketHandler::s_getUser;
+
+ProfileSocketHandler::ProfileSocketHandler(DBHandler& dbHandler, const Authenticator& authenticator)
+    : m_dbHandler(&dbHandler), m_authenticator(&authenticator), m_router("ProfileSocketHandler")
+{
+    m_router.AddCommand(s_checkPassword, &ProfileSocketHandler::CheckPassword);
+    m_router.AddCommand(s_changePassword, &ProfileSocketHandler::ChangePassword);
+    m_router.AddCommand(s_changePicture, &ProfileSocketHandler::ChangePicture);
+    m_router.AddCommand(s_getPicture, &ProfileSocketHandler::GetPicture);
+    m_router.AddCommand(s_getUser, &ProfileSocketHandler::GetUserInfo);
+}
+
 PostEventState ProfileSocketHandler::operator()(const WebsocketChannel::EventVariant& event, WebsocketChannel& channel)
 {
     if (absl::holds_alternative<Events::SocketMessageEvent>(event))
@@ -23,132 +39,136 @@ PostEventState ProfileSocketHandler::operator()(const WebsocketChannel::EventVar
 PostEventState ProfileSocketHandler::HandleSocketMessage(
     const Events::SocketMessageEvent& event, WebsocketChannel& channel)
 {
-    try
-    {
-        auto& db = m_dbHandler->GetDatabase();
-        UsersTable users;
+    return m_router.Dispatch(*this, event, channel);
+}
 
+PostEventState ProfileSocketHandler::CheckPassword(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    Res::Logger().Debug("ProfileSocketHandler", "Checking password");
+    if (event.GetUser().has_value())
+    {
         const nlohmann::json& payload = event.GetJsonPayload();
-        auto it = payload.find("command");
-        if (it == payload.end())
-        {
-            return PostEventState::notHandled;
-        }
+        const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
+        bool password_valid = ValidatePassword(userId, payload.at("pw"));
+        channel.Send(event.GetConnection(), nlohmann::json {{"pw", payload.at("pw")}, {"valid", password_valid}});
 
-        const std::string& command = *it;
-        if (command == s_checkPassword)
-        {
-            Res::Logger().Debug("ProfileSocketHandler", "Checking password");
-            if (event.GetUser().has_value())
-            {
-                const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
-                bool password_valid = ValidatePassword(userId, payload.at("pw"));
-                channel.Send(
-                    event.GetConnection(), nlohmann::json {{"pw", payload.at("pw")}, {"valid", password_valid}});
+        return PostEventState::handled;
+    }
+    return PostEventState::error;
+}
 
-                return PostEventState::handled;
-            }
-            return PostEventState::error;
-        }
-        else if (command == s_changePassword)
+PostEventState ProfileSocketHandler::ChangePassword(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    Res::Logger().Debug("ProfileSocketHandler", "Changing password");
+    PostEventState return_state = PostEventState::error;
+    if (event.GetUser().has_value())
+    {
+        const nlohmann::json& payload = event.GetJsonPayload();
+        bool success = false;
+        const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
+        bool password_valid = ValidatePassword(userId, payload.at("pw").at("old"));
+        //! \todo Need to check if admin or have user system
+        std::string new_password = payload.at("pw").at("new");
+        if (password_valid && new_password == payload.at("pw").at("rep"))
         {
-            Res::Logger().Debug("ProfileSocketHandler", "Changing password");
-            PostEventState return_state = PostEventState::error;
-            if (event.GetUser().has_value())
-            {
-                bool success = false;
-                const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
-                bool password_valid = ValidatePassword(userId, payload.at("pw").at("old"));
-                //! \todo Need to check if admin or have user system
-                std::string new_password = payload.at("pw").at("new");
-                if (password_valid && new_password == payload.at("pw").at("rep"))
-                {
-                    std::string hash = m_authenticator->CreatePasswordHash(new_password);
-
-                    // test password hash before writing
-                    if (m_authenticator->ValidatePassword(new_password, hash))
-                    {
-                        db(update(users).set(users.userPwhash = hash).where(users.userId == userId));
-                        success = true;
-                    }
-                    else
-                    {
-                        Res::Logger().Severe("Generated Password hash could not be validated");
-                    }
-                }
+            std::string hash = m_authenticator->CreatePasswordHash(new_password);
 
-                channel.Send(
-                    event.GetConnection(), nlohmann::json {{"pw", payload.at("pw").at("old")}, {"success", success}});
-                return_state = PostEventState::handled;
-            }
-            return return_state;
-        }
-        else if (command == s_changePicture)
-        {
-            Res::Logger().Debug("ProfileSocketHandler", "Changing picture");
-            PostEventState return_state = PostEventState::error;
-            if (event.GetUser().has_value() && payload.find("pic") != payload.end())
+            // test password hash before writing
+            if (m_authenticator->ValidatePassword(new_password, hash))
             {
-                std::string picture = payload.at("pic");
-                const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
-                db(update(users).set(users.picture = picture).where(users.userId == userId));
-                /// \todo Need to broadcast to only this user and not everyone!!!
-                channel.Broadcast(nlohmann::json {{"userid", userId}, {"pic", picture}});
-                return_state = PostEventState::handled;
+                m_dbHandler
+                    ->Write([&](DBHandler::DatabaseConnection& db) {
+                        UsersTable users;
+                        db(update(users).set(users.userPwhash = hash).where(users.userId == userId));
+                    })
+                    .get();
+                success = true;
             }
-            return return_state;
-        }
-        else if (command == s_getUser)
-        {
-            Res::Logger().Debug("ProfileSocketHandler", "Get user");
-            PostEventState return_state = PostEventState::error;
-            if (event.GetUser().has_value())
+            else
             {
-                const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
-                auto result = db(select(users.userName, users.picture).from(users).where(users.userId == userId));
-                if (!result.empty())
-                {
-                    auto& front = result.front();
-                    std::string username = front.userName;
-                    std::vector<uint8_t> blob(front.picture.blob, front.picture.blob + front.picture.len);
-                    std::string blob_str(blob.begin(), blob.end());
-                    return_state = PostEventState::handled;
-                    channel.Send(event.GetConnection(),
-                        nlohmann::json {{"user", username}, {"userid", userId}, {"pic", blob_str}});
-                }
+                Res::Logger().Severe("Generated Password hash could not be validated");
             }
-            return return_state;
         }
-        else if (command == s_getPicture)
+
+        channel.Send(event.GetConnection(), nlohmann::json {{"pw", payload.at("pw").at("old")}, {"success", success}});
+        return_state = PostEventState::handled;
+    }
+    return return_state;
+}
+
+PostEventState ProfileSocketHandler::ChangePicture(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    Res::Logger().Debug("ProfileSocketHandler", "Changing picture");
+    PostEventState return_state = PostEventState::error;
+    const nlohmann::json& payload = event.GetJsonPayload();
+    if (event.GetUser().has_value() && payload.find("pic") != payload.end())
+    {
+        std::string picture = payload.at("pic");
+        const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
+        m_dbHandler
+            ->Write([&](DBHandler::DatabaseConnection& db) {
+                UsersTable users;
+                db(update(users).set(users.picture = picture).where(users.userId == userId));
+            })
+            .get();
+        /// \todo Need to broadcast to only this user and not everyone!!!
+        channel.Broadcast(nlohmann::json {{"userid", userId}, {"pic", picture}});
+        return_state = PostEventState::handled;
+    }
+    return return_state;
+}
+
+PostEventState ProfileSocketHandler::GetUserInfo(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    Res::Logger().Debug("ProfileSocketHandler", "Get user");
+    PostEventState return_state = PostEventState::error;
+    if (event.GetUser().has_value())
+    {
+        DBHandler::ReadConnection connection = m_dbHandler->GetReadConnection();
+        auto& db = *connection;
+        UsersTable users;
+        const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
+        auto result = db(select(users.userName, users.picture).from(users).where(users.userId == userId));
+        if (!result.empty())
         {
-            Res::Logger().Debug("ProfileSocketHandler", "Get picture");
-            PostEventState return_state = PostEventState::error;
-            if (event.GetUser().has_value())
-            {
-                const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
-                auto result = db(select(users.picture).from(users).where(users.userId == userId));
-                if (result.empty())
-                {
-                    auto& front = result.front();
-                    std::string blob_str(front.picture.blob, front.picture.blob + front.picture.len);
-                    return_state = PostEventState::handled;
-                    channel.Send(event.GetConnection(), nlohmann::json {{"pic", blob_str}});
-                }
-            }
-            return return_state;
+            auto& front = result.front();
+            std::string username = front.userName;
+            std::vector<uint8_t> blob(front.picture.blob, front.picture.blob + front.picture.len);
+            std::string blob_str(blob.begin(), blob.end());
+            return_state = PostEventState::handled;
+            channel.Send(
+                event.GetConnection(), nlohmann::json {{"user", username}, {"userid", userId}, {"pic", blob_str}});
         }
     }
-    catch (const std::exception& e)
+    return return_state;
+}
+
+PostEventState ProfileSocketHandler::GetPicture(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    Res::Logger().Debug("ProfileSocketHandler", "Get picture");
+    PostEventState return_state = PostEventState::error;
+    if (event.GetUser().has_value())
     {
-        Res::Logger().Error("ProfileSocketHandler", std::string("Exception while processing message: ") + e.what());
-        return PostEventState::error;
+        DBHandler::ReadConnection connection = m_dbHandler->GetReadConnection();
+        auto& db = *connection;
+        UsersTable users;
+        const int64_t userId = event.GetUser().value().IActuallyReallyNeedTheIntegerNow();
+        auto result = db(select(users.picture).from(users).where(users.userId == userId));
+        if (!result.empty())
+        {
+            auto& front = result.front();
+            std::string blob_str(front.picture.blob, front.picture.blob + front.picture.len);
+            return_state = PostEventState::handled;
+            channel.Send(event.GetConnection(), nlohmann::json {{"pic", blob_str}});
+        }
     }
-    return PostEventState::notHandled;
+    return return_state;
 }
 
 bool ProfileSocketHandler::ValidatePassword(const int64_t userid, const std::string& password)
 {
-    auto& db = m_dbHandler->GetDatabase();
+    DBHandler::ReadConnection connection = m_dbHandler->GetReadConnection();
+    auto& db = *connection;
     UsersTable users;
     auto result = db(select(users.userPwhash).from(users).where(users.userId == userid));
     if (!result.empty())
@@ -2,13 +2,12 @@
 
 #include "../communication/WebsocketChannel.h"
 #include "../database/DBHandler.h"
+#include "CommandRouter.h"
 
 class ProfileSocketHandler
 {
 public:
-    ProfileSocketHandler(DBHandler& dbHandler, const Authenticator& authenticator)
-        : m_dbHandler(&dbHandler), m_authenticator(&authenticator)
-    {}
+    ProfileSocketHandler(DBHandler& dbHandler, const Authenticator& authenticator);
 
     PostEventState operator()(const WebsocketChannel::EventVariant& event, WebsocketChannel& channel);
 
@@ -23,7 +22,15 @@ public:
     static constexpr const char* s_getPicture = "GET_PICTURE";
     static constexpr const char* s_getUser = "GET_USER";
 
+private:
+    PostEventState CheckPassword(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState ChangePassword(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState ChangePicture(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetPicture(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetUserInfo(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+
 private:
     DBHandler* m_dbHandler;
     const Authenticator* m_authenticator;
+    CommandRouter<ProfileSocketHandler> m_router;
 };
@@ -0,0 +1,234 @@
+#include "PropertyDeltaHandler.h"
+
+#include <cassert>
+
+#include "../api/Resources.h"
+#include "../utility/AnyJson.h"
+#include "../utility/Logger.h"
+
+namespace
+{
+    int64_t CurrentTimestamp()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+} // namespace
+
+void PropertyDeltaHandler::Subscribe(connection_hdl connection, const std::vector<DeviceId>& devices,
+    const std::vector<std::string>& properties, bool binary, UserId user, WebsocketChannel& channel)
+{
+    Subscription subscription;
+    subscription.binary = binary;
+    subscription.devices.insert(devices.begin(), devices.end());
+    subscription.properties.insert(properties.begin(), properties.end());
+    const absl::flat_hash_set<std::string> snapshotProperties = subscription.properties;
+
+    // Blocks Flush until the snapshot is sent, so it always arrives before the deltas
+    std::lock_guard<std::mutex> sendLock(m_sendMutex);
+    {
+        // Registered before reading the snapshot, so changes made while reading are sent as deltas
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_subscriptions[connection] = std::move(subscription);
+    }
+
+    // Snapshot of subscribed properties
+    std::vector<Device> snapshotDevices;
+    if (devices.empty())
+    {
+        snapshotDevices = m_deviceStorage->GetAllDevices(user);
+    }
+    else
+    {
+        for (DeviceId id : devices)
+        {
+            absl::optional<Device> device = m_deviceStorage->GetDevice(id, user);
+            if (device)
+            {
+                snapshotDevices.push_back(std::move(*device));
+            }
+        }
+    }
+    const int64_t timestamp = CurrentTimestamp();
+    std::vector<std::pair<std::pair<DeviceId, std::string>, Delta>> snapshot;
+    for (const Device& device : snapshotDevices)
+    {
+        for (const auto& property : device.GetProperties().GetAll())
+        {
+            if (snapshotProperties.empty() || snapshotProperties.count(property.first))
+            {
+                snapshot.push_back({{device.GetId(), property.first}, Delta {property.second, timestamp}});
+            }
+        }
+    }
+    SendDeltas(connection, snapshot, "snapshot", binary, channel);
+}
+
+void PropertyDeltaHandler::Unsubscribe(connection_hdl connection)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_subscriptions.erase(connection);
+}
+
+PostEventState PropertyDeltaHandler::HandlePropertyChange(const Events::DevicePropertyChangeEvent& event)
+{
+    const Device& device = event.GetChanged();
+    if (device.GetId().GetValue() == 0)
+    {
+        return PostEventState::notHandled;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_subscriptions.empty())
+    {
+        return PostEventState::notHandled;
+    }
+    const int64_t timestamp = CurrentTimestamp();
+    bool handled = false;
+    for (const std::string& key : event.GetChangedFields())
+    {
+        if (key.empty())
+        {
+            continue;
+        }
+        const Delta delta {device.GetProperty(key), timestamp};
+        for (auto& subscription : m_subscriptions)
+        {
+            Subscription& s = subscription.second;
+            if ((s.devices.empty() || s.devices.count(device.GetId()))
+                && (s.properties.empty() || s.properties.count(key)))
+            {
+                s.pending[{device.GetId(), key}] = delta;
+                handled = true;
+            }
+        }
+    }
+    return handled ? PostEventState::handled : PostEventState::notHandled;
+}
+
+void PropertyDeltaHandler::Flush()
+{
+    struct PendingDeltas
+    {
+        connection_hdl connection;
+        bool binary;
+        std::vector<std::pair<std::pair<DeviceId, std::string>, Delta>> deltas;
+    };
+    std::vector<PendingDeltas> toSend;
+    // Held while sending, so deltas of one connection are never sent out of order
+    std::lock_guard<std::mutex> sendLock(m_sendMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_subscriptions.begin(); it != m_subscriptions.end();)
+        {
+            if (it->first.expired())
+            {
+                // Connection was closed without unsubscribing
+                it = m_subscriptions.erase(it);
+                continue;
+            }
+            if (!it->second.pending.empty())
+            {
+                toSend.push_back(PendingDeltas {it->first, it->second.binary,
+                    std::vector<std::pair<std::pair<DeviceId, std::string>, Delta>>(
+                        it->second.pending.begin(), it->second.pending.end())});
+                it->second.pending.clear();
+            }
+            ++it;
+        }
+    }
+    if (toSend.empty())
+    {
+        return;
+    }
+    WebsocketChannel& channel = m_channelAccessor.Get();
+    for (const PendingDeltas& p : toSend)
+    {
+        SendDeltas(p.connection, p.deltas, "deltas", p.binary, channel);
+    }
+}
+
+void PropertyDeltaHandler::StartThread()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(!m_running);
+    m_running = true;
+    m_thread = std::thread(&PropertyDeltaHandler::Run, this);
+}
+
+void PropertyDeltaHandler::StopThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_running)
+    {
+        m_running = false;
+        m_cvRunning.notify_all();
+        lock.unlock();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+}
+
+void PropertyDeltaHandler::Run()
+{
+    Res::Logger().Info("PropertyDeltaHandler", "Thread started");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cvRunning.wait_for(lock, m_interval, [this]() { return !m_running; }))
+    {
+        lock.unlock();
+        try
+        {
+            Flush();
+        }
+        catch (const websocketpp::exception& e)
+        {
+            Res::Logger().Error("PropertyDeltaHandler", std::string("Websocket exception: ") + e.what());
+        }
+        catch (const std::exception& e)
+        {
+            Res::Logger().Error("PropertyDeltaHandler", std::string("Exception: ") + e.what());
+        }
+        lock.lock();
+    }
+    Res::Logger().Info("PropertyDeltaHandler", "Thread shutting down.");
+}
+
+void PropertyDeltaHandler::SendDeltas(connection_hdl connection,
+    const std::vector<std::pair<std::pair<DeviceId, std::string>, Delta>>& deltas, const char* type, bool binary,
+    WebsocketChannel& channel)
+{
+    if (binary)
+    {
+        // All frames in one websocket message
+        std::string data;
+        for (const auto& d : deltas)
+        {
+            messages::ChannelMessage message;
+            messages::PropertyChange* change = message.mutable_property_change();
+            change->set_device_id(d.first.first.GetValue());
+            change->set_key(d.first.second);
+            if (!d.second.value.is_null())
+            {
+                *change->mutable_value() = JsonToAnyOrDump(d.second.value);
+            }
+            change->set_timestamp(d.second.timestamp);
+            data += EncodeChannelFrame(channel.GetName(), message);
+        }
+        if (!data.empty())
+        {
+            channel.SendBytes(connection, data.data(), data.size());
+        }
+    }
+    else
+    {
+        nlohmann::json array = nlohmann::json::array();
+        for (const auto& d : deltas)
+        {
+            array.push_back({{"id", d.first.first.GetValue()}, {"key", d.first.second}, {"value", d.second.value},
+                {"ts", d.second.timestamp}});
+        }
+        channel.Send(connection, nlohmann::json {{type, std::move(array)}});
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef _PROPERTY_DELTA_HANDLER_H
+#define _PROPERTY_DELTA_HANDLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <json.hpp>
+
+#include "Events.h"
+
+#include "../api/DeviceStorage.h"
+#include "../communication/WebsocketCommunication.h"
+#include "../config/Timings.h"
+
+// Pushes property changes to websocket clients which subscribed to a set of devices and properties.
+// Changes are coalesced per client and sent once per interval as {"deltas": [{id, key, value, ts}]}.
+// Binary subscribers receive one PropertyChange frame per delta instead.
+class PropertyDeltaHandler
+{
+public:
+    using connection_hdl = WebsocketChannel::connection_hdl;
+
+public:
+    PropertyDeltaHandler(WebsocketChannelAccessor devicesChannelAccessor, DeviceStorage& deviceStorage,
+        std::chrono::milliseconds interval = Timings::PropertyDeltaInterval())
+        : m_channelAccessor(std::move(devicesChannelAccessor)), m_deviceStorage(&deviceStorage), m_interval(interval)
+    {}
+    // Stops thread
+    ~PropertyDeltaHandler() { StopThread(); }
+
+    // Adds or replaces the subscription of connection and sends a snapshot of the current values.
+    // Empty devices or properties subscribe to all.
+    void Subscribe(connection_hdl connection, const std::vector<DeviceId>& devices,
+        const std::vector<std::string>& properties, bool binary, UserId user, WebsocketChannel& channel);
+    // Removes the subscription of connection, pending deltas are discarded
+    void Unsubscribe(connection_hdl connection);
+
+    // Records the change for all matching subscriptions
+    PostEventState HandlePropertyChange(const Events::DevicePropertyChangeEvent& event);
+
+    // Sends all pending deltas
+    void Flush();
+
+    // Starts thread, thread must not be running already
+    void StartThread();
+    // Stops thread if running
+    void StopThread();
+
+private:
+    struct Delta
+    {
+        nlohmann::json value;
+        int64_t timestamp;
+    };
+    struct Subscription
+    {
+        absl::flat_hash_set<DeviceId> devices;
+        absl::flat_hash_set<std::string> properties;
+        bool binary = false;
+        // Only the latest value of each device property is kept
+        absl::flat_hash_map<std::pair<DeviceId, std::string>, Delta> pending;
+    };
+
+private:
+    void Run();
+    void SendDeltas(connection_hdl connection,
+        const std::vector<std::pair<std::pair<DeviceId, std::string>, Delta>>& deltas, const char* type, bool binary,
+        WebsocketChannel& channel);
+
+private:
+    WebsocketChannelAccessor m_channelAccessor;
+    DeviceStorage* m_deviceStorage;
+    std::chrono::milliseconds m_interval;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    // Serializes sending of snapshots and deltas, locked before m_mutex
+    std::mutex m_sendMutex;
+    bool m_running = false;
+    std::condition_variable m_cvRunning;
+    std::map<connection_hdl, Subscription, std::owner_less<connection_hdl>> m_subscriptions;
+};
+
+#endif
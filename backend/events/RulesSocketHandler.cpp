@@ -8,7 +8,15 @@ constexpr const char* RulesSocketHandler::s_getRule;
 constexpr const char* RulesSocketHandler::s_removeRule;
 constexpr const char* RulesSocketHandler::s_getConditionTypes;
 
-RulesSocketHandler::RulesSocketHandler(const RuleStorage& ruleStorage) : m_ruleStorage(ruleStorage) {}
+RulesSocketHandler::RulesSocketHandler(const RuleStorage& ruleStorage)
+    : m_ruleStorage(ruleStorage), m_router("RulesSocketHandler")
+{
+    m_router.AddCommand(s_addRule, &RulesSocketHandler::AddRule);
+    m_router.AddCommand(s_getRules, &RulesSocketHandler::GetRules);
+    m_router.AddCommand(s_getRule, &RulesSocketHandler::GetRule);
+    m_router.AddCommand(s_removeRule, &RulesSocketHandler::RemoveRule);
+    m_router.AddCommand(s_getConditionTypes, &RulesSocketHandler::GetConditionTypes);
+}
 
 PostEventState RulesSocketHandler::operator()(const WebsocketChannel::EventVariant& event, WebsocketChannel& channel)
 {
@@ -22,73 +30,64 @@ PostEventState RulesSocketHandler::operator()(const WebsocketChannel::EventVaria
 PostEventState RulesSocketHandler::HandleSocketMessage(
     const Events::SocketMessageEvent& event, WebsocketChannel& channel)
 {
-    try
+    return m_router.Dispatch(*this, event, channel);
+}
+
+PostEventState RulesSocketHandler::AddRule(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    nlohmann::json ruleJson = event.GetJsonPayload().at("ruleJSON");
+    Rule rule = Rule::Parse(ruleJson);
+    m_ruleStorage.AddRule(rule, event.GetUser().value());
+    return PostEventState::handled;
+}
+
+PostEventState RulesSocketHandler::GetRules(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    std::vector<Rule> rules = m_ruleStorage.GetAllRules(Filter(), event.GetUser().value());
+    for (const Rule& rule : rules)
     {
-        const nlohmann::json& payload = event.GetJsonPayload();
-        auto it = payload.find("command");
-        if (it == payload.end())
-        {
-            return PostEventState::notHandled;
-        }
-        const std::string& command = *it;
-        // The command is to add a rule
-        if (command == s_addRule)
-        {
-            nlohmann::json ruleJson = payload.at("ruleJSON");
-            Rule rule = Rule::Parse(ruleJson);
-            m_ruleStorage.AddRule(rule, event.GetUser().value());
-            return PostEventState::handled;
-        }
-        else if (command == s_getRules)
-        {
-            std::vector<Rule> rules = m_ruleStorage.GetAllRules(Filter(), event.GetUser().value());
-            for (const Rule& rule : rules)
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"rule", rule.ToJson()}});
-            }
-            if (rules.empty())
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"rules", nlohmann::json::array()}});
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_getRule)
-        {
-            absl::optional<Rule> rule = m_ruleStorage.GetRule(payload.at("ruleId"), event.GetUser().value());
-            if (rule)
-            {
-                channel.Send(event.GetConnection(), nlohmann::json {{"rule", rule->ToJson()}});
-            }
-            else
-            {
-                // TODO: send rule not found
-            }
-            return PostEventState::handled;
-        }
-        else if (command == s_removeRule)
-        {
-            m_ruleStorage.RemoveRule(payload.at("ruleId"), event.GetUser().value());
-            return PostEventState::handled;
-        }
-        else if (command == s_getConditionTypes)
-        {
-            const auto& registered = Res::ConditionRegistry().GetRegistered();
-            nlohmann::json result = nlohmann::json::array();
-            for (std::size_t i = 0; i < registered.size(); ++i)
-            {
-                if (registered[i] != nullptr)
-                {
-                    result.push_back(nlohmann::json {{"id", i}, {"name", registered[i].name}});
-                }
-            }
-            channel.Send(event.GetConnection(), nlohmann::json {{"conditionTypes", result}});
-            return PostEventState::handled;
-        }
+        channel.Send(event.GetConnection(), nlohmann::json {{"rule", rule.ToJson()}});
     }
-    catch (const std::exception& e)
+    if (rules.empty())
     {
-        Res::Logger().Error("RulesSocketHandler", std::string("Exception while processing message: ") + e.what());
-        return PostEventState::error;
+        channel.Send(event.GetConnection(), nlohmann::json {{"rules", nlohmann::json::array()}});
     }
-    return PostEventState::notHandled;
+    return PostEventState::handled;
+}
+
+PostEventState RulesSocketHandler::GetRule(const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    absl::optional<Rule> rule
+        = m_ruleStorage.GetRule(event.GetJsonPayload().at("ruleId"), event.GetUser().value());
+    if (rule)
+    {
+        channel.Send(event.GetConnection(), nlohmann::json {{"rule", rule->ToJson()}});
+    }
+    else
+    {
+        // TODO: send rule not found
+    }
+    return PostEventState::handled;
+}
+
+PostEventState RulesSocketHandler::RemoveRule(const Events::SocketMessageEvent& event, WebsocketChannel&)
+{
+    m_ruleStorage.RemoveRule(event.GetJsonPayload().at("ruleId"), event.GetUser().value());
+    return PostEventState::handled;
+}
+
+PostEventState RulesSocketHandler::GetConditionTypes(
+    const Events::SocketMessageEvent& event, WebsocketChannel& channel)
+{
+    const auto& registered = Res::ConditionRegistry().GetRegistered();
+    nlohmann::json result = nlohmann::json::array();
+    for (std::size_t i = 0; i < registered.size(); ++i)
+    {
+        if (registered[i] != nullptr)
+        {
+            result.push_back(nlohmann::json {{"id", i}, {"name", registered[i].name}});
+        }
+    }
+    channel.Send(event.GetConnection(), nlohmann::json {{"conditionTypes", result}});
+    return PostEventState::handled;
 }
@@ -5,6 +5,7 @@
 #include "../api/IRuleSerialize.h"
 #include "../api/RuleStorage.h"
 #include "../communication/WebsocketChannel.h"
+#include "CommandRouter.h"
 
 class RulesSocketHandler
 {
@@ -22,8 +23,16 @@ public:
     static constexpr const char* s_removeRule = "DELETE_RULE";
     static constexpr const char* s_getConditionTypes = "GET_CONDITION_TYPES";
 
+private:
+    PostEventState AddRule(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetRules(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetRule(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState RemoveRule(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+    PostEventState GetConditionTypes(const Events::SocketMessageEvent& event, WebsocketChannel& channel);
+
 private:
     RuleStorage m_ruleStorage;
+    CommandRouter<RulesSocketHandler> m_router;
 };
 
 #endif
@@ -5,28 +5,33 @@
 Events::SocketMessageEvent Events::SocketMessageEvent::Parse(
     connection_hdl hdl, message_ptr msg, const Authenticator* authenticator)
 {
-    nlohmann::json payload;
+    // Parse without exceptions, so the payload is only lexed once
+    nlohmann::json payload = nlohmann::json::parse(msg->get_payload(), nullptr, false);
     absl::optional<UserId> user;
-    // Check if msg contains json
-    if (nlohmann::json::accept(msg->get_payload()))
+    if (payload.is_discarded())
     {
-        payload = nlohmann::json::parse(msg->get_payload());
-        if (authenticator)
+        payload = msg->get_payload();
+    }
+    else if (authenticator && payload.is_object())
+    {
+        auto idTokenIt = payload.find("idToken");
+        if (idTokenIt != payload.end() && idTokenIt->is_string())
         {
-            auto idTokenIt = payload.find("idToken");
-            if (idTokenIt != payload.end())
-            {
-                nlohmann::json idToken = authenticator->ValidateJWTToken(*idTokenIt);
-                if (idToken != nullptr && idToken.count("sub") != 0)
-                {
-                    user = UserId(std::stoll(idToken["sub"].get<std::string>()));
-                }
-            }
+            user = authenticator->ValidateUserToken(idTokenIt->get_ref<const std::string&>());
         }
     }
-    else
+    return SocketMessageEvent(std::move(hdl), std::move(msg), std::move(payload), std::move(user));
+}
+
+std::string Events::SocketMessageEvent::GetStringField(const nlohmann::json& json, const char* key)
+{
+    if (json.is_object())
     {
-        payload = msg->get_payload();
+        auto it = json.find(key);
+        if (it != json.end() && it->is_string())
+        {
+            return it->get<std::string>();
+        }
     }
-    return SocketMessageEvent(std::move(hdl), std::move(msg), std::move(payload), std::move(user));
+    return std::string();
 }
@@ -55,7 +55,12 @@ namespace Events
         using message_type = typename message_ptr::element_type;
 
         SocketMessageEvent(connection_hdl hdl, message_ptr msg, nlohmann::json payload, absl::optional<UserId> user)
-            : m_hdl(hdl), m_msg(std::move(msg)), m_payload(std::move(payload)), m_user(std::move(user))
+            : m_hdl(hdl),
+              m_msg(std::move(msg)),
+              m_payload(std::move(payload)),
+              m_user(std::move(user)),
+              m_channel(GetStringField(m_payload, "channel")),
+              m_command(GetStringField(m_payload, "command"))
         {}
 
         websocketpp::connection_hdl GetConnection() const { return m_hdl; }
@@ -64,15 +69,25 @@ namespace Events
         // If message payload is not convertible, contains string with payload
         const nlohmann::json& GetJsonPayload() const { return m_payload; }
         absl::optional<UserId> GetUser() const { return m_user; };
+        // Channel and command fields of the payload, extracted once for routing
+        // Empty if not present or not a string
+        const std::string& GetChannel() const { return m_channel; }
+        const std::string& GetCommand() const { return m_command; }
 
+        // Parses the payload only once, invalid json is kept as a string
         // Authenticator can be nullptr
         static SocketMessageEvent Parse(connection_hdl hdl, message_ptr msg, const Authenticator* authenticator);
 
+    private:
+        static std::string GetStringField(const nlohmann::json& json, const char* key);
+
     private:
         websocketpp::connection_hdl m_hdl;
         message_ptr m_msg;
         nlohmann::json m_payload;
         absl::optional<UserId> m_user;
+        std::string m_channel;
+        std::string m_command;
     };
 
 } // namespace Events
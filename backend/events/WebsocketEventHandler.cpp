@@ -1,20 +1,28 @@
 #include "WebsocketEventHandler.h"
 
+#include <chrono>
+
 #include "Events.h"
 #include "SocketEvents.h"
 
+#include "../utility/AnyJson.h"
+
 PostEventState DeviceWebsocketEventHandler::operator()(const Events::DeviceChangeEvent& event)
 {
     WebsocketChannel& devicesChannel = m_devicesChannel.Get();
     if (event.GetChangedFields() != Events::DeviceFields::REMOVE && event.GetChanged().GetId().GetValue() != 0)
     {
         const Device& device = event.GetChanged();
-        devicesChannel.Broadcast(nlohmann::json{{"device", device.ToJson()}});
+        messages::ChannelMessage message;
+        *message.mutable_device() = device.Serialize();
+        devicesChannel.Broadcast(nlohmann::json{{"device", device.ToJson()}}, message);
         return PostEventState::handled;
     }
     else if (event.GetChangedFields() == Events::DeviceFields::REMOVE)
     {
-        devicesChannel.Broadcast(nlohmann::json{{"deleteDevice", event.GetOld().GetId().GetValue()}});
+        messages::ChannelMessage message;
+        message.set_delete_device(event.GetOld().GetId().GetValue());
+        devicesChannel.Broadcast(nlohmann::json{{"deleteDevice", event.GetOld().GetId().GetValue()}}, message);
         return PostEventState::handled;
     }
     return PostEventState::notHandled;
@@ -26,9 +34,25 @@ PostEventState DeviceWebsocketEventHandler::operator()(const Events::DevicePrope
     const Device& device = event.GetChanged();
     if (device.GetId().GetValue() != 0 && !event.GetChangedFields().empty())
     {
-        devicesChannel.Broadcast(nlohmann::json{{"propertyChange",
-            {{"deviceId", device.GetId().GetValue()}, {"propertyKey", event.GetChangedFields()},
-                {"value", device.GetProperty(event.GetChangedFields())}}}});
+        const int64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+                                      .count();
+        // Clients expect one message per property
+        for (const std::string& key : event.GetChangedFields())
+        {
+            const nlohmann::json value = device.GetProperty(key);
+            messages::ChannelMessage message;
+            messages::PropertyChange* change = message.mutable_property_change();
+            change->set_device_id(device.GetId().GetValue());
+            change->set_key(key);
+            if (!value.is_null())
+            {
+                *change->mutable_value() = JsonToAnyOrDump(value);
+            }
+            change->set_timestamp(timestamp);
+            devicesChannel.Broadcast(nlohmann::json{{"propertyChange",
+                {{"deviceId", device.GetId().GetValue()}, {"propertyKey", key}, {"value", value}}}}, message);
+        }
 		return PostEventState::handled;
     }
 	return PostEventState::notHandled;
@@ -35,6 +35,34 @@ struct Arguments
      * \brief Whether debug mode is enabled.
      */
     bool m_debug = false;
+    /*!
+     * \brief Maximum number of read only database connections, at least one is used.
+     */
+    int m_dbReadConnections = 4;
+    /*!
+     * \brief SQLite synchronous mode (OFF, NORMAL, FULL or EXTRA).
+     */
+    std::string m_dbSynchronous = "NORMAL";
+    /*!
+     * \brief SQLite page cache size per connection, negative values are in KiB.
+     */
+    int64_t m_dbCacheSize = -2000;
+    /*!
+     * \brief Maximum bytes of the database file SQLite accesses through memory mapping.
+     */
+    int64_t m_dbMmapSize = 0;
+    /*!
+     * \brief Seconds between device snapshots, 0 disables the snapshot.
+     *
+     * The snapshot is also written on shutdown and loaded at startup if the database did not change.
+     */
+    int m_snapshotInterval = 0;
+    /*!
+     * \brief Milliseconds between batched log writes, 0 writes every message synchronously.
+     *
+     * Errors are still written immediately.
+     */
+    int m_logFlushInterval = 0;
 };
 
 #pragma endregion
@@ -83,6 +111,12 @@ inline bool CmdOptionExists(const char* const* begin, const char* const* end, co
  * \li -logDir logDir
  * \li -logL logLevel
  * \li -cLogL consoleLogLevel
+ * \li -dbReaders readConnections
+ * \li -dbSync synchronous
+ * \li -dbCache cacheSize
+ * \li -dbMmap mmapSize
+ * \li -snapshot snapshotInterval
+ * \li -logAsync logFlushInterval
  */
 inline Arguments ParseArguments(int argc, const char* const* args)
 {
@@ -91,7 +125,10 @@ inline Arguments ParseArguments(int argc, const char* const* args)
     {
         std::cout << "Usage: " << std::endl;
         std::cout << args[0] << " [-debug][-dir directory]"
-                  << "[-logDir logDir][-logL logLevel][-cLogL cLogLevel]" << std::endl;
+                  << "[-logDir logDir][-logL logLevel][-cLogL cLogLevel]"
+                  << "[-dbReaders readConnections][-dbSync synchronous][-dbCache cacheSize][-dbMmap mmapSize]"
+                  << "[-snapshot snapshotInterval][-logAsync logFlushInterval]"
+                  << std::endl;
         exit(0);
     }
     if (CmdOptionExists(args, args + argc, "-debug"))
@@ -122,6 +159,36 @@ inline Arguments ParseArguments(int argc, const char* const* args)
     {
         result.m_consoleLogLevel = static_cast<Logger::LogLevel>(atoi(cLogL));
     }
+    const char* dbReaders = GetCmdOption(args, args + argc, "-dbReaders");
+    if (dbReaders)
+    {
+        result.m_dbReadConnections = std::max(0, atoi(dbReaders));
+    }
+    const char* dbSync = GetCmdOption(args, args + argc, "-dbSync");
+    if (dbSync)
+    {
+        result.m_dbSynchronous = dbSync;
+    }
+    const char* dbCache = GetCmdOption(args, args + argc, "-dbCache");
+    if (dbCache)
+    {
+        result.m_dbCacheSize = atoll(dbCache);
+    }
+    const char* dbMmap = GetCmdOption(args, args + argc, "-dbMmap");
+    if (dbMmap)
+    {
+        result.m_dbMmapSize = atoll(dbMmap);
+    }
+    const char* snapshot = GetCmdOption(args, args + argc, "-snapshot");
+    if (snapshot)
+    {
+        result.m_snapshotInterval = std::max(0, atoi(snapshot));
+    }
+    const char* logAsync = GetCmdOption(args, args + argc, "-logAsync");
+    if (logAsync)
+    {
+        result.m_logFlushInterval = std::max(0, atoi(logAsync));
+    }
     return result;
 }
 
@@ -38,8 +38,9 @@ int main(int argc, char* argv[])
         signalHandler.SetMain(m);
         // Must be unique, otherwise light updates will not work
         UserId hueAPIId = UserId::Dummy(153523);
-        m.AddDeviceAPI(std::make_unique<HueAPI>(hueAPIId));
-        m.AddDeviceAPI(std::make_unique<TasmotaAPI>(UserId::Dummy(16738), m.GetDeviceStorage(), m.GetMQTT()));
+        m.AddDeviceAPI(std::make_unique<HueAPI>(hueAPIId, m.GetDeviceEvents()));
+        m.AddDeviceAPI(std::make_unique<TasmotaAPI>(
+            UserId::Dummy(16738), m.GetDeviceStorage(), m.GetDeviceEvents(), m.GetMQTT()));
 #ifdef HOMEPLUSPLUS_REMOTE_SOCKET
         m.AddDeviceAPI(std::make_unique<RemoteSocketAPI>(
             UserId::Dummy(21633), m.GetDBHandler(), m.GetSocketComm(), m.GetAuthenticator()));
@@ -49,17 +50,39 @@ int main(int argc, char* argv[])
 }
 #endif // MAIN_CPP_NO_MAIN_FUNCTION
 
+namespace
+{
+    DBConfig CreateDBConfig(const Arguments& args)
+    {
+        DBConfig config;
+        config.m_readConnections = static_cast<std::size_t>(args.m_dbReadConnections);
+        config.m_pragmas.m_synchronous = args.m_dbSynchronous;
+        config.m_pragmas.m_cacheSize = args.m_dbCacheSize;
+        config.m_pragmas.m_mmapSize = args.m_dbMmapSize;
+        config.m_deviceGeneration = args.m_snapshotInterval > 0;
+        return config;
+    }
+} // namespace
+
 Main::Main(const Arguments& args)
-    : m_dbHandler(args.m_directory + "/database/data.db"),
+    : m_dbHandler(args.m_directory + "/database/data.db", CreateDBConfig(args)),
       m_socketComm(&m_authenticator),
       m_shutdown(false),
       m_apiConfigDir(args.m_directory + "/config/plugins"),
       m_actionSer(m_dbHandler),
       m_ruleSer(m_dbHandler, m_actionSer),
       m_deviceSer(m_dbHandler, m_deviceTypes),
-      m_deviceReg(m_deviceSer, m_deviceEvents, m_propertyEvents)
+      m_deviceReg(m_deviceSer, m_deviceEvents, m_propertyEvents),
+      m_snapshot(args.m_directory + "/database/devices.snapshot"),
+      m_snapshotInterval(args.m_snapshotInterval)
 {
     Res::Logger().Open(args.m_logDir, args.m_logLevel, args.m_consoleLogLevel);
+    if (args.m_logFlushInterval > 0)
+    {
+        Logger::AsyncConfig logConfig;
+        logConfig.m_flushInterval = std::chrono::milliseconds(args.m_logFlushInterval);
+        Res::Logger().StartAsync(logConfig);
+    }
     // Res::NodeManager() = NodeManager(m_dbHandler, m_nodeComm);
 
     AddDeviceAPI(std::make_unique<CoreDeviceAPI>(m_dbHandler, m_deviceReg, m_deviceTypes, m_socketComm, m_actionSer,
@@ -90,20 +113,38 @@ int Main::Run()
         log.Info("Setup started.");
         // TODO: open database here
         m_dbHandler.CreateTables(m_authenticator);
+        LoadSnapshot();
         m_deviceReg.InitAPIs(
             m_apiConfigDir, Res::EventSystem(), Res::ConditionRegistry(), Res::ActionRegistry(), m_deviceTypes);
 
-        log.Info("Main loop started");
-        m_deviceReg.Start();
+        // The service is available as soon as the core api is ready, the other apis start when they are connected
+        m_deviceReg.Start("CORE");
         m_socketComm.Start();
+        m_deviceReg.Start();
+        // Devices of apis which failed to initialize are not loaded
+        m_deviceSer.ClearSnapshot();
+        log.Info("Main loop started");
 
         // Wait until shutdown message arrives
         std::unique_lock<std::mutex> lock(m_shutdownMutex);
-        m_cvShutdown.wait(lock, [this] { return m_shutdown; });
+        if (m_snapshotInterval.count() > 0)
+        {
+            while (!m_cvShutdown.wait_for(lock, m_snapshotInterval, [this] { return m_shutdown; }))
+            {
+                lock.unlock();
+                WriteSnapshot();
+                lock.lock();
+            }
+        }
+        else
+        {
+            m_cvShutdown.wait(lock, [this] { return m_shutdown; });
+        }
 
         m_socketComm.Stop();
 
         m_deviceReg.Shutdown();
+        WriteSnapshot();
     }
     catch (const std::exception& e)
     {
@@ -124,3 +165,34 @@ void Main::Stop()
     m_shutdown = true;
     m_cvShutdown.notify_all();
 }
+
+void Main::LoadSnapshot()
+{
+    if (m_snapshotInterval.count() == 0)
+    {
+        return;
+    }
+    absl::optional<messages::DeviceSnapshot> snapshot = m_snapshot.Read(m_deviceSer.GetGeneration());
+    if (snapshot)
+    {
+        m_deviceSer.SetSnapshot(*snapshot);
+        Res::Logger().Info(
+            "Main", "Loaded " + std::to_string(snapshot->devices_size()) + " devices from " + m_snapshot.GetFilename());
+    }
+}
+
+void Main::WriteSnapshot()
+{
+    if (m_snapshotInterval.count() == 0)
+    {
+        return;
+    }
+    try
+    {
+        m_snapshot.Write(m_deviceSer.CreateSnapshot());
+    }
+    catch (const std::exception& e)
+    {
+        Res::Logger().Error("Main", std::string("Failed to write snapshot: ") + e.what());
+    }
+}
\ No newline at end of file
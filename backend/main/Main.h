@@ -1,5 +1,6 @@
 #ifndef _MAIN_H
 #define _MAIN_H
+#include <chrono>
 #include <condition_variable>
 #include <map>
 #include <mutex>
@@ -15,6 +16,7 @@
 #include "../database/DBDeviceSerialize.h"
 #include "../database/DBHandler.h"
 #include "../database/DBRuleSerialize.h"
+#include "../database/DeviceSnapshot.h"
 #include "../events/LoadRequestHandler.h"
 
 /*!
@@ -71,6 +73,17 @@ public:
     Authenticator& GetAuthenticator() { return m_authenticator; }
     MQTT& GetMQTT() { return m_mqtt; }
     DeviceStorage& GetDeviceStorage() { return m_deviceReg.GetStorage(); }
+    EventEmitter<Events::DeviceChangeEvent>& GetDeviceEvents() { return m_deviceEvents; }
+
+private:
+    /*!
+     * \brief Passes the devices of a valid snapshot to the device serializer, before the device apis load them.
+     */
+    void LoadSnapshot();
+    /*!
+     * \brief Writes the current devices to the snapshot file, logs errors.
+     */
+    void WriteSnapshot();
 
 private:
     /*!
@@ -128,5 +141,13 @@ private:
      * \brief Serializes Rules from/to database.
      */
     DBRuleSerialize m_ruleSer;
+    /*!
+     * \brief Snapshot of the devices for faster startup.
+     */
+    DeviceSnapshot m_snapshot;
+    /*!
+     * \brief Time between snapshots, zero if snapshots are disabled.
+     */
+    std::chrono::seconds m_snapshotInterval;
 };
 #endif
\ No newline at end of file
@@ -8,63 +8,85 @@
 HueAPI* HueAPI::s_instance;
 
 #ifdef _MSC_VER
-HueAPI::HueAPI(UserId apiUser)
-    : handler(std::make_shared<WinHttpHandler>()), m_hue("", 80, "", handler), m_apiUser(apiUser)
+HueAPI::HueAPI(UserId apiUser, EventEmitter<Events::DeviceChangeEvent>& deviceChanges)
+    : handler(std::make_shared<WinHttpHandler>()),
+      m_hue("", 80, "", handler),
+      m_apiUser(apiUser),
+      m_deviceChanges(deviceChanges)
 {}
 #else
-HueAPI::HueAPI(UserId apiUser)
-    : handler(std::make_shared<LinHttpHandler>()), m_hue("", 80, "", handler), m_apiUser(apiUser)
+HueAPI::HueAPI(UserId apiUser, EventEmitter<Events::DeviceChangeEvent>& deviceChanges)
+    : handler(std::make_shared<LinHttpHandler>()),
+      m_hue("", 80, "", handler),
+      m_apiUser(apiUser),
+      m_deviceChanges(deviceChanges)
 {}
 #endif
 void HueAPI::Initialize(nlohmann::json& config)
 {
     s_instance = this;
+    if (!config.count("hue_mac"))
+    {
+        config["error"] = "Missing required field: hue_mac";
+        throw std::runtime_error("configuration error");
+    }
+}
+
+void HueAPI::Connect(nlohmann::json& config)
+{
+    // Bridge discovery takes several seconds, so it is not done in Initialize()
     HueFinder finder(handler);
-    if (config.count("hue_mac") && config.count("hue_username"))
+    if (config.count("hue_username"))
     {
         finder.AddUsername(config["hue_mac"], config["hue_username"]);
     }
 
-    if (config.count("hue_mac"))
+    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
+    if (config.count("hue_ip"))
     {
-        std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
-        if (config.count("hue_ip"))
-        {
-            bridges.push_back({config["hue_ip"], config["hue_mac"]});
-        }
-        std::string mac = config["hue_mac"];
-        auto pos = std::find_if(
-            bridges.begin(), bridges.end(), [&](const HueFinder::HueIdentification& hue) { return hue.mac == mac; });
-        if (pos != bridges.end())
-        {
-            m_hue = finder.GetBridge(*pos);
-            config["hue_username"] = m_hue.getUsername();
-            config.erase("error");
-        }
-        else
-        {
-            std::string error = "Did not find hue with specified mac, found: [";
-            for (const HueFinder::HueIdentification& hue : bridges)
-            {
-                error += hue.mac;
-                error += " at ";
-                error += hue.ip;
-                error += ", ";
-            }
-            error += "]";
-            config["error"] = error;
-
-            throw std::runtime_error("configuration error");
-        }
+        bridges.push_back({config["hue_ip"], config["hue_mac"]});
+    }
+    std::string mac = config["hue_mac"];
+    auto pos = std::find_if(
+        bridges.begin(), bridges.end(), [&](const HueFinder::HueIdentification& hue) { return hue.mac == mac; });
+    if (pos != bridges.end())
+    {
+        m_hue = finder.GetBridge(*pos);
+        config["hue_username"] = m_hue.getUsername();
+        config.erase("error");
     }
     else
     {
-        config["error"] = "Missing required field: hue_mac";
+        std::string error = "Did not find hue with specified mac, found: [";
+        for (const HueFinder::HueIdentification& hue : bridges)
+        {
+            error += hue.mac;
+            error += " at ";
+            error += hue.ip;
+            error += ", ";
+        }
+        error += "]";
+        config["error"] = error;
+
         throw std::runtime_error("configuration error");
     }
 }
 
-void HueAPI::RegisterEventHandlers(EventSystem&) {}
+void HueAPI::RegisterEventHandlers(EventSystem&)
+{
+    m_deviceChanges.AddHandler([this](const Events::DeviceChangeEvent& e) {
+        if (m_cancelled)
+        {
+            return PostEventState::shouldRemove;
+        }
+        std::lock_guard<std::mutex> lock(m_syncMutex);
+        if (m_sync)
+        {
+            m_sync->OnDeviceChange(e);
+        }
+        return PostEventState::notHandled;
+    });
+}
 
 void HueAPI::RegisterRuleConditions(RuleConditions::Registry&) {}
 
@@ -81,33 +103,64 @@ void HueAPI::RegisterDeviceTypes(DeviceTypeRegistry& registry)
     registry.AddDeviceType(std::move(type));
 }
 
+void HueAPI::Start()
+{
+    std::lock_guard<std::mutex> lock(m_syncMutex);
+    if (m_sync)
+    {
+        m_sync->Start();
+    }
+}
+
+void HueAPI::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(m_syncMutex);
+    if (m_sync)
+    {
+        m_sync->Stop();
+    }
+}
+
+void HueAPI::Cancel()
+{
+    m_cancelled = true;
+}
+
 void HueAPI::SynchronizeDevices(DeviceStorage& storage)
 {
     std::vector<std::reference_wrapper<HueLight>> lights = m_hue.getAllLights();
-    std::vector<Device> devices = storage.GetApiDevices(GetAPIId(), m_apiUser);
     std::sort(lights.begin(), lights.end(), [](HueLight& l, HueLight& r) { return l.getId() < r.getId(); });
-    std::sort(devices.begin(), devices.end(),
-        [](Device& l, Device& r) { return l.GetProperty("lightId") < r.GetProperty("lightId"); });
+    absl::flat_hash_map<int, HueLight*> newLights;
+    for (HueLight& l : lights)
+    {
+        newLights.emplace(l.getId(), &l);
+    }
 
-    auto begin = lights.begin();
-    for (Device& d : devices)
+    for (Device& d : storage.GetApiDevices(GetAPIId(), m_apiUser))
     {
-        int lightId = d.GetProperty("lightId");
-        auto it = std::find_if(begin, lights.end(), [&](HueLight& l) { return l.getId() == lightId; });
-        if (it == lights.end())
+        auto it = newLights.find(d.GetProperty("lightId").get<int>());
+        if (it == newLights.end())
         {
             storage.RemoveDevice(d.GetId(), m_apiUser);
         }
         else
         {
-            // Add missing lights inbetween
-            std::for_each(begin, it, [&](HueLight& l) { storage.AddDevice(CreateDeviceFromLight(l), m_apiUser); });
-            UpdateDeviceFromLight(d, storage, *it);
-            storage.ChangeDevice(d, m_apiUser);
+            UpdateDeviceFromLight(d, storage, *it->second);
+            newLights.erase(it);
+        }
+    }
+    for (HueLight& l : lights)
+    {
+        if (newLights.count(l.getId()))
+        {
+            storage.AddDevice(CreateDeviceFromLight(l), m_apiUser);
         }
-        begin = it + 1;
     }
-    std::for_each(begin, lights.end(), [&](HueLight& l) { storage.AddDevice(CreateDeviceFromLight(l), m_apiUser); });
+
+    auto sync = std::make_unique<HueSync>(
+        handler, m_hue.getBridgeIP(), m_hue.getBridgePort(), m_hue.getUsername(), storage, GetAPIId(), m_apiUser);
+    std::lock_guard<std::mutex> lock(m_syncMutex);
+    m_sync = std::move(sync);
 }
 
 Device HueAPI::CreateDeviceFromLight(const HueLight& light) const
@@ -135,19 +188,35 @@ Device HueAPI::CreateDeviceFromLight(const HueLight& light) const
 
 void HueAPI::UpdateDeviceFromLight(Device& device, DeviceStorage& storage, const HueLight& light) const
 {
-    device.SetProperty("on", light.isOn(), storage, m_apiUser);
+    PropertyUpdate update;
+    // Properties the device type does not know should not drop the rest of the light state
+    update.SkipInvalid();
+    // Only properties which changed are written
+    const auto& properties = device.GetProperties().GetAll();
+    auto set = [&](const char* property, nlohmann::json value) {
+        auto current = properties.find(property);
+        if (current == properties.end() || current->second != value)
+        {
+            update.Set(property, std::move(value));
+        }
+    };
+    set("on", light.isOn());
     if (light.hasBrightnessControl())
     {
-        device.SetProperty("brightness", light.getBrightness(), storage, m_apiUser);
+        set("brightness", light.getBrightness());
     }
     if (light.hasColorControl())
     {
         auto p = light.getColorHueSaturation();
-        device.SetProperty("hue", p.first, storage, m_apiUser);
-        device.SetProperty("saturation", p.second, storage, m_apiUser);
+        set("hue", p.first);
+        set("saturation", p.second);
     }
     if (light.hasTemperatureControl())
     {
-        device.SetProperty("colorTemperature", light.getColorTemperature(), storage, m_apiUser);
+        set("colorTemperature", light.getColorTemperature());
+    }
+    if (!update.IsEmpty())
+    {
+        device.SetProperties(update, storage, m_apiUser);
     }
 }
\ No newline at end of file
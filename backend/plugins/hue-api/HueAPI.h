@@ -1,6 +1,9 @@
 #ifndef _HUE_API_H
 #define _HUE_API_H
 
+#include <atomic>
+#include <mutex>
+
 #include <Hue.h>
 #include <HueLight.h>
 #ifdef _MSC_VER
@@ -10,6 +13,7 @@
 #endif
 
 #include "HueDeviceType.h"
+#include "HueSync.h"
 
 #include "../../api/DeviceAPI.h"
 #include "../../api/DeviceStorage.h"
@@ -18,10 +22,18 @@
 class HueAPI : public IDeviceAPI
 {
 public:
-    HueAPI(UserId apiUser);
+    HueAPI(UserId apiUser, EventEmitter<Events::DeviceChangeEvent>& deviceChanges);
 
     void Initialize(nlohmann::json& config) override;
 
+    void Connect(nlohmann::json& config) override;
+
+    void Start() override;
+
+    void Shutdown() override;
+
+    void Cancel() override;
+
     void RegisterEventHandlers(EventSystem& evSys) override;
 
     void RegisterRuleConditions(RuleConditions::Registry& registry) override;
@@ -49,6 +61,13 @@ private:
     std::shared_ptr<IHttpHandler> handler; // needs to be before Hue m_hue!!!
     Hue m_hue;
     HueDeviceType* m_hueLightType;
+    EventEmitter<Events::DeviceChangeEvent>& m_deviceChanges;
+    // Created after the initial synchronization, locked by m_syncMutex because device changes are emitted on other
+    // threads
+    std::unique_ptr<HueSync> m_sync;
+    std::mutex m_syncMutex;
+    // Set if the api failed to connect, the device change handler removes itself
+    std::atomic<bool> m_cancelled {false};
 };
 
 #endif
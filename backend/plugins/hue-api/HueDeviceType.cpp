@@ -86,48 +86,68 @@ void HueDeviceType::OnUpdate(absl::string_view property, Device & device, UserId
     }
     if (property != "lightId")
     {
-        int lightId = device.GetProperty("lightId");
-        int brightness = device.GetProperty("brightness");
-        HueLight light = m_hue->getLight(lightId);
-        if (property == "on")
+        HueLight light = m_hue->getLight(device.GetProperty("lightId"));
+        UpdateLight(property, device, light);
+    }
+}
+
+void HueDeviceType::OnUpdates(const std::vector<std::string>& properties, Device& device, UserId user) const
+{
+    if (user == m_apiUser)
+    {
+        // The changes were caused by external api requests, light is already updated
+        return;
+    }
+    // Only request the light state from the bridge once
+    HueLight light = m_hue->getLight(device.GetProperty("lightId"));
+    for (const std::string& property : properties)
+    {
+        if (property != "lightId")
+        {
+            UpdateLight(property, device, light);
+        }
+    }
+}
+
+void HueDeviceType::UpdateLight(absl::string_view property, Device& device, HueLight& light) const
+{
+    if (property == "on")
+    {
+        if (device.GetProperty("on"))
         {
-            if (device.GetProperty("on"))
-            {
-                light.On();
-            }
-            else
-            {
-                light.Off();
-            }
+            light.On();
         }
-        else if (property == "brightness")
+        else
         {
-            if (light.hasBrightnessControl())
-            {
-                light.setBrightness(brightness);
-            }
-            else if (brightness != 0)
-            {
-                light.On();
-            }
-            else
-            {
-                light.Off();
-            }
+            light.Off();
         }
-        else if (property == "hue" && light.hasColorControl())
+    }
+    else if (property == "brightness")
+    {
+        int brightness = device.GetProperty("brightness");
+        if (light.hasBrightnessControl())
         {
-            light.setColorHue(device.GetProperty("hue"));
+            light.setBrightness(brightness);
         }
-        else if (property == "saturation" && light.hasColorControl())
+        else if (brightness != 0)
         {
-            light.setColorSaturation(device.GetProperty("saturation"));
+            light.On();
         }
-        else if (property == "colorTemperature" && light.hasTemperatureControl())
+        else
         {
-            light.setColorTemperature(device.GetProperty("colorTemperature"));
+            light.Off();
         }
     }
+    else if (property == "hue" && light.hasColorControl())
+    {
+        light.setColorHue(device.GetProperty("hue"));
+    }
+    else if (property == "saturation" && light.hasColorControl())
+    {
+        light.setColorSaturation(device.GetProperty("saturation"));
+    }
+    else if (property == "colorTemperature" && light.hasTemperatureControl())
+    {
+        light.setColorTemperature(device.GetProperty("colorTemperature"));
+    }
 }
-
-
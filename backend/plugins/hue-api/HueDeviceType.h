@@ -13,6 +13,10 @@ public:
     const Metadata& GetDeviceMetadata() const override { return m_meta; }
     bool ValidateUpdate(absl::string_view property, const nlohmann::json& value, UserId user) const override;
     void OnUpdate(absl::string_view property, Device& device, UserId user) const override;
+    void OnUpdates(const std::vector<std::string>& properties, Device& device, UserId user) const override;
+
+private:
+    void UpdateLight(absl::string_view property, Device& device, HueLight& light) const;
 
 private:
     Metadata m_meta;
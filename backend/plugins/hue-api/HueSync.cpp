@@ -0,0 +1,160 @@
+#include "HueSync.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../api/Resources.h"
+#include "../../utility/Logger.h"
+
+constexpr std::chrono::milliseconds HueSync::s_minInterval;
+constexpr std::chrono::milliseconds HueSync::s_maxInterval;
+
+HueSync::HueSync(std::shared_ptr<const IHttpHandler> http, std::string ip, int port, const std::string& username,
+    DeviceStorage& storage, const char* apiId, UserId apiUser)
+    : m_http(std::move(http)),
+      m_ip(std::move(ip)),
+      m_port(port),
+      m_lightsUri("/api/" + username + "/lights"),
+      m_storage(&storage),
+      m_apiId(apiId),
+      m_apiUser(apiUser)
+{}
+
+HueSync::~HueSync()
+{
+    Stop();
+}
+
+void HueSync::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running)
+    {
+        m_running = true;
+        m_thread = std::thread(&HueSync::Run, this);
+    }
+}
+
+void HueSync::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_stop.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+std::size_t HueSync::Synchronize()
+{
+    nlohmann::json lights = m_http->GETJson(m_lightsUri, nlohmann::json::object(), m_ip, m_port);
+    if (!lights.is_object())
+    {
+        // Errors are returned as an array
+        throw std::runtime_error("HueSync: Unexpected response from bridge: " + lights.dump());
+    }
+    // Reset before loading, so changes during the load cause another reload
+    if (m_reload.exchange(false))
+    {
+        try
+        {
+            m_devices = m_storage->GetApiDevices(m_apiId, m_apiUser);
+        }
+        catch (...)
+        {
+            m_reload = true;
+            throw;
+        }
+    }
+    std::size_t changed = 0;
+    for (Device& device : m_devices)
+    {
+        const auto& properties = device.GetProperties().GetAll();
+        auto lightId = properties.find("lightId");
+        if (lightId == properties.end())
+        {
+            continue;
+        }
+        auto light = lights.find(std::to_string(lightId->second.get<int>()));
+        if (light == lights.end())
+        {
+            continue;
+        }
+        PropertyUpdate update = DiffLight(*light, device);
+        // Properties the device type rejects are skipped, so the device only changed if anything was written
+        if (!update.IsEmpty() && !device.GetProperties().Set(update, device, *m_storage, m_apiUser).empty())
+        {
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+void HueSync::OnDeviceChange(const Events::DeviceChangeEvent&)
+{
+    // Changed devices get new data in the storage, so the held devices would no longer be updated
+    m_reload = true;
+}
+
+PropertyUpdate HueSync::DiffLight(const nlohmann::json& light, const Device& device)
+{
+    PropertyUpdate update;
+    update.SkipInvalid();
+    auto state = light.find("state");
+    if (state == light.end() || !state->is_object())
+    {
+        return update;
+    }
+    const auto& properties = device.GetProperties().GetAll();
+    // State keys are only present if the light supports them
+    auto diff = [&](const char* key, const char* property) {
+        auto value = state->find(key);
+        if (value != state->end())
+        {
+            auto current = properties.find(property);
+            if (current == properties.end() || current->second != *value)
+            {
+                update.Set(property, *value);
+            }
+        }
+    };
+    diff("on", "on");
+    diff("bri", "brightness");
+    diff("hue", "hue");
+    diff("sat", "saturation");
+    diff("ct", "colorTemperature");
+    return update;
+}
+
+std::chrono::milliseconds HueSync::NextInterval(std::chrono::milliseconds current, bool changed)
+{
+    if (changed)
+    {
+        return s_minInterval;
+    }
+    return std::max(s_minInterval, std::min(current * 2, s_maxInterval));
+}
+
+void HueSync::Run()
+{
+    std::chrono::milliseconds interval = s_minInterval;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop.wait_for(lock, interval, [this] { return !m_running; }))
+    {
+        lock.unlock();
+        bool changed = false;
+        try
+        {
+            changed = Synchronize() != 0;
+        }
+        catch (const std::exception& e)
+        {
+            Res::Logger().Debug("HueSync", std::string("Failed to synchronize lights: ") + e.what());
+        }
+        interval = NextInterval(interval, changed);
+        lock.lock();
+    }
+}
\ No newline at end of file
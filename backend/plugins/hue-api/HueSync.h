@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <IHttpHandler.h>
+#include <json.hpp>
+
+#include "../../api/DeviceStorage.h"
+
+// Keeps the hue devices in sync with changes made outside of the program (e.g. with the hue app).
+// Fetches the state of all lights with one request and only updates properties which changed. The bridge is polled
+// every s_minInterval after changes and slower, up to s_maxInterval, while nothing changes.
+// The devices are loaded from the storage on the first synchronization and reloaded only after device changes.
+class HueSync
+{
+public:
+    static constexpr std::chrono::milliseconds s_minInterval {1000};
+    static constexpr std::chrono::milliseconds s_maxInterval {16000};
+
+public:
+    HueSync(std::shared_ptr<const IHttpHandler> http, std::string ip, int port, const std::string& username,
+        DeviceStorage& storage, const char* apiId, UserId apiUser);
+    ~HueSync();
+
+    HueSync(const HueSync&) = delete;
+    HueSync& operator=(const HueSync&) = delete;
+
+    // Starts polling on a separate thread
+    void Start();
+    // Stops polling, waits until a running synchronization is finished
+    void Stop();
+
+    // Fetches all lights and updates the devices which changed, returns the number of updated devices.
+    // Throws std::runtime_error if the bridge cannot be reached
+    std::size_t Synchronize();
+    // Reloads the devices on the next synchronization, called for every device change event
+    void OnDeviceChange(const Events::DeviceChangeEvent& event);
+
+    // Returns the properties of device which differ from the light state reported by the bridge
+    static PropertyUpdate DiffLight(const nlohmann::json& light, const Device& device);
+    // Returns the interval until the next poll
+    static std::chrono::milliseconds NextInterval(std::chrono::milliseconds current, bool changed);
+
+private:
+    void Run();
+
+private:
+    std::shared_ptr<const IHttpHandler> m_http;
+    std::string m_ip;
+    int m_port;
+    std::string m_lightsUri;
+    DeviceStorage* m_storage;
+    const char* m_apiId;
+    UserId m_apiUser;
+    // Devices which are compared with the lights, only accessed by Synchronize
+    std::vector<Device> m_devices;
+    // Set when devices were added, removed or changed, so m_devices is outdated
+    std::atomic<bool> m_reload {true};
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_stop;
+    bool m_running = false;
+};
\ No newline at end of file
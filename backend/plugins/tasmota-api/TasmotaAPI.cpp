@@ -1,9 +1,160 @@
 #include "TasmotaAPI.h"
 
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_replace.h>
 #include <absl/strings/str_split.h>
 #include <json.hpp>
 
-// #include <functional>
+namespace
+{
+    // Decodes the value of one top level key of a state or sensor message into property updates.
+    // Returns false if nothing in the value was recognized
+    using StateDecoder
+        = std::function<bool(const std::string& key, const nlohmann::json& value, PropertyUpdate& updates)>;
+
+    bool DecodeSwitch(const std::string& key, const nlohmann::json& value, PropertyUpdate& updates)
+    {
+        updates.Set(key, value == "ON");
+        return true;
+    }
+
+    bool DecodeValue(const std::string& key, const nlohmann::json& value, PropertyUpdate& updates)
+    {
+        updates.Set(key, value);
+        return true;
+    }
+
+    bool DecodeHsbColor(const std::string&, const nlohmann::json& value, PropertyUpdate& updates)
+    {
+        if (!value.is_string())
+        {
+            return false;
+        }
+        std::vector<std::string> values = absl::StrSplit(value.get_ref<const std::string&>(), ',');
+        if (values.size() != 3)
+        {
+            return false;
+        }
+        updates.Set("HSBColorHue", std::stoi(values[0]));
+        updates.Set("HSBColorSaturation", std::stoi(values[1]));
+        updates.Set("HSBColorBrightness", std::stoi(values[2]));
+        return true;
+    }
+
+    // Sensor values with the property each one is stored in
+    StateDecoder DecodeSensorFields(std::vector<std::pair<std::string, std::string>> fields)
+    {
+        return [fields = std::move(fields)](const std::string&, const nlohmann::json& value, PropertyUpdate& updates) {
+            bool found = false;
+            for (const std::pair<std::string, std::string>& field : fields)
+            {
+                auto it = value.find(field.first);
+                if (it != value.end())
+                {
+                    updates.Set(field.second, *it);
+                    found = true;
+                }
+            }
+            return found;
+        };
+    }
+
+    // Sensor values stored as sensor + field, with '.' replaced by '_' (PM2.5 -> PM2_5)
+    StateDecoder DecodeSensor(absl::string_view sensor, std::initializer_list<absl::string_view> fields)
+    {
+        std::vector<std::pair<std::string, std::string>> properties;
+        properties.reserve(fields.size());
+        for (absl::string_view field : fields)
+        {
+            properties.emplace_back(std::string(field), absl::StrCat(sensor, absl::StrReplaceAll(field, {{".", "_"}})));
+        }
+        return DecodeSensorFields(std::move(properties));
+    }
+
+    absl::flat_hash_map<std::string, StateDecoder> CreateStateDecoders()
+    {
+        absl::flat_hash_map<std::string, StateDecoder> decoders;
+        // Actuators
+        for (int i = 1; i <= 8; ++i)
+        {
+            decoders.emplace(absl::StrCat("POWER", i), DecodeSwitch);
+            decoders.emplace(absl::StrCat("PIR", i), DecodeSwitch);
+        }
+        for (const char* key : {"Dimmer", "Dimmer0", "Dimmer1", "Dimmer2", "Color", "White", "CT", "Scheme", "Speed"})
+        {
+            decoders.emplace(key, DecodeValue);
+        }
+        for (int i = 1; i <= 4; ++i)
+        {
+            for (const char* key : {"ShutterClose", "ShutterOpen", "ShutterStop", "ShutterPosition"})
+            {
+                decoders.emplace(absl::StrCat(key, i), DecodeValue);
+            }
+        }
+        decoders.emplace("HSBColor", DecodeHsbColor);
+
+        // Sensors
+        decoders.emplace("ANALOG", DecodeSensor("ANALOG", {"A0", "Temperature", "Illuminance"}));
+        decoders.emplace("AM2301", DecodeSensor("AM2301", {"Temperature", "Humidity"}));
+        // TODO add APDS9960Gesture
+        // {"Time":"2019-10-31T21:34:25","APDS9960":{"None":1}}
+        // {"Time":"2019-10-31T21:34:26","APDS9960":{"Right":1}}
+        decoders.emplace("APDS9960", DecodeSensor("APDS9960", {"Red", "Green", "Blue", "Ambient", "CCT", "Proximity"}));
+        decoders.emplace("BH1750", DecodeSensor("BH1750", {"Illuminance"}));
+        // MQTT Example
+        // {"Time":"2020-04-18T13:02:29","BME280":{"Temperature":22.3,"Humidity":36.8,"DewPoint":6.8,"Pressure":972.1},
+        // "PressureUnit":"hPa","TempUnit":"C"}
+        decoders.emplace("BME280", DecodeSensor("BME280", {"Temperature", "Humidity", "Pressure", "DewPoint"}));
+        decoders.emplace("BME680", DecodeSensor("BME680", {"Temperature", "Humidity", "Pressure", "Gas"}));
+        decoders.emplace("DHT11", DecodeSensor("DHT11", {"Temperature", "Humidity"}));
+        // DS18x20 -> complex
+        decoders.emplace("SR04", DecodeSensor("SR04", {"Distance"}));
+        decoders.emplace("HTU21", DecodeSensor("HTU21", {"Temperature", "Humidity"}));
+        decoders.emplace("LM75AD", DecodeSensor("LM75AD", {"Temperature"}));
+        decoders.emplace(
+            "MLX90614", DecodeSensorFields({{"OBJTMP", "MLX90614ObjectT"}, {"AMBTMP", "MLX90614AmbientT"}}));
+        decoders.emplace("MPU6050",
+            DecodeSensor("MPU6050",
+                {"Temperature", "AccelXAxis", "AccelYAxis", "AccelZAxis", "GyroXAxis", "GyroYAxis", "GyroZAxis", "Yaw",
+                    "Pitch", "Roll"}));
+        decoders.emplace("PMS5003",
+            DecodeSensor("PMS5003",
+                {"CF1", "CF2.5", "CF10", "PM1", "PM2.5", "PM10", "PB0.3", "PB0.5", "PB1", "PB2.5", "PB5", "PB10"}));
+        decoders.emplace("PN532", DecodeSensorFields({{"UID", "PN532UID"}, {"DATA", "PN532Data"}}));
+        decoders.emplace("SDS011", DecodeSensor("SDS011", {"PM2.5", "PM10"}));
+        decoders.emplace("SHT3X", DecodeSensor("SHT3X", {"Temperature", "Humidity"}));
+        StateDecoder tx23Speed = DecodeSensor("TX23Speed", {"Act", "Avg", "Min", "Max"});
+        StateDecoder tx23Dir = DecodeSensor("TX23Dir", {"Card", "Deg", "Avg", "AvgCard", "Min", "Max", "Range"});
+        decoders.emplace("TX23",
+            [tx23Speed, tx23Dir](const std::string& key, const nlohmann::json& value, PropertyUpdate& updates) {
+                auto speed = value.find("Speed");
+                if (speed != value.end())
+                {
+                    tx23Speed(key, *speed, updates);
+                }
+                auto dir = value.find("Dir");
+                if (dir != value.end())
+                {
+                    tx23Dir(key, *dir, updates);
+                }
+                return true;
+            });
+        decoders.emplace("TSL2561", DecodeSensor("TSL2561", {"Illuminance"}));
+        decoders.emplace("VL53L0X", DecodeSensor("VL53L0X", {"Distance"}));
+
+        // Other
+        // Prevent log output for normal state message
+        decoders.emplace("MqttCount", [](const std::string&, const nlohmann::json&, PropertyUpdate&) { return true; });
+        return decoders;
+    }
+} // namespace
 
 void TasmotaAPI::Initialize(nlohmann::json& config)
 {
@@ -21,10 +172,18 @@ void TasmotaAPI::Initialize(nlohmann::json& config)
     m_port = config["port"];
 }
 
-void TasmotaAPI::RegisterEventHandlers(EventSystem& evSys) {}
+void TasmotaAPI::RegisterEventHandlers(EventSystem& evSys)
+{
+    m_deviceChanges.AddHandler([this](const Events::DeviceChangeEvent& e) { return handleDeviceChange(e); });
+}
 
 void TasmotaAPI::Shutdown() {}
 
+void TasmotaAPI::Cancel()
+{
+    m_cancelled = true;
+}
+
 void TasmotaAPI::RegisterDeviceTypes(DeviceTypeRegistry& registry)
 {
     auto type = std::make_unique<TasmotaDeviceType>(m_mqtt.GetClient(m_ip, m_port), m_apiUser);
@@ -35,53 +194,41 @@ void TasmotaAPI::RegisterDeviceTypes(DeviceTypeRegistry& registry)
 void TasmotaAPI::SynchronizeDevices(DeviceStorage& storage)
 {
     std::vector<Device> devices = storage.GetApiDevices(GetAPIId(), m_apiUser);
+    std::unique_lock<std::mutex> lock(m_knownDevicesMutex);
     for (Device& d : devices)
     {
-        std::string nanme = d.GetName();
-        if (knownDevices.find(nanme) == knownDevices.end())
-        {
-            knownDevices.insert({nanme, d.GetId()});
-        }
+        m_knownDevices.emplace(d.GetName(), std::move(d));
     }
+    lock.unlock();
 
     auto& client = m_mqtt.GetClient(m_ip, m_port);
     client.Subscribe(
-        "stat/#", [&](int messageId, const std::string& topic, const std::string& payload, int qos, bool retain) {
-            return this->handleStatusMessages(messageId, topic, payload, qos, retain);
-        });
+        "stat/#", [&](const MQTTMessage& message) { return m_cancelled || this->handleStatusMessages(message); });
     client.Subscribe(
-        "tele/#", [&](int messageId, const std::string& topic, const std::string& payload, int qos, bool retain) {
-            return this->handleTelemetryMessages(messageId, topic, payload, qos, retain);
-        });
+        "tele/#", [&](const MQTTMessage& message) { return m_cancelled || this->handleTelemetryMessages(message); });
     // client.Subscribe("cmnd/#", this->);
 }
 
-bool TasmotaAPI::handleStatusMessages(
-    int messageId, const std::string& topic, const std::string& payload, int qos, bool retain)
+bool TasmotaAPI::handleStatusMessages(const MQTTMessage& message)
 {
-    std::vector<std::string> tokens = absl::StrSplit(topic, '/');
+    absl::Span<const absl::string_view> tokens = message.topicLevels;
     if (tokens.size() == 3)
     {
-        // std::string prefix = topic[0];
-        std::string deviceName = tokens[1];
-        std::string type = tokens[2];
+        // absl::string_view prefix = tokens[0];
+        absl::string_view deviceName = tokens[1];
+        absl::string_view type = tokens[2];
 
         if (type == "RESULT")
         {
-            auto deviceId = getDeviceId(deviceName);
-            if (deviceId.has_value())
+            absl::optional<Device> device = getDevice(deviceName);
+            if (device.has_value())
             {
-                auto opDevice = m_storage.GetDevice(deviceId.value(), m_apiUser);
-                if (opDevice.has_value())
+                nlohmann::json json = nlohmann::json::parse(message.payload.begin(), message.payload.end());
+                if (!handleStateUpdate(*device, json))
                 {
-                    auto device = opDevice.value();
-                    nlohmann::json json = nlohmann::json::parse(payload);
-                    if (!handleStateUpdate(device, json))
-                    {
-                        Res::Logger().Debug("TasmotaAPI",
-                            "Got unkownn stat RESULT data for device \"" + deviceName + "\" with type " + type
-                                + " payload: " + json.dump(1));
-                    }
+                    Res::Logger().Debug("TasmotaAPI",
+                        absl::StrCat("Got unkownn stat RESULT data for device \"", deviceName, "\" with type ", type,
+                            " payload: ", json.dump(1)));
                 }
             }
         }
@@ -97,89 +244,39 @@ bool TasmotaAPI::handleStatusMessages(
     }
     else
     {
-        std::string tokenString;
-        if (!topic.empty())
-        {
-            // Convert all but the last element to avoid a trailing ","
-            std::for_each(
-                tokens.begin(), tokens.end() - 1, [&](const std::string& piece) { tokenString += piece + ", "; });
-
-            // Now add the last element with no delimiter
-            tokenString += tokens.back();
-        }
-        Res::Logger().Warning(
-            "TasmotaAPI", "[stat] Unexpected number of tokens for topic " + topic + ", tokens: " + tokenString);
+        logUnexpectedTopic(message);
     }
     return false;
 }
 
-bool TasmotaAPI::handleTelemetryMessages(
-    int messageId, const std::string& topic, const std::string& payload, int qos, bool retain)
+bool TasmotaAPI::handleTelemetryMessages(const MQTTMessage& message)
 {
-    std::vector<std::string> tokens = absl::StrSplit(topic, '/');
+    absl::Span<const absl::string_view> tokens = message.topicLevels;
     if (tokens.size() == 3)
     {
-        // std::string prefix = topic[0];
-        std::string deviceName = tokens[1];
-        std::string type = tokens[2];
+        // absl::string_view prefix = tokens[0];
+        absl::string_view deviceName = tokens[1];
+        absl::string_view type = tokens[2];
 
-        if (!isDeviceKnown(deviceName))
+        absl::optional<Device> device = getDevice(deviceName);
+        if (!device.has_value())
         {
-            handleUnknownDevice(deviceName);
+            device = handleUnknownDevice(deviceName);
         }
 
         if (type == "LWT")
         {
             // handle Last Will and Testament
-            auto deviceId = getDeviceId(deviceName);
-            if (deviceId.has_value())
-            {
-                auto opDevice = m_storage.GetDevice(deviceId.value(), m_apiUser);
-                if (opDevice.has_value())
-                {
-                    auto device = opDevice.value();
-                    device.SetProperty("online", payload == "Online", m_storage, m_apiUser);
-                }
-            }
+            device->SetProperty("online", message.payload == "Online", m_storage, m_apiUser);
         }
-        else if (type == "SENSOR")
+        else if (type == "SENSOR" || type == "STATE")
         {
-            auto deviceId = getDeviceId(deviceName);
-            if (deviceId.has_value())
+            nlohmann::json json = nlohmann::json::parse(message.payload.begin(), message.payload.end());
+            if (!handleStateUpdate(*device, json))
             {
-                auto opDevice = m_storage.GetDevice(deviceId.value(), m_apiUser);
-                if (opDevice.has_value())
-                {
-                    auto device = opDevice.value();
-
-                    nlohmann::json json = nlohmann::json::parse(payload);
-                    if (!handleStateUpdate(device, json))
-                    {
-                        Res::Logger().Debug("TasmotaAPI",
-                            "Got unkownn tele SENSOR data for device \"" + deviceName + "\" with type " + type
-                                + " payload: " + json.dump(1));
-                    }
-                }
-            }
-        }
-        else if (type == "STATE")
-        {
-            auto deviceId = getDeviceId(deviceName);
-            if (deviceId.has_value())
-            {
-                auto opDevice = m_storage.GetDevice(deviceId.value(), m_apiUser);
-                if (opDevice.has_value())
-                {
-                    auto device = opDevice.value();
-
-                    nlohmann::json json = nlohmann::json::parse(payload);
-                    if (!handleStateUpdate(device, json))
-                    {
-                        Res::Logger().Debug("TasmotaAPI",
-                            "Got unkownn tele STATE data for device \"" + deviceName + "\" with type " + type
-                                + " payload: " + json.dump(1));
-                    }
-                }
+                Res::Logger().Debug("TasmotaAPI",
+                    absl::StrCat(
+                        "Got unkownn tele ", type, " data for device \"", deviceName, "\" payload: ", json.dump(1)));
             }
         }
 
@@ -198,34 +295,34 @@ bool TasmotaAPI::handleTelemetryMessages(
     }
     else
     {
-        std::string tokenString;
-        if (!tokens.empty())
-        {
-            // Convert all but the last element to avoid a trailing ","
-            std::for_each(
-                tokens.begin(), tokens.end() - 1, [&](const std::string& piece) { tokenString += piece + ", "; });
-
-            // Now add the last element with no delimiter
-            tokenString += tokens.back();
-        }
-        Res::Logger().Warning(
-            "TasmotaAPI", "[tele] Unexpected number of tokens for topic " + topic + ", tokens: " + tokenString);
+        logUnexpectedTopic(message);
     }
     return false;
 }
 
-void TasmotaAPI::handleUnknownDevice(std::string& name)
+void TasmotaAPI::logUnexpectedTopic(const MQTTMessage& message) const
 {
-    knownDevices.insert({name, m_storage.AddDevice(CreateDevice(name), m_apiUser)});
-
-    std::string payload {"10"};
-    std::string topic {"cmnd/" + name + "/Status"};
-    m_mqtt.Publish(topic, payload, m_ip, m_port);
+    Res::Logger().Warning("TasmotaAPI",
+        absl::StrCat("[", message.topicLevels.front(), "] Unexpected number of tokens for topic ", message.topic,
+            ", tokens: ", absl::StrJoin(message.topicLevels, ", ")));
 }
 
-bool TasmotaAPI::isDeviceKnown(std::string& name)
+Device TasmotaAPI::handleUnknownDevice(absl::string_view name)
 {
-    return knownDevices.find(name) != knownDevices.end();
+    std::string deviceName(name);
+    Device created = CreateDevice(deviceName);
+    DeviceId id = m_storage.AddDevice(created, m_apiUser);
+    // Still cached because created holds the data
+    Device device = m_storage.GetDevice(id, m_apiUser).value();
+    {
+        std::lock_guard<std::mutex> lock(m_knownDevicesMutex);
+        m_knownDevices.insert_or_assign(deviceName, device);
+    }
+
+    std::string payload {"10"};
+    std::string topic {"cmnd/" + deviceName + "/Status"};
+    m_mqtt.GetClient(m_ip, m_port).PublishAndForget(topic, payload);
+    return device;
 }
 
 Device TasmotaAPI::CreateDevice(const std::string& name) const
@@ -237,487 +334,74 @@ Device TasmotaAPI::CreateDevice(const std::string& name) const
         Properties::FromRawData(std::move(propertyMap), *m_devciceType), GetAPIId());
 }
 
-absl::optional<DeviceId> TasmotaAPI::getDeviceId(const std::string& name)
+absl::optional<Device> TasmotaAPI::getDevice(absl::string_view name)
 {
-    auto id = knownDevices.find(name);
-    if (id != knownDevices.end())
+    std::lock_guard<std::mutex> lock(m_knownDevicesMutex);
+    auto it = m_knownDevices.find(name);
+    if (it != m_knownDevices.end())
     {
-        return id->second;
+        return it->second;
     }
     return absl::nullopt;
 }
 
-bool TasmotaAPI::handleStateUpdate(Device& device, const nlohmann::json& json)
+PostEventState TasmotaAPI::handleDeviceChange(const Events::DeviceChangeEvent& event)
 {
-    bool handled = false;
-    // TODO need to handle removing properties
-    // Actuators
-    if (json.count("POWER1"))
-    {
-        device.SetProperty("POWER1", json["POWER1"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER2"))
-    {
-        device.SetProperty("POWER2", json["POWER2"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER3"))
-    {
-        device.SetProperty("POWER3", json["POWER3"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER4"))
-    {
-        device.SetProperty("POWER4", json["POWER4"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER5"))
-    {
-        device.SetProperty("POWER5", json["POWER5"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER6"))
-    {
-        device.SetProperty("POWER6", json["POWER6"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER7"))
-    {
-        device.SetProperty("POWER7", json["POWER7"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("POWER8"))
-    {
-        device.SetProperty("POWER8", json["POWER8"] == "ON", m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("Dimmer"))
-    {
-        device.SetProperty("Dimmer", json["Dimmer"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("Dimmer0"))
-    {
-        device.SetProperty("Dimmer0", json["Dimmer0"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("Dimmer1"))
-    {
-        device.SetProperty("Dimmer1", json["Dimmer1"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("Dimmer2"))
-    {
-        device.SetProperty("Dimmer2", json["Dimmer2"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("Color"))
-    {
-        device.SetProperty("Color", json["Color"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("White"))
-    {
-        device.SetProperty("White", json["White"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("CT"))
-    {
-        device.SetProperty("CT", json["CT"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("HSBColor"))
-    {
-        std::vector<std::string> values = absl::StrSplit(json["HSBColor"].get<std::string>(), ',');
-        if (values.size() == 3)
-        {
-            device.SetProperty("HSBColorHue", std::stoi(values[0]), m_storage, m_apiUser);
-            device.SetProperty("HSBColorSaturation", std::stoi(values[1]), m_storage, m_apiUser);
-            device.SetProperty("HSBColorBrightness", std::stoi(values[2]), m_storage, m_apiUser);
-            handled = true;
-        }
-    }
-    if (json.count("Scheme"))
-    {
-        device.SetProperty("Scheme", json["Scheme"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("Speed"))
-    {
-        device.SetProperty("Speed", json["Speed"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterClose1"))
-    {
-        device.SetProperty("ShutterClose1", json["ShutterClose1"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterClose2"))
-    {
-        device.SetProperty("ShutterClose2", json["ShutterClose2"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterClose3"))
-    {
-        device.SetProperty("ShutterClose3", json["ShutterClose3"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterClose4"))
-    {
-        device.SetProperty("ShutterClose4", json["ShutterClose4"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterOpen1"))
-    {
-        device.SetProperty("ShutterOpen1", json["ShutterOpen1"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterOpen2"))
-    {
-        device.SetProperty("ShutterOpen2", json["ShutterOpen2"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterOpen3"))
+    if (m_cancelled)
     {
-        device.SetProperty("ShutterOpen3", json["ShutterOpen3"], m_storage, m_apiUser);
-        handled = true;
+        return PostEventState::shouldRemove;
     }
-    if (json.count("ShutterOpen4"))
+    if (event.GetChangedFields() == Events::DeviceFields::ADD)
     {
-        device.SetProperty("ShutterOpen4", json["ShutterOpen4"], m_storage, m_apiUser);
-        handled = true;
+        // Devices of this api are only added by handleUnknownDevice
+        return PostEventState::notHandled;
     }
-    if (json.count("ShutterStop1"))
+    const bool removed = event.GetChangedFields() == Events::DeviceFields::REMOVE;
+    const DeviceId id = removed ? event.GetOld().GetId() : event.GetChanged().GetId();
+    std::lock_guard<std::mutex> lock(m_knownDevicesMutex);
+    // Device changes are rare, so searching all devices is fine
+    auto it = std::find_if(m_knownDevices.begin(), m_knownDevices.end(),
+        [&](const std::pair<const std::string, Device>& entry) { return entry.second.GetId() == id; });
+    if (it == m_knownDevices.end())
     {
-        device.SetProperty("ShutterStop1", json["ShutterStop1"], m_storage, m_apiUser);
-        handled = true;
+        return PostEventState::notHandled;
     }
-    if (json.count("ShutterStop2"))
+    if (removed)
     {
-        device.SetProperty("ShutterStop2", json["ShutterStop2"], m_storage, m_apiUser);
-        handled = true;
+        m_knownDevices.erase(it);
     }
-    if (json.count("ShutterStop3"))
-    {
-        device.SetProperty("ShutterStop3", json["ShutterStop3"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterStop4"))
-    {
-        device.SetProperty("ShutterStop4", json["ShutterStop4"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterPosition1"))
-    {
-        device.SetProperty("ShutterPosition1", json["ShutterPosition1"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterPosition2"))
-    {
-        device.SetProperty("ShutterPosition2", json["ShutterPosition2"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterPosition3"))
-    {
-        device.SetProperty("ShutterPosition3", json["ShutterPosition3"], m_storage, m_apiUser);
-        handled = true;
-    }
-    if (json.count("ShutterPosition4"))
-    {
-        device.SetProperty("ShutterPosition4", json["ShutterPosition4"], m_storage, m_apiUser);
-        handled = true;
-    }
-    // Sensors
-    if (json.count("ANALOG"))
-    {
-        handled = handlePropertyUpdate(device, "ANALOG", "A0", json);
-        if (!handled)
-        {
-            handled = handlePropertyUpdate(device, "ANALOG", "Temperature", json);
-            if (!handled)
-            {
-                handled = handlePropertyUpdate(device, "ANALOG", "Illuminance", json);
-            }
-        }
-    }
-    if (json.count("AM2301"))
-    {
-        handleTemperatureUpdate(device, "AM2301", json);
-        handleHumidityUpdate(device, "AM2301", json);
-    }
-    if (json.count("APDS9960"))
-    {
-        // TODO add APDS9960Gesture
-        // {"Time":"2019-10-31T21:34:25","APDS9960":{"None":1}}
-        // {"Time":"2019-10-31T21:34:26","APDS9960":{"Right":1}}
-        // {"Time":"2019-10-31T21:34:29","APDS9960":{"Down":1}}
-        // {"Time":"2019-10-31T21:34:29","APDS9960":{"Right":1}}
-        // {"Time":"2019-10-31T21:34:31","APDS9960":{"Left":1}}
-        // {"Time":"2019-10-31T21:34:33","APDS9960":{"Up":1}}
-        // {"Time":"2019-10-31T21:34:35","APDS9960":{"Down":1}}
-        handlePropertyUpdate(device, "APDS9960", "Red", json);
-        handlePropertyUpdate(device, "APDS9960", "Green", json);
-        handlePropertyUpdate(device, "APDS9960", "Blue", json);
-        handlePropertyUpdate(device, "APDS9960", "Ambient", json);
-        handlePropertyUpdate(device, "APDS9960", "CCT", json);
-        handlePropertyUpdate(device, "APDS9960", "Proximity", json);
-        handled = true;
-    }
-    if (json.count("BH1750"))
-    {
-        handlePropertyUpdate(device, "BH1750", "Illuminance", json);
-        handled = true;
-    }
-    if (json.count("BME280"))
-    {
-        // MQTT Example
-        // {"Time":"2020-04-18T13:02:29","BME280":{"Temperature":22.3,"Humidity":36.8,"DewPoint":6.8,"Pressure":972.1},"PressureUnit":"hPa","TempUnit":"C"}
-        handleTemperatureUpdate(device, "BME280", json);
-        handleHumidityUpdate(device, "BME280", json);
-        handlePressureUpdate(device, "BME280", json);
-        handlePropertyUpdate(device, "BME280", "DewPoint", json);
-        handled = true;
-    }
-    if (json.count("BME680"))
-    {
-        handleTemperatureUpdate(device, "BME680", json);
-        handleHumidityUpdate(device, "BME680", json);
-        handlePressureUpdate(device, "BME680", json);
-        handlePropertyUpdate(device, "BME680", "Gas", json);
-        handled = true;
-    }
-    if (json.count("DHT11"))
-    {
-        handleTemperatureUpdate(device, "DHT11", json);
-        handleHumidityUpdate(device, "DHT11", json);
-        handled = true;
-    }
-    // DS18x20 -> complex
-    if (json.count("SR04"))
-    {
-        handlePropertyUpdate(device, "SR04", "Distance", json);
-    }
-    if (json.count("HTU21"))
-    {
-        handleTemperatureUpdate(device, "HTU21", json);
-        handleHumidityUpdate(device, "HTU21", json);
-        handled = true;
-    }
-    if (json.count("LM75AD"))
-    {
-        handleTemperatureUpdate(device, "LM75AD", json);
-        handled = true;
-    }
-    if (json.count("MLX90614"))
-    {
-        if (json["MLX90614"].count("OBJTMP"))
-        {
-            device.SetProperty("MLX90614ObjectT", json["MLX90614"]["OBJTMP"], m_storage, m_apiUser);
-        }
-        if (json["MLX90614"].count("AMBTMP"))
-        {
-            device.SetProperty("MLX90614AmbientT", json["MLX90614"]["AMBTMP"], m_storage, m_apiUser);
-        }
-        handled = true;
-    }
-    if (json.count("MPU6050"))
+    else
     {
-        handleTemperatureUpdate(device, "MPU6050", json);
-        handlePropertyUpdate(device, "MPU6050", "AccelXAxis", json);
-        handlePropertyUpdate(device, "MPU6050", "AccelYAxis", json);
-        handlePropertyUpdate(device, "MPU6050", "AccelZAxis", json);
-        handlePropertyUpdate(device, "MPU6050", "GyroXAxis", json);
-        handlePropertyUpdate(device, "MPU6050", "GyroYAxis", json);
-        handlePropertyUpdate(device, "MPU6050", "GyroZAxis", json);
-        handlePropertyUpdate(device, "MPU6050", "Yaw", json);
-        handlePropertyUpdate(device, "MPU6050", "Pitch", json);
-        handlePropertyUpdate(device, "MPU6050", "Roll", json);
-        handled = true;
+        // The storage replaces the data of changed devices, keep the topic the device was found with
+        it->second = event.GetChanged();
     }
-    if (json.count("PMS5003"))
-    {
-        handlePropertyUpdate(device, "PMS5003", "CF1", json);
-        if (json["PMS5003"].count("CF2.5"))
-        {
-            device.SetProperty("PMS5003CF2_5", json["PMS5003"]["CF2.5"], m_storage, m_apiUser);
-        }
-        handlePropertyUpdate(device, "PMS5003", "CF10", json);
-
-        handlePropertyUpdate(device, "PMS5003", "PM1", json);
-        if (json["PMS5003"].count("PM2.5"))
-        {
-            device.SetProperty("PMS5003PM2_5", json["PMS5003"]["PM2.5"], m_storage, m_apiUser);
-        }
-        handlePropertyUpdate(device, "PMS5003", "PM10", json);
+    return PostEventState::handled;
+}
 
-        if (json["PMS5003"].count("PB0.3"))
-        {
-            device.SetProperty("PMS5003PB0_3", json["PMS5003"]["PB0.3"], m_storage, m_apiUser);
-        }
-        if (json["PMS5003"].count("PB0.5"))
-        {
-            device.SetProperty("PMS5003PB0_5", json["PMS5003"]["PB0.5"], m_storage, m_apiUser);
-        }
-        handlePropertyUpdate(device, "PMS5003", "PB1", json);
-        if (json["PMS5003"].count("PB2.5"))
-        {
-            device.SetProperty("PMS5003PB2_5", json["PMS5003"]["PB2.5"], m_storage, m_apiUser);
-        }
-        handlePropertyUpdate(device, "PMS5003", "PB5", json);
-        handlePropertyUpdate(device, "PMS5003", "PB10", json);
-    }
-    if (json.count("PN532"))
-    {
-        handlePropertyUpdate(device, "PN532", "UID", json);
-        if (json["PN532"].count("DATA"))
-        {
-            device.SetProperty("PN532Data", json["PN532"]["DATA"], m_storage, m_apiUser);
-        }
-        handled = true;
-    }
-    if (json.count("PIR1"))
-    {
-        device.SetProperty("PIR1", json["PIR1"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR2"))
-    {
-        device.SetProperty("PIR2", json["PIR2"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR3"))
-    {
-        device.SetProperty("PIR3", json["PIR3"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR4"))
-    {
-        device.SetProperty("PIR4", json["PIR4"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR5"))
-    {
-        device.SetProperty("PIR5", json["PIR5"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR6"))
-    {
-        device.SetProperty("PIR6", json["PIR6"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR7"))
-    {
-        device.SetProperty("PIR7", json["PIR7"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("PIR8"))
-    {
-        device.SetProperty("PIR8", json["PIR8"] == "ON", m_storage, m_apiUser);
-    }
-    if (json.count("SDS011"))
-    {
-        if (json["SDS011"].count("PM2.5"))
-        {
-            device.SetProperty("SDS011PM2_5", json["SDS011"]["PM2.5"], m_storage, m_apiUser);
-        }
-        handlePropertyUpdate(device, "SDS011", "PM10", json);
-    }
-    if (json.count("SHT3X"))
+bool TasmotaAPI::handleStateUpdate(Device& device, const nlohmann::json& json)
+{
+    static const absl::flat_hash_map<std::string, StateDecoder> decoders = CreateStateDecoders();
+    if (!json.is_object())
     {
-        handleTemperatureUpdate(device, "SHT3X", json);
-        handleHumidityUpdate(device, "SHT3X", json);
-        handled = true;
+        return false;
     }
-    if (json.count("TX23"))
+    bool handled = false;
+    PropertyUpdate updates;
+    // Unknown or mistyped sensor values should not drop the rest of the message
+    updates.SkipInvalid();
+    // TODO need to handle removing properties
+    for (auto it = json.begin(); it != json.end(); ++it)
     {
-        if (json["TX23"].count("Speed"))
+        auto decoder = decoders.find(it.key());
+        if (decoder != decoders.end() && decoder->second(it.key(), it.value(), updates))
         {
-            if (json["TX23"]["Speed"].count("Act"))
-            {
-                device.SetProperty("TX23SpeedAct", json["TX23"]["Speed"]["Act"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Speed"].count("Avg"))
-            {
-                device.SetProperty("TX23SpeedAvg", json["TX23"]["Speed"]["Avg"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Speed"].count("Min"))
-            {
-                device.SetProperty("TX23SpeedMin", json["TX23"]["Speed"]["Min"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Speed"].count("Max"))
-            {
-                device.SetProperty("TX23SpeedMax", json["TX23"]["Speed"]["Max"], m_storage, m_apiUser);
-            }
-        }
-        if (json["TX23"].count("Dir"))
-        {
-            if (json["TX23"]["Dir"].count("Card"))
-            {
-                device.SetProperty("TX23DirCard", json["TX23"]["Dir"]["Card"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Dir"].count("Deg"))
-            {
-                device.SetProperty("TX23DirDeg", json["TX23"]["Dir"]["Deg"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Dir"].count("Avg"))
-            {
-                device.SetProperty("TX23DirAvg", json["TX23"]["Dir"]["Avg"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Dir"].count("AvgCard"))
-            {
-                device.SetProperty("TX23DirAvgCard", json["TX23"]["Dir"]["AvgCard"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Dir"].count("Min"))
-            {
-                device.SetProperty("TX23DirMin", json["TX23"]["Dir"]["Min"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Dir"].count("Max"))
-            {
-                device.SetProperty("TX23DirMax", json["TX23"]["Dir"]["Max"], m_storage, m_apiUser);
-            }
-            if (json["TX23"]["Dir"].count("Range"))
-            {
-                device.SetProperty("TX23DirRange", json["TX23"]["Dir"]["Range"], m_storage, m_apiUser);
-            }
+            handled = true;
         }
-        handled = true;
-    }
-    if (json.count("TSL2561"))
-    {
-        handlePropertyUpdate(device, "TSL2561", "Illuminance", json);
-        handled = true;
-    }
-    if (json.count("VL53L0X"))
-    {
-        handlePropertyUpdate(device, "VL53L0X", "Distance", json);
-        handled = true;
     }
-
-    // Other
-    // Prevent log output for normal state message
-    if (json.count("MqttCount"))
+    if (!updates.IsEmpty())
     {
-        handled = true;
+        // One transaction and one change event for the whole message
+        device.SetProperties(updates, m_storage, m_apiUser);
     }
     return handled;
-}
-
-void TasmotaAPI::handleTemperatureUpdate(Device& device, const std::string& sensor, const nlohmann::json& json)
-{
-    handlePropertyUpdate(device, sensor, "Temperature", json);
-}
-
-void TasmotaAPI::handleHumidityUpdate(Device& device, const std::string& sensor, const nlohmann::json& json)
-{
-    handlePropertyUpdate(device, sensor, "Humidity", json);
-}
-
-void TasmotaAPI::handlePressureUpdate(Device& device, const std::string& sensor, const nlohmann::json& json)
-{
-    handlePropertyUpdate(device, sensor, "Pressure", json);
-}
-
-bool TasmotaAPI::handlePropertyUpdate(
-    Device& device, const std::string& sensor, const std::string& property, const nlohmann::json& json)
-{
-    if (json[sensor].count(property))
-    {
-        device.SetProperty(sensor + property, json[sensor][property], m_storage, m_apiUser);
-        return true;
-    }
-    return false;
 }
\ No newline at end of file
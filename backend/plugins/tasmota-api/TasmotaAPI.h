@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
 #include <set>
 #include <string>
 #include <thread>
@@ -14,12 +15,14 @@
 class TasmotaAPI : public IDeviceAPI
 {
 public:
-    TasmotaAPI(UserId apiUser, DeviceStorage& deviceStorage, MQTT& mqtt)
-        : m_apiUser {apiUser}, m_storage {deviceStorage}, m_mqtt(mqtt) {};
+    TasmotaAPI(UserId apiUser, DeviceStorage& deviceStorage, EventEmitter<Events::DeviceChangeEvent>& deviceChanges,
+        MQTT& mqtt)
+        : m_apiUser {apiUser}, m_storage {deviceStorage}, m_deviceChanges {deviceChanges}, m_mqtt(mqtt) {};
 
     void Initialize(nlohmann::json& config) override;
     void RegisterEventHandlers(EventSystem& evSys) override;
     void Shutdown() override;
+    void Cancel() override;
 
     void RegisterDeviceTypes(DeviceTypeRegistry& registry) override;
     void SynchronizeDevices(DeviceStorage& storage) override;
@@ -27,30 +30,36 @@ public:
     const char* GetAPIId() const noexcept override { return "TASMOTA_API0.0"; }
 
 private:
-    bool handleStatusMessages(
-        int messageId, const std::string& topic, const std::string& payload, int qos, bool retain);
-    bool handleTelemetryMessages(
-        int messageId, const std::string& topic, const std::string& payload, int qos, bool retain);
-    void handleUnknownDevice(std::string& name);
-    bool isDeviceKnown(std::string& name);
+    bool handleStatusMessages(const MQTTMessage& message);
+    bool handleTelemetryMessages(const MQTTMessage& message);
+    // Adds a device for a new topic and requests its status
+    Device handleUnknownDevice(absl::string_view name);
     Device CreateDevice(const std::string& name) const;
-    absl::optional<DeviceId> getDeviceId(const std::string& name);
+    absl::optional<Device> getDevice(absl::string_view name);
+    // Keeps the device handles up to date when devices are changed or removed elsewhere
+    PostEventState handleDeviceChange(const Events::DeviceChangeEvent& event);
+    // Logs topics which do not consist of prefix/device/type
+    void logUnexpectedTopic(const MQTTMessage& message) const;
+    // Decodes all known keys of a state or sensor message and applies them as one update
     bool handleStateUpdate(Device& device, const nlohmann::json& json);
-    void handleTemperatureUpdate(Device& device, const std::string& sensor, const nlohmann::json& json);
-    void handleHumidityUpdate(Device& device, const std::string& sensor, const nlohmann::json& json);
-    void handlePressureUpdate(Device& device, const std::string& sensor, const nlohmann::json& json);
-    bool handlePropertyUpdate(
-        Device& device, const std::string& sensor, const std::string& property, const nlohmann::json& json);
 
 private:
     UserId m_apiUser;
     DeviceStorage& m_storage;
+    EventEmitter<Events::DeviceChangeEvent>& m_deviceChanges;
     MQTT& m_mqtt;
     TasmotaDeviceType* m_devciceType;
     /*!
-     * \brief All known devices
+     * \brief All known devices by topic name, locked by m_knownDevicesMutex because messages are handled on multiple
+     * threads
+     *
+     * Holding the handles keeps the device data in the DeviceStorage cache, so a message does not need a storage
+     * lookup.
      */
-    absl::flat_hash_map<std::string, DeviceId> knownDevices;
+    absl::flat_hash_map<std::string, Device> m_knownDevices;
+    std::mutex m_knownDevicesMutex;
     std::string m_ip;
     int m_port;
+    // Set if the api failed to connect, handlers and subscriptions remove themselves
+    std::atomic<bool> m_cancelled {false};
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "TasmotaDeviceType.h"
 
-#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
 
 #include "../../api/Resources.h"
 #include "../../utility/Logger.h"
@@ -1084,81 +1084,91 @@ TasmotaDeviceType::TasmotaDeviceType(MQTTClient& mqttClient, UserId apiUser)
     };
 
     m_meta = Metadata(std::move(entries));
-}
-
-std::string jsonToString(const nlohmann::json& json)
-{
-    switch (json.type())
-    {
-    case nlohmann::json::value_t::null:
-        return "null";
-    case nlohmann::json::value_t::boolean:
-        return std::to_string(json.get<bool>());
-    case nlohmann::json::value_t::string:
-        return json;
-    case nlohmann::json::value_t::number_integer:
-        return std::to_string(json.get<int64_t>());
-    case nlohmann::json::value_t::number_unsigned:
-        return std::to_string(json.get<uint64_t>());
-    case nlohmann::json::value_t::number_float:
-        return std::to_string(json.get<double>());
-    // case nlohmann::json::value_t::object:
-    //     break;
-    // case nlohmann::json::value_t::array:
-    //     break;
-    // case nlohmann::json::value_t::discarded:
-    //     break;
-    default:
-        return "";
-    }
-}
 
-bool TasmotaDeviceType::ValidateUpdate(absl::string_view property, const nlohmann::json& value, UserId user) const
-{
-    if (absl::StartsWithIgnoreCase(property, "Dimmer"))
-    {
-        int i = value;
-        return i >= 0 && i <= 100;
-    }
-    else if (property == "White")
-    {
-        int i = value;
-        return i >= 1 && i <= 100;
-    }
-    else if (property == "CT")
-    {
-        int i = value;
-        return i >= 153 && i <= 500;
-    }
-    else if (property == "HSBColorHue")
-    {
-        int i = value;
-        return i >= 0 && i <= 360;
-    }
-    else if (property == "HSBColorSaturation")
+    for (int i = 1; i <= 8; ++i)
     {
-        int i = value;
-        return i >= 0 && i <= 100;
+        std::string power = absl::StrCat("POWER", i);
+        AddCommand(power, power, CommandFormat::onOff);
     }
-    else if (property == "HSBColorBrightness")
+    for (const char* dimmer : {"Dimmer", "Dimmer0", "Dimmer1", "Dimmer2"})
     {
-        int i = value;
-        return i >= 0 && i <= 100;
+        AddCommand(dimmer, dimmer, 0, 100);
     }
-    else if (property == "Scheme")
+    AddCommand("Color", "Color");
+    AddCommand("White", "White", 1, 100);
+    AddCommand("CT", "CT", 153, 500);
+    AddCommand("HSBColorHue", "HsbColor1", 0, 360);
+    AddCommand("HSBColorSaturation", "HsbColor2", 0, 100);
+    AddCommand("HSBColorBrightness", "HsbColor3", 0, 100);
+    AddCommand("Scheme", "Scheme", 0, 12);
+    AddCommand("Speed", "Speed", 1, 40);
+    for (int i = 1; i <= 4; ++i)
     {
-        int i = value;
-        return i >= 0 && i <= 12;
+        for (const char* shutter : {"ShutterClose", "ShutterOpen"})
+        {
+            std::string property = absl::StrCat(shutter, i);
+            AddCommand(property, property, CommandFormat::trigger);
+            m_commands[property].stopCommand = absl::StrCat("ShutterStop", i);
+        }
+        std::string position = absl::StrCat("ShutterPosition", i);
+        AddCommand(position, position, 0, 100);
     }
-    else if (property == "Speed")
+}
+
+void TasmotaDeviceType::AddCommand(std::string property, std::string command, CommandFormat format)
+{
+    PropertyCommand& entry = m_commands[std::move(property)];
+    entry.command = std::move(command);
+    entry.format = format;
+}
+
+void TasmotaDeviceType::AddCommand(std::string property, std::string command, int min, int max)
+{
+    PropertyCommand& entry = m_commands[std::move(property)];
+    entry.command = std::move(command);
+    entry.hasRange = true;
+    entry.min = min;
+    entry.max = max;
+}
+
+namespace
+{
+    // Appends the value as command payload
+    void AppendPayload(std::string& payload, const nlohmann::json& json)
     {
-        int i = value;
-        return i >= 1 && i <= 40;
+        switch (json.type())
+        {
+        case nlohmann::json::value_t::null:
+            payload.append("null");
+            break;
+        case nlohmann::json::value_t::boolean:
+            payload.push_back(json.get<bool>() ? '1' : '0');
+            break;
+        case nlohmann::json::value_t::string:
+            payload.append(json.get_ref<const std::string&>());
+            break;
+        case nlohmann::json::value_t::number_integer:
+            absl::StrAppend(&payload, json.get<int64_t>());
+            break;
+        case nlohmann::json::value_t::number_unsigned:
+            absl::StrAppend(&payload, json.get<uint64_t>());
+            break;
+        case nlohmann::json::value_t::number_float:
+            absl::StrAppend(&payload, json.get<double>());
+            break;
+        default:
+            break;
+        }
     }
-    else if (absl::StartsWithIgnoreCase(property, "ShutterPosition"))
+} // namespace
+
+bool TasmotaDeviceType::ValidateUpdate(absl::string_view property, const nlohmann::json& value, UserId user) const
+{
+    auto it = m_commands.find(property);
+    if (it != m_commands.end() && it->second.hasRange)
     {
         int i = value;
-        return i >= 0 && i <= 100;
+        return i >= it->second.min && i <= it->second.max;
     }
     return true;
 }
@@ -1170,79 +1180,65 @@ void TasmotaDeviceType::OnUpdate(absl::string_view property, Device& device, Use
         // The changes were caused by external api requests, light is already updated
         return;
     }
-    // if (changedPath != "lightId")
-    // {
-    std::string name = device.GetName();
-    if (property == "name")
+    // Reused between updates to avoid allocations
+    thread_local std::string topic;
+    thread_local std::string payload;
+    if (BuildCommand(property, device, topic, payload))
     {
-        // TODO how to get old name??
+        m_MQTTClient.PublishAndForget(topic, payload);
     }
+}
 
-    if (absl::StartsWithIgnoreCase(property, "POWER"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), device.GetProperty(property) ? "ON" : "OFF");
-    }
-    else if (absl::StartsWithIgnoreCase(property, "Dimmer"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::EqualsIgnoreCase(property, "Color"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/Color", jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::EqualsIgnoreCase(property, "White"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/White", jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::EqualsIgnoreCase(property, "CT"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/CT", jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::EqualsIgnoreCase(property, "HSBColorHue"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/HsbColor1", jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::EqualsIgnoreCase(property, "HSBColorSaturation"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/HsbColor2", jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::EqualsIgnoreCase(property, "HSBColorBrightness"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/HsbColor3", jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::StartsWithIgnoreCase(property, "Scheme"))
-    {
-        m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), jsonToString(device.GetProperty(property)));
-    }
-    else if (absl::StartsWithIgnoreCase(property, "Speed"))
+void TasmotaDeviceType::OnUpdates(const std::vector<std::string>& properties, Device& device, UserId user) const
+{
+    if (user == m_apiUser)
     {
-        m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), jsonToString(device.GetProperty(property)));
+        // The changes were caused by external api requests, light is already updated
+        return;
     }
-    else if (absl::StartsWithIgnoreCase(property, "ShutterClose"))
+    std::vector<PublishMessage> messages;
+    PublishMessage message;
+    for (const std::string& property : properties)
     {
-        if (device.GetProperty(property))
-        {
-            m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), "");
-        }
-        else
+        if (BuildCommand(property, device, message.topic, message.payload))
         {
-            m_MQTTClient.Publish("cmnd/" + name + "/ShutterStop" + std::string(property.substr(12)), "");
+            messages.push_back(message);
         }
     }
-    else if (absl::StartsWithIgnoreCase(property, "ShutterOpen"))
+    if (!messages.empty())
     {
-        if (device.GetProperty(property))
-        {
-            m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), "");
-        }
-        else
-        {
-            m_MQTTClient.Publish("cmnd/" + name + "/ShutterStop" + std::string(property.substr(12)), "");
-        }
+        m_MQTTClient.PublishBatch(messages);
     }
-    else if (absl::StartsWithIgnoreCase(property, "ShutterPosition"))
+}
+
+bool TasmotaDeviceType::BuildCommand(
+    absl::string_view property, const Device& device, std::string& topic, std::string& payload) const
+{
+    auto it = m_commands.find(property);
+    if (it == m_commands.end())
     {
-        m_MQTTClient.Publish("cmnd/" + name + "/" + std::string(property), jsonToString(device.GetProperty(property)));
+        return false;
     }
-}
-// }
+    const PropertyCommand& command = it->second;
+    // Current name, the same topic TasmotaAPI uses for the device after a restart
+    topic.assign("cmnd/");
+    topic.append(device.GetName());
+    topic.push_back('/');
+    payload.clear();
+    const nlohmann::json value = device.GetProperty(property);
+    switch (command.format)
+    {
+    case CommandFormat::value:
+        topic.append(command.command);
+        AppendPayload(payload, value);
+        break;
+    case CommandFormat::onOff:
+        topic.append(command.command);
+        payload.append(value.get<bool>() ? "ON" : "OFF");
+        break;
+    case CommandFormat::trigger:
+        topic.append(value.get<bool>() ? command.command : command.stopCommand);
+        break;
+    }
+    return true;
+}
\ No newline at end of file
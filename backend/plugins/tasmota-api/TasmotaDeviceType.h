@@ -1,5 +1,10 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
 #include "../../api/DeviceType.h"
 #include "../../communication/MQTTClient.h"
 
@@ -12,9 +17,44 @@ public:
     const Metadata& GetDeviceMetadata() const override { return m_meta; }
     bool ValidateUpdate(absl::string_view property, const nlohmann::json& value, UserId user) const override;
     void OnUpdate(absl::string_view property, Device& device, UserId user) const override;
+    // Sends the commands of all properties in one batch
+    void OnUpdates(const std::vector<std::string>& properties, Device& device, UserId user) const override;
+
+    // Writes the command topic and payload for the changed property into topic and payload.
+    // Returns false if no command is sent for the property
+    bool BuildCommand(absl::string_view property, const Device& device, std::string& topic, std::string& payload) const;
+
+private:
+    // How the property value is sent as command payload
+    enum class CommandFormat
+    {
+        // Value as text
+        value,
+        // ON or OFF
+        onOff,
+        // Empty payload to command if true, to stopCommand if false
+        trigger
+    };
+    // Validator and command for one property, built once with the type
+    struct PropertyCommand
+    {
+        // Command topic after the device prefix, empty if nothing is sent
+        std::string command;
+        CommandFormat format = CommandFormat::value;
+        std::string stopCommand;
+        // Accepted integer range, only checked if hasRange is set
+        bool hasRange = false;
+        int min = 0;
+        int max = 0;
+    };
+
+private:
+    void AddCommand(std::string property, std::string command, CommandFormat format = CommandFormat::value);
+    void AddCommand(std::string property, std::string command, int min, int max);
 
 private:
     Metadata m_meta;
     UserId m_apiUser;
     MQTTClient& m_MQTTClient;
+    absl::flat_hash_map<std::string, PropertyCommand> m_commands;
 };
\ No newline at end of file
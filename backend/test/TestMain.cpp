@@ -1,8 +1,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "api/Resources.h"
+#include "utility/Logger.h"
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleMock(&argc, argv);
+    // Logger is never opened in tests, file output would create log files in the working directory
+    Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+    Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
     return RUN_ALL_TESTS();
 }
\ No newline at end of file
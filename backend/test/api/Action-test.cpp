@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <sqlpp11/insert.h>
 
+#include "../database/WriterConnection.h"
 #include "../mocks/MockActionImpl.h"
 #include "../mocks/MockActionSerialize.h"
 #include "../mocks/MockDeviceSerialize.h"
@@ -292,7 +293,7 @@ TEST(SubActionRegistry, ParseDb)
     DBHandler dbHandler{":memory:"};
     SubActionsTable subActions;
     ActionsTable actions;
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db.execute(ActionsTable::createStatement);
     db.execute(SubActionsTable::createStatement);
     // action to satisfy foreign key
@@ -303,7 +304,7 @@ TEST(SubActionRegistry, ParseDb)
                 subActions.data = sqlpp::null));
 
     auto t = sqlpp::start_transaction(db);
-    UserHeldTransaction transaction{UserId{0x236}, t};
+    UserHeldTransaction transaction{UserId{0x236}, t, db};
     EXPECT_CALL(*i, Parse(Ref(db), _, Ref(transaction)));
     auto result = db(select(subActions.actionType, subActions.data,
         subActions.timeout, subActions.transition)
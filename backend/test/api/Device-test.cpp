@@ -0,0 +1,179 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../mocks/MockDeviceSerialize.h"
+#include "../mocks/MockDeviceType.h"
+#include "api/DeviceStorage.h"
+#include "api/Resources.h"
+#include "utility/Logger.h"
+
+class DeviceTest : public ::testing::Test
+{
+public:
+    DeviceTest()
+        : storage(deviceSerialize, deviceEvents, propertyEvents),
+          metadata({{"on", MetadataEntry::Builder()
+                                .SetType(MetadataEntry::DataType::boolean)
+                                .SetSave(MetadataEntry::DBSave::save)
+                                .Create()},
+              {"brightness", MetadataEntry::Builder()
+                                 .SetType(MetadataEntry::DataType::integer)
+                                 .SetSave(MetadataEntry::DBSave::save_log)
+                                 .Create()},
+              {"transition", MetadataEntry::Builder()
+                                 .SetType(MetadataEntry::DataType::integer)
+                                 .SetSave(MetadataEntry::DBSave::none)
+                                 .Create()}})
+    {
+        using namespace ::testing;
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+        propertyEvents.AddHandler(handler.AsStdFunction());
+        ON_CALL(deviceType, GetDeviceMetadata()).WillByDefault(ReturnRef(metadata));
+        ON_CALL(deviceType, ValidateUpdate(_, _, _)).WillByDefault(Return(true));
+
+        Device::Data data {"device", "icon", {}, "type", Properties::FromRawData({{"on", true}}, deviceType), "api"};
+        ON_CALL(deviceSerialize, GetDeviceData(deviceId, Matcher<UserId>(_))).WillByDefault(Return(data));
+    }
+
+    ::testing::NiceMock<MockDeviceSerialize> deviceSerialize;
+    ::testing::NiceMock<MockDeviceType> deviceType;
+    EventEmitter<Events::DeviceChangeEvent> deviceEvents;
+    EventEmitter<Events::DevicePropertyChangeEvent> propertyEvents;
+    ::testing::MockFunction<PostEventState(const Events::DevicePropertyChangeEvent&)> handler;
+    DeviceStorage storage;
+    Metadata metadata;
+    const DeviceId deviceId {3};
+    const UserId user = UserId::Dummy();
+};
+
+TEST_F(DeviceTest, SetProperties)
+{
+    using namespace ::testing;
+    Device device = storage.GetDevice(deviceId, user).value();
+
+    auto writesMatch = [](const std::vector<PropertyWrite>& writes) {
+        return writes.size() == 2 && writes[0].key == "on" && !writes[0].insert && !writes[0].log
+            && writes[1].key == "brightness" && writes[1].insert && writes[1].log;
+    };
+    // One transaction and one event for all saved properties
+    EXPECT_CALL(deviceSerialize, SetDeviceProperties(deviceId, Truly(writesMatch), _, Matcher<UserId>(user)));
+    EXPECT_CALL(deviceSerialize, SetDeviceProperty(_, _, _, Matcher<UserId>(_))).Times(0);
+    EXPECT_CALL(deviceSerialize, InsertDeviceProperty(_, _, _, Matcher<UserId>(_))).Times(0);
+    EXPECT_CALL(handler, Call(Truly([](const Events::DevicePropertyChangeEvent& e) {
+        return e.GetChangedFields() == std::vector<std::string> {"on", "brightness"};
+    }))).WillOnce(Return(PostEventState::handled));
+    // Device type is notified once with all changed properties
+    EXPECT_CALL(deviceType, OnUpdate(_, _, _)).Times(0);
+    EXPECT_CALL(deviceType, OnUpdates(std::vector<std::string> {"on", "brightness", "transition"}, _, user));
+
+    EXPECT_TRUE(device.SetProperties(
+        PropertyUpdate().Set("on", false).Set("brightness", 20).Set("transition", 4), storage, user));
+    EXPECT_EQ(false, device.GetProperty("on"));
+    EXPECT_EQ(20, device.GetProperty("brightness"));
+    EXPECT_EQ(4, device.GetProperty("transition"));
+}
+
+TEST_F(DeviceTest, SetPropertiesRejectsInvalid)
+{
+    using namespace ::testing;
+    Device device = storage.GetDevice(deviceId, user).value();
+
+    EXPECT_CALL(deviceSerialize, SetDeviceProperties(_, _, _, Matcher<UserId>(_))).Times(0);
+    EXPECT_CALL(handler, Call(_)).Times(0);
+    EXPECT_CALL(deviceType, OnUpdates(_, _, _)).Times(0);
+    // Wrong type
+    EXPECT_FALSE(device.SetProperties(PropertyUpdate().Set("on", false).Set("brightness", "a"), storage, user));
+    EXPECT_EQ(true, device.GetProperty("on"));
+    // Unknown property
+    EXPECT_FALSE(device.SetProperties(PropertyUpdate().Set("on", false).Set("unknown", 1), storage, user));
+    EXPECT_EQ(true, device.GetProperty("on"));
+    // Rejected by device type
+    EXPECT_CALL(deviceType, ValidateUpdate("brightness", _, user)).WillOnce(Return(false));
+    EXPECT_FALSE(device.SetProperties(PropertyUpdate().Set("on", false).Set("brightness", 300), storage, user));
+    EXPECT_EQ(true, device.GetProperty("on"));
+}
+
+TEST_F(DeviceTest, SetPropertiesSkipsInvalid)
+{
+    using namespace ::testing;
+    Device device = storage.GetDevice(deviceId, user).value();
+
+    EXPECT_CALL(deviceSerialize,
+        SetDeviceProperties(deviceId, Truly([](const std::vector<PropertyWrite>& writes) {
+            return writes.size() == 1 && writes[0].key == "on";
+        }),
+            _, Matcher<UserId>(user)));
+    EXPECT_CALL(handler, Call(_)).WillOnce(Return(PostEventState::handled));
+    EXPECT_CALL(deviceType, OnUpdates(std::vector<std::string> {"on"}, _, user));
+    // Wrong type and unknown property
+    EXPECT_FALSE(device.SetProperties(
+        PropertyUpdate().Set("on", false).Set("brightness", "a").Set("unknown", 1).SkipInvalid(), storage, user));
+    EXPECT_EQ(false, device.GetProperty("on"));
+}
+
+TEST_F(DeviceTest, OnUpdatesDefault)
+{
+    // Device type which only implements OnUpdate
+    class SingleUpdateType : public DeviceType
+    {
+    public:
+        absl::string_view GetName() const override { return "single"; }
+        const Metadata& GetDeviceMetadata() const override { return m_metadata; }
+        bool ValidateUpdate(absl::string_view, const nlohmann::json&, UserId) const override { return true; }
+        void OnUpdate(absl::string_view property, Device&, UserId) const override
+        {
+            m_updated.emplace_back(property);
+        }
+
+        Metadata m_metadata;
+        mutable std::vector<std::string> m_updated;
+    };
+    SingleUpdateType type;
+    Device device = storage.GetDevice(deviceId, user).value();
+
+    type.OnUpdates({"on", "brightness", "transition"}, device, user);
+    EXPECT_EQ((std::vector<std::string> {"on", "brightness", "transition"}), type.m_updated);
+    type.m_updated.clear();
+    type.OnUpdates({}, device, user);
+    EXPECT_TRUE(type.m_updated.empty());
+}
+
+TEST_F(DeviceTest, GetApiDevices)
+{
+    using namespace ::testing;
+    Device device = storage.GetDevice(deviceId, user).value();
+    Device::Data other {"other", "icon", {}, "type", Properties::FromRawData({{"on", false}}, deviceType), "api"};
+    Device::Data stored {"stored", "icon", {}, "type", Properties::FromRawData({{"on", true}}, deviceType), "api"};
+    EXPECT_CALL(deviceSerialize, GetAPIDevices(absl::string_view("api"), Matcher<UserId>(user)))
+        .WillOnce(Return(std::vector<std::pair<DeviceId, Device::Data>> {{deviceId, stored}, {DeviceId(4), other}}));
+    // Devices are not loaded one by one
+    EXPECT_CALL(deviceSerialize, GetDeviceData(_, Matcher<UserId>(_))).Times(0);
+
+    std::vector<Device> devices = storage.GetApiDevices("api", user);
+    ASSERT_EQ(2u, devices.size());
+    // Cached device keeps its data
+    EXPECT_EQ("device", devices[0].GetName());
+    device.SetName("renamed");
+    EXPECT_EQ("renamed", devices[0].GetName());
+    EXPECT_EQ(DeviceId(4), devices[1].GetId());
+    EXPECT_EQ("other", devices[1].GetName());
+    // New device is cached
+    EXPECT_EQ("other", storage.GetDevice(DeviceId(4), user).value().GetName());
+}
+
+TEST(PropertyUpdateTest, Set)
+{
+    PropertyUpdate update;
+    EXPECT_TRUE(update.IsEmpty());
+    EXPECT_FALSE(update.SkipsInvalid());
+    update.Set("a", 1).Set("b", 2).Set("a", 3);
+    EXPECT_FALSE(update.IsEmpty());
+    ASSERT_EQ(2u, update.GetSize());
+    // Setting a path again keeps its position and the last value
+    EXPECT_EQ("a", update.GetValues()[0].first);
+    EXPECT_EQ(3, update.GetValues()[0].second);
+    EXPECT_EQ("b", update.GetValues()[1].first);
+    EXPECT_EQ(2, update.GetValues()[1].second);
+    EXPECT_TRUE(update.SkipInvalid().SkipsInvalid());
+}
@@ -0,0 +1,151 @@
+#include <future>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../mocks/MockDeviceAPI.h"
+#include "../mocks/MockDeviceSerialize.h"
+#include "api/DeviceRegistry.h"
+#include "api/Resources.h"
+#include "utility/Logger.h"
+
+class DeviceRegistryTest : public ::testing::Test
+{
+public:
+    DeviceRegistryTest() : registry(deviceSerialize, deviceEvents, propertyEvents)
+    {
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+    }
+
+    // Registers a new api and returns it
+    ::testing::NiceMock<MockDeviceAPI>& AddAPI(const char* apiId)
+    {
+        auto api = std::make_unique<::testing::NiceMock<MockDeviceAPI>>(apiId);
+        ::testing::NiceMock<MockDeviceAPI>& result = *api;
+        registry.RegisterDeviceAPI(std::move(api));
+        return result;
+    }
+
+    void InitAPIs(std::chrono::milliseconds timeout = std::chrono::seconds(10))
+    {
+        registry.InitAPIs(configDir, evSys, condReg, subActReg, typeReg, timeout);
+    }
+
+    ::testing::NiceMock<MockDeviceSerialize> deviceSerialize;
+    EventEmitter<Events::DeviceChangeEvent> deviceEvents;
+    EventEmitter<Events::DevicePropertyChangeEvent> propertyEvents;
+    EventSystem evSys;
+    RuleConditions::Registry condReg;
+    SubActionRegistry subActReg;
+    DeviceTypeRegistry typeReg;
+    // Does not exist, so configs are neither loaded nor saved
+    const std::string configDir = "DeviceRegistry-test-missing";
+    DeviceRegistry registry;
+};
+
+TEST_F(DeviceRegistryTest, InitAPIs)
+{
+    using namespace ::testing;
+    MockDeviceAPI& a = AddAPI("a");
+    MockDeviceAPI& b = AddAPI("b");
+    {
+        InSequence s;
+        EXPECT_CALL(a, Initialize(_));
+        EXPECT_CALL(a, RegisterDeviceTypes(Ref(typeReg)));
+        EXPECT_CALL(a, RegisterRuleConditions(Ref(condReg)));
+        EXPECT_CALL(a, RegisterSubActions(Ref(subActReg)));
+        EXPECT_CALL(a, RegisterEventHandlers(Ref(evSys)));
+        EXPECT_CALL(b, Initialize(_));
+        EXPECT_CALL(b, RegisterDeviceTypes(Ref(typeReg)));
+        EXPECT_CALL(b, RegisterRuleConditions(Ref(condReg)));
+        EXPECT_CALL(b, RegisterSubActions(Ref(subActReg)));
+        EXPECT_CALL(b, RegisterEventHandlers(Ref(evSys)));
+    }
+    for (MockDeviceAPI* api : {&a, &b})
+    {
+        InSequence s;
+        EXPECT_CALL(*api, Connect(_));
+        EXPECT_CALL(*api, SynchronizeDevices(_));
+        EXPECT_CALL(*api, Start());
+    }
+    InitAPIs();
+    registry.Start();
+    EXPECT_EQ(2, registry.GetAllAPIs().size());
+}
+
+TEST_F(DeviceRegistryTest, InitializeFailed)
+{
+    using namespace ::testing;
+    MockDeviceAPI& a = AddAPI("a");
+    MockDeviceAPI& b = AddAPI("b");
+    EXPECT_CALL(a, Initialize(_)).WillOnce(Throw(std::runtime_error("error")));
+    EXPECT_CALL(a, Connect(_)).Times(0);
+    EXPECT_CALL(a, Start()).Times(0);
+    EXPECT_CALL(b, Start());
+    InitAPIs();
+    registry.Start();
+    ASSERT_EQ(1, registry.GetAllAPIs().size());
+    EXPECT_STREQ("b", registry.GetAllAPIs()[0]->GetAPIId());
+}
+
+TEST_F(DeviceRegistryTest, ConnectConcurrently)
+{
+    using namespace ::testing;
+    MockDeviceAPI& a = AddAPI("a");
+    MockDeviceAPI& b = AddAPI("b");
+    MockDeviceAPI& c = AddAPI("c");
+    std::promise<void> bConnected;
+    std::shared_future<void> bFuture = bConnected.get_future().share();
+    // a can only finish after b connected, so they have to run on different threads
+    EXPECT_CALL(a, Connect(_)).WillOnce(InvokeWithoutArgs([&] { bFuture.wait(); }));
+    EXPECT_CALL(b, Connect(_)).WillOnce(InvokeWithoutArgs([&] { bConnected.set_value(); }));
+    EXPECT_CALL(c, Connect(_)).WillOnce(Throw(std::runtime_error("error")));
+    EXPECT_CALL(a, Start());
+    EXPECT_CALL(b, Start());
+    EXPECT_CALL(c, SynchronizeDevices(_)).Times(0);
+    EXPECT_CALL(c, Start()).Times(0);
+    EXPECT_CALL(c, Cancel());
+    EXPECT_CALL(a, Cancel()).Times(0);
+    InitAPIs();
+    registry.Start();
+    ASSERT_EQ(2, registry.GetAllAPIs().size());
+    EXPECT_STREQ("a", registry.GetAllAPIs()[0]->GetAPIId());
+    EXPECT_STREQ("b", registry.GetAllAPIs()[1]->GetAPIId());
+}
+
+TEST_F(DeviceRegistryTest, Timeout)
+{
+    using namespace ::testing;
+    MockDeviceAPI& a = AddAPI("a");
+    MockDeviceAPI& b = AddAPI("b");
+    std::promise<void> release;
+    std::shared_future<void> releaseFuture = release.get_future().share();
+    std::promise<bool> storageCancelled;
+    std::future<bool> storageCancelledFuture = storageCancelled.get_future();
+    EXPECT_CALL(a, Connect(_)).WillOnce(InvokeWithoutArgs([releaseFuture] { releaseFuture.wait(); }));
+    EXPECT_CALL(a, SynchronizeDevices(_)).WillOnce(Invoke([&](DeviceStorage& storage) {
+        try
+        {
+            storage.GetAllDevices(UserId::Dummy());
+            storageCancelled.set_value(false);
+        }
+        catch (const std::runtime_error&)
+        {
+            storageCancelled.set_value(true);
+        }
+    }));
+    EXPECT_CALL(a, Start()).Times(0);
+    EXPECT_CALL(a, Cancel());
+    EXPECT_CALL(b, Start());
+    InitAPIs(std::chrono::milliseconds(50));
+    // The core api is started without waiting for the others
+    EXPECT_TRUE(registry.Start("b"));
+    registry.Start();
+    ASSERT_EQ(1, registry.GetAllAPIs().size());
+    EXPECT_STREQ("b", registry.GetAllAPIs()[0]->GetAPIId());
+    // Timed out api finishes later, but cannot use the storage anymore. The thread is joined on destruction
+    release.set_value();
+    EXPECT_TRUE(storageCancelledFuture.get());
+    EXPECT_FALSE(registry.Start("a"));
+}
\ No newline at end of file
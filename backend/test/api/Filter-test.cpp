@@ -0,0 +1,53 @@
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "api/Filter.h"
+
+TEST(Filter, Constructor)
+{
+    Filter empty;
+    EXPECT_EQ("", empty.getSearchString());
+    EXPECT_EQ(0, empty.getStartIndex());
+    EXPECT_EQ(0, empty.getMaxLength());
+
+    EXPECT_EQ("", empty.getGroup());
+    EXPECT_EQ(static_cast<uint64_t>(std::numeric_limits<int64_t>::max()), empty.getQueryLimit());
+
+    Filter f("lamp", 10, 20, "kitchen");
+    EXPECT_EQ("lamp", f.getSearchString());
+    EXPECT_EQ(10, f.getStartIndex());
+    EXPECT_EQ(20, f.getMaxLength());
+    EXPECT_EQ("kitchen", f.getGroup());
+    EXPECT_EQ(20u, f.getQueryLimit());
+
+    EXPECT_THROW(Filter("", -1, 0), std::invalid_argument);
+    EXPECT_THROW(Filter("", 0, -1), std::invalid_argument);
+}
+
+TEST(Filter, FromJson)
+{
+    {
+        Filter f = Filter::FromJson({{"command", "GET_DEVICES"}});
+        EXPECT_EQ("", f.getSearchString());
+        EXPECT_EQ(0, f.getStartIndex());
+        EXPECT_EQ(0, f.getMaxLength());
+    }
+    {
+        Filter f = Filter::FromJson({{"search", "light"}, {"start", 5}, {"max", 50}, {"group", "hall"}});
+        EXPECT_EQ("light", f.getSearchString());
+        EXPECT_EQ(5, f.getStartIndex());
+        EXPECT_EQ(50, f.getMaxLength());
+        EXPECT_EQ("hall", f.getGroup());
+    }
+    EXPECT_THROW(Filter::FromJson({{"start", -3}}), std::invalid_argument);
+}
+
+TEST(Filter, SearchPattern)
+{
+    EXPECT_EQ("%%", Filter().getSearchPattern());
+    EXPECT_EQ("%lamp%", Filter("lamp", 0, 0).getSearchPattern());
+    EXPECT_EQ("%a\\_b%", Filter("a_b", 0, 0).getSearchPattern());
+    EXPECT_EQ("%100\\%%", Filter("100%", 0, 0).getSearchPattern());
+    EXPECT_EQ("%a\\\\b%", Filter("a\\b", 0, 0).getSearchPattern());
+}
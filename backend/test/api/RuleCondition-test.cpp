@@ -4,6 +4,7 @@
 #include <sqlpp11/remove.h>
 #include <sqlpp11/update.h>
 
+#include "../database/WriterConnection.h"
 #include "../mocks/MockDeviceSerialize.h"
 #include "../mocks/MockRuleCondition.h"
 #include "../mocks/MockRuleSerialize.h"
@@ -192,11 +193,11 @@ TEST(RuleConstantCondition, ParseDb)
 {
     using namespace ::testing;
     DBHandler dbHandler {":memory:"};
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db.execute(RuleConditionsTable::createStatement);
     RuleConditionsTable ruleConditions;
     auto t = sqlpp::start_transaction(db);
-    UserHeldTransaction transaction(UserId(0x4326), t);
+    UserHeldTransaction transaction(UserId(0x4326), t, db);
     google::protobuf::Any any;
     google::protobuf::BoolValue value;
     std::vector<uint8_t> data;
@@ -1173,13 +1174,13 @@ TEST(RuleCompareCondition, ParseDb)
 {
     using namespace ::testing;
     DBHandler dbHandler {":memory:"};
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db.execute(RuleConditionsTable::createStatement);
     RuleConditionsTable ruleConditions;
     const uint64_t id = 2;
 
     auto t = sqlpp::start_transaction(db);
-    UserHeldTransaction transaction(UserId(0x4326), t);
+    UserHeldTransaction transaction(UserId(0x4326), t, db);
     google::protobuf::Any any;
     messages::RuleCompareConditionData value;
     std::vector<uint8_t> data;
@@ -1656,13 +1657,13 @@ TEST(RuleTimeCondition, ParseDb)
 {
     using namespace ::testing;
     DBHandler dbHandler {":memory:"};
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db.execute(RuleConditionsTable::createStatement);
     RuleConditionsTable ruleConditions;
     const uint64_t id = 2;
 
     auto t = sqlpp::start_transaction(db);
-    UserHeldTransaction transaction(UserId(0x4326), t);
+    UserHeldTransaction transaction(UserId(0x4326), t, db);
     auto selectStatement
         = select(ruleConditions.conditionId, ruleConditions.conditionType, ruleConditions.conditionData)
               .from(ruleConditions)
@@ -3,6 +3,7 @@
 #include <sqlpp11/remove.h>
 #include <sqlpp11/update.h>
 
+#include "../database/WriterConnection.h"
 #include "api/SubActionImpls.h"
 #include "database/ActionsTable.h"
 
@@ -92,7 +93,7 @@ TEST(NotificationImpl, ParseJSON)
 {
     using namespace ::testing;
     DBHandler dbHandler{":memory:"};
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db.execute(SubActionsTable::createStatement);
     SubActionsTable subActions;
     auto selectStatement = select(subActions.actionType, subActions.actorNode, subActions.actorId, subActions.val,
@@ -213,7 +214,7 @@ TEST(DeviceSetImpl, ParseJSON)
 {
     using namespace ::testing;
     DBHandler dbHandler{":memory:"};
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db.execute(SubActionsTable::createStatement);
     SubActionsTable subActions;
     auto selectStatement = select(subActions.actionType, subActions.actorNode, subActions.actorId, subActions.val,
@@ -1,3 +1,5 @@
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "communication/Authenticator.h"
@@ -39,5 +41,36 @@ TEST(Authenticator, ValidateJWTToken)
                            "e30.Et9HFtf9R3GEMA0IICOfFMVXY7kkTX1wr4qCyhIf58U"));
 }
 
+TEST(Authenticator, ValidateUserToken)
+{
+    Authenticator a;
+
+    EXPECT_EQ(absl::nullopt, a.ValidateUserToken(""));
+    EXPECT_EQ(absl::nullopt,
+        a.ValidateUserToken("eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9."
+                            "e30.Et9HFtf9R3GEMA0IICOfFMVXY7kkTX1wr4qCyhIf58U"));
+    // No subject
+    EXPECT_EQ(absl::nullopt, a.ValidateUserToken(a.CreateJWTToken({{"iss", "test"}})));
+    EXPECT_EQ(absl::nullopt, a.ValidateUserToken(a.CreateJWTToken({{"sub", "abc"}})));
+
+    const std::string token = a.CreateJWTToken({{"iss", "test"}, {"sub", "12"}});
+    EXPECT_EQ(UserId(12), a.ValidateUserToken(token));
+    // Cached
+    EXPECT_EQ(UserId(12), a.ValidateUserToken(token));
+
+    // Tokens evicted from the cache are still validated
+    std::vector<std::string> tokens;
+    for (std::size_t i = 0; i < Authenticator::s_tokenCacheSize + 2; ++i)
+    {
+        tokens.push_back(a.CreateJWTToken({{"sub", std::to_string(i)}}));
+        EXPECT_EQ(UserId(i), a.ValidateUserToken(tokens.back()));
+    }
+    for (std::size_t i = 0; i < tokens.size(); ++i)
+    {
+        EXPECT_EQ(UserId(i), a.ValidateUserToken(tokens[i]));
+    }
+    EXPECT_EQ(UserId(12), a.ValidateUserToken(token));
+}
+
 // TODO: TEST(Authenticator, ValidatePassword)
 // TODO: TEST(Authenticator, CreatePasswordHash)
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <mosquitto.h>
+
+#include "communication/MQTTClient.h"
+
+TEST(MQTTClient, PublishNotConnected)
+{
+    mosquitto_lib_init();
+    {
+        // Nothing listens on port 1, so the client is never connected
+        MQTTClient client("127.0.0.1", 1);
+        // QoS 0 messages are dropped
+        std::future<bool> dropped = client.Publish("test/topic", "payload");
+        ASSERT_EQ(std::future_status::ready, dropped.wait_for(std::chrono::seconds(0)));
+        EXPECT_FALSE(dropped.get());
+        // QoS 1 messages are queued until the client is connected
+        std::future<bool> queued = client.Publish("test/topic", "payload", 1);
+        EXPECT_EQ(std::future_status::timeout, queued.wait_for(std::chrono::seconds(0)));
+        EXPECT_NO_THROW(client.PublishAndForget("test/topic", "payload"));
+
+        // Wildcards are not allowed in published topics
+        EXPECT_THROW(client.Publish("test/#", "payload"), std::runtime_error);
+        EXPECT_THROW(client.PublishAndForget("test/#", "payload"), std::runtime_error);
+    }
+    mosquitto_lib_cleanup();
+}
+
+TEST(MQTTClient, PublishBatchNotConnected)
+{
+    mosquitto_lib_init();
+    {
+        MQTTClient client("127.0.0.1", 1);
+        std::vector<PublishMessage> messages(2);
+        messages[0].topic = "test/first";
+        messages[0].payload = "1";
+        messages[1].topic = "test/second";
+        messages[1].qos = 1;
+        EXPECT_NO_THROW(client.PublishBatch(messages));
+        EXPECT_NO_THROW(client.PublishBatch({}));
+
+        // Stops at the first invalid message
+        messages[1].topic = "test/+";
+        EXPECT_THROW(client.PublishBatch(messages), std::runtime_error);
+    }
+    mosquitto_lib_cleanup();
+}
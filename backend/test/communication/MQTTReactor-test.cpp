@@ -0,0 +1,153 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <mosquitto.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "communication/MQTTReactor.h"
+
+using std::chrono::milliseconds;
+
+namespace
+{
+    // Answers a single client on a free local port like a broker
+    class FakeBroker
+    {
+    public:
+        FakeBroker()
+        {
+            m_listen = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0;
+            bind(m_listen, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            listen(m_listen, 1);
+            socklen_t length = sizeof(address);
+            getsockname(m_listen, reinterpret_cast<sockaddr*>(&address), &length);
+            m_port = ntohs(address.sin_port);
+        }
+        ~FakeBroker()
+        {
+            if (m_client >= 0)
+            {
+                close(m_client);
+            }
+            close(m_listen);
+        }
+
+        int GetPort() const { return m_port; }
+
+        // Waits for the CONNECT packet, accepts the connection and publishes one message (topic and payload together
+        // shorter than 126 bytes)
+        void AcceptAndPublish(const std::string& topic, const std::string& payload)
+        {
+            m_client = accept(m_listen, nullptr, nullptr);
+            char connect[256];
+            recv(m_client, connect, sizeof(connect), 0);
+            // CONNACK, connection accepted
+            std::string packets {'\x20', '\x02', '\x00', '\x00'};
+            // PUBLISH with QoS 0
+            packets += '\x30';
+            packets += static_cast<char>(2 + topic.size() + payload.size());
+            packets += static_cast<char>(topic.size() >> 8);
+            packets += static_cast<char>(topic.size() & 0xff);
+            packets += topic;
+            packets += payload;
+            send(m_client, packets.data(), packets.size(), 0);
+        }
+
+    private:
+        int m_listen = -1;
+        int m_client = -1;
+        int m_port = 0;
+    };
+
+    struct Callbacks
+    {
+        std::atomic<bool> connected {false};
+        std::promise<std::pair<std::string, std::string>> message;
+        std::thread::id messageThread;
+    };
+
+    void OnConnect(struct mosquitto*, void* userdata, int returnCode)
+    {
+        static_cast<Callbacks*>(userdata)->connected = returnCode == 0;
+    }
+
+    void OnMessage(struct mosquitto*, void* userdata, const struct mosquitto_message* message)
+    {
+        Callbacks& callbacks = *static_cast<Callbacks*>(userdata);
+        callbacks.messageThread = std::this_thread::get_id();
+        callbacks.message.set_value(std::make_pair(
+            std::string(message->topic), std::string(static_cast<const char*>(message->payload), message->payloadlen)));
+    }
+} // namespace
+
+TEST(MQTTReactor, NextReconnectDelay)
+{
+    EXPECT_EQ(MQTTReactor::s_minReconnectDelay, MQTTReactor::NextReconnectDelay(milliseconds(0)));
+    EXPECT_EQ(MQTTReactor::s_minReconnectDelay * 2, MQTTReactor::NextReconnectDelay(MQTTReactor::s_minReconnectDelay));
+    EXPECT_EQ(milliseconds(8000), MQTTReactor::NextReconnectDelay(milliseconds(4000)));
+    EXPECT_EQ(MQTTReactor::s_maxReconnectDelay, MQTTReactor::NextReconnectDelay(milliseconds(40000)));
+    EXPECT_EQ(MQTTReactor::s_maxReconnectDelay, MQTTReactor::NextReconnectDelay(MQTTReactor::s_maxReconnectDelay));
+}
+
+TEST(MQTTReactor, DispatchMessage)
+{
+    mosquitto_lib_init();
+    {
+        FakeBroker broker;
+        std::thread brokerThread([&] { broker.AcceptAndPublish("tele/device/STATE", "{\"POWER\":\"ON\"}"); });
+        Callbacks callbacks;
+        std::future<std::pair<std::string, std::string>> message = callbacks.message.get_future();
+        MQTTReactor reactor;
+        struct mosquitto* mosq = mosquitto_new("MQTTReactor-test", true, &callbacks);
+        ASSERT_NE(nullptr, mosq);
+        mosquitto_connect_callback_set(mosq, OnConnect);
+        mosquitto_message_callback_set(mosq, OnMessage);
+        ASSERT_EQ(MOSQ_ERR_SUCCESS, mosquitto_connect(mosq, "127.0.0.1", broker.GetPort(), 60));
+        reactor.Add(mosq);
+
+        // The reactor reads the packets of the broker and calls the callbacks on its thread
+        ASSERT_EQ(std::future_status::ready, message.wait_for(std::chrono::seconds(5)));
+        EXPECT_EQ(std::make_pair(std::string("tele/device/STATE"), std::string("{\"POWER\":\"ON\"}")), message.get());
+        EXPECT_TRUE(callbacks.connected);
+        EXPECT_NE(std::this_thread::get_id(), callbacks.messageThread);
+
+        reactor.Remove(mosq);
+        mosquitto_destroy(mosq);
+        brokerThread.join();
+    }
+    mosquitto_lib_cleanup();
+}
+
+TEST(MQTTReactor, RemoveUnreachableClient)
+{
+    mosquitto_lib_init();
+    {
+        Callbacks callbacks;
+        MQTTReactor reactor;
+        struct mosquitto* mosq = mosquitto_new("MQTTReactor-test", true, &callbacks);
+        ASSERT_NE(nullptr, mosq);
+        mosquitto_connect_callback_set(mosq, OnConnect);
+        // Nothing listens on port 1, so the reactor has to schedule a reconnect
+        EXPECT_NE(MOSQ_ERR_SUCCESS, mosquitto_connect(mosq, "127.0.0.1", 1, 60));
+        reactor.Add(mosq);
+        std::this_thread::sleep_for(milliseconds(50));
+        reactor.Wake();
+        // Returns once the reactor no longer uses the client
+        reactor.Remove(mosq);
+        EXPECT_FALSE(callbacks.connected);
+        mosquitto_destroy(mosq);
+    }
+    mosquitto_lib_cleanup();
+}
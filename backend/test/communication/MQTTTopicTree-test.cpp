@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "communication/MQTTTopicTree.h"
+
+namespace
+{
+    std::vector<int> MatchAll(const MQTTTopicTree<int>& tree, const std::string& topic)
+    {
+        std::vector<int> result;
+        tree.Match(
+            topic, [&](MQTTTopicTree<int>::Handle, const std::shared_ptr<const int>& v) { result.push_back(*v); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+} // namespace
+
+TEST(MQTTTopicTree, Match)
+{
+    MQTTTopicTree<int> tree;
+    EXPECT_EQ(std::vector<int> {}, MatchAll(tree, "a/b"));
+
+    tree.Insert("a/b", 1);
+    tree.Insert("a/+", 2);
+    tree.Insert("a/#", 3);
+    tree.Insert("+/b/c", 4);
+    tree.Insert("#", 5);
+    tree.Insert("a/b", 6);
+
+    EXPECT_EQ((std::vector<int> {1, 2, 3, 5, 6}), MatchAll(tree, "a/b"));
+    // '#' includes parent level
+    EXPECT_EQ((std::vector<int> {3, 5}), MatchAll(tree, "a"));
+    EXPECT_EQ((std::vector<int> {3, 4, 5}), MatchAll(tree, "a/b/c"));
+    EXPECT_EQ((std::vector<int> {4, 5}), MatchAll(tree, "x/b/c"));
+    EXPECT_EQ((std::vector<int> {5}), MatchAll(tree, "x/b"));
+    EXPECT_EQ((std::vector<int> {2, 3, 5}), MatchAll(tree, "a/"));
+    // Wildcards on first level do not match $ topics
+    EXPECT_EQ((std::vector<int> {}), MatchAll(tree, "$SYS/b/c"));
+    tree.Insert("$SYS/#", 7);
+    EXPECT_EQ((std::vector<int> {7}), MatchAll(tree, "$SYS/b/c"));
+}
+
+TEST(MQTTTopicTree, Remove)
+{
+    MQTTTopicTree<int> tree;
+    auto h1 = tree.Insert("tele/+/STATE", 1);
+    auto h2 = tree.Insert("tele/+/STATE", 2);
+    auto h3 = tree.Insert("stat/#", 3);
+    EXPECT_TRUE(tree.Contains("tele/+/STATE"));
+    EXPECT_TRUE(tree.Contains("stat/#"));
+    EXPECT_FALSE(tree.Contains("stat"));
+    EXPECT_FALSE(tree.Contains("tele/a/STATE"));
+
+    std::string filter;
+    EXPECT_TRUE(tree.Remove(h1, &filter));
+    // Other value with same filter remains
+    EXPECT_EQ("", filter);
+    EXPECT_TRUE(tree.Contains("tele/+/STATE"));
+    EXPECT_EQ((std::vector<int> {2}), MatchAll(tree, "tele/dev/STATE"));
+    EXPECT_FALSE(tree.Remove(h1, &filter));
+
+    EXPECT_TRUE(tree.Remove(h2, &filter));
+    EXPECT_EQ("tele/+/STATE", filter);
+    EXPECT_FALSE(tree.Contains("tele/+/STATE"));
+    EXPECT_EQ((std::vector<int> {}), MatchAll(tree, "tele/dev/STATE"));
+    EXPECT_EQ((std::vector<int> {3}), MatchAll(tree, "stat/dev/RESULT"));
+
+    // Values can be removed while matching
+    std::vector<int> matched;
+    tree.Match("stat/dev", [&](MQTTTopicTree<int>::Handle h, const std::shared_ptr<const int>& v) {
+        matched.push_back(*v);
+        tree.Remove(h);
+    });
+    EXPECT_EQ(std::vector<int> {3}, matched);
+    EXPECT_FALSE(tree.Contains("stat/#"));
+    EXPECT_FALSE(tree.Remove(h3));
+}
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "communication/MQTTClient.h"
+#include "communication/MQTTWorkerPool.h"
+
+namespace
+{
+    void PushMessage(MQTTWorkerPool& pool, const std::string& topic, const std::string& payload)
+    {
+        const MQTTTopicTree<MQTTClient::Callback>::Levels levels = MQTTTopicTree<MQTTClient::Callback>::Split(topic);
+        pool.Push(MQTTMessage {0, topic, payload, 0, false, levels});
+    }
+} // namespace
+
+TEST(MQTTWorkerPool, OrderPerDevice)
+{
+    constexpr int count = 200;
+    std::mutex mutex;
+    std::map<std::string, std::vector<std::string>> received;
+    std::atomic<int> handled {0};
+    {
+        MQTTWorkerPool pool(3, [&](const MQTTMessage& message) {
+            ASSERT_EQ(3, message.topicLevels.size());
+            std::lock_guard<std::mutex> lock(mutex);
+            received[std::string(message.topicLevels[1])].emplace_back(message.payload);
+            ++handled;
+        });
+        for (int i = 0; i < count; ++i)
+        {
+            // Different topics of the same device
+            PushMessage(pool, "tele/dev" + std::to_string(i % 4) + (i % 2 ? "/STATE" : "/SENSOR"), std::to_string(i));
+        }
+        while (handled < count)
+        {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(0, pool.GetQueueDepth());
+        EXPECT_EQ(0, pool.GetLag().count());
+    }
+    ASSERT_EQ(4, received.size());
+    for (const auto& device : received)
+    {
+        ASSERT_EQ(count / 4, device.second.size());
+        for (std::size_t i = 1; i < device.second.size(); ++i)
+        {
+            EXPECT_LT(std::stoi(device.second[i - 1]), std::stoi(device.second[i]));
+        }
+    }
+}
+
+TEST(MQTTWorkerPool, QueueDepth)
+{
+    std::mutex block;
+    std::unique_lock<std::mutex> blockLock(block);
+    std::atomic<int> handled {0};
+    MQTTWorkerPool pool(1, [&](const MQTTMessage& message) {
+        std::lock_guard<std::mutex> lock(block);
+        ++handled;
+    });
+    PushMessage(pool, "stat/a/RESULT", "1");
+    PushMessage(pool, "stat/b/RESULT", "2");
+    PushMessage(pool, "stat/c/RESULT", "3");
+    // First message may already be taken by the worker
+    EXPECT_LE(2, pool.GetQueueDepth());
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_LE(5, pool.GetLag().count());
+    blockLock.unlock();
+    while (handled < 3)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(0, pool.GetQueueDepth());
+}
+
+TEST(MQTTWorkerPool, QueueLimit)
+{
+    std::mutex block;
+    std::unique_lock<std::mutex> blockLock(block);
+    std::atomic<bool> started {false};
+    std::mutex mutex;
+    std::vector<std::string> received;
+    std::promise<void> done;
+    MQTTWorkerPool pool(
+        1,
+        [&](const MQTTMessage& message) {
+            started = true;
+            std::lock_guard<std::mutex> lock(block);
+            std::lock_guard<std::mutex> receivedLock(mutex);
+            received.emplace_back(message.payload);
+            if (received.size() == 3)
+            {
+                done.set_value();
+            }
+        },
+        2);
+    PushMessage(pool, "stat/a/RESULT", "1");
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+    // Worker is busy with the first message, the queue is full after the next two
+    PushMessage(pool, "stat/a/RESULT", "2");
+    PushMessage(pool, "stat/b/RESULT", "3");
+    // Supersedes the queued message of the same topic
+    PushMessage(pool, "stat/a/RESULT", "4");
+    // No queued message with this topic, so the new message is dropped
+    PushMessage(pool, "stat/c/RESULT", "5");
+    EXPECT_EQ(2, pool.GetQueueDepth());
+    EXPECT_EQ(2, pool.GetDroppedCount());
+    blockLock.unlock();
+    done.get_future().wait();
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ((std::vector<std::string> {"1", "3", "4"}), received);
+}
@@ -1,3 +1,4 @@
+#include <google/protobuf/io/coded_stream.h>
 #include <gtest/gtest.h>
 
 #include "TestWebsocketCommunication.h"
@@ -110,6 +111,125 @@ TEST(WebsocketChannel, SendBytes)
     channel.SendBytes(hdl, data.data(), data.size());
 }
 
+namespace
+{
+    // Decodes a frame created by EncodeChannelFrame
+    bool DecodeChannelFrame(const std::string& frame, std::string& channel, messages::ChannelMessage& message)
+    {
+        google::protobuf::io::CodedInputStream input(
+            reinterpret_cast<const google::protobuf::uint8*>(frame.data()), static_cast<int>(frame.size()));
+        uint32_t channelLength = 0;
+        uint32_t messageLength = 0;
+        if (!input.ReadVarint32(&channelLength) || !input.ReadString(&channel, channelLength)
+            || !input.ReadVarint32(&messageLength))
+        {
+            return false;
+        }
+        google::protobuf::io::CodedInputStream::Limit limit = input.PushLimit(messageLength);
+        bool result = message.ParseFromCodedStream(&input) && input.ConsumedEntireMessage();
+        input.PopLimit(limit);
+        return result && input.ExpectAtEnd();
+    }
+} // namespace
+
+TEST(WebsocketChannel, SendMessage)
+{
+    using namespace ::testing;
+
+    TestWebsocketCommunication testWC;
+    const std::string channelName = "channel1";
+    WebsocketChannel channel(testWC.ws, channelName, WebsocketChannel::RequireAuth::noAuth);
+
+    messages::ChannelMessage message;
+    message.mutable_device()->set_id(5);
+    message.mutable_device()->set_name("device");
+
+    auto connection = std::make_shared<MockWebsocketConnection>();
+    WebsocketChannel::connection_hdl hdl = connection;
+
+    std::string sent;
+    EXPECT_CALL(testWC.GetServer(),
+        send(Truly([&](WebsocketChannel::connection_hdl h) { return hdl.lock() == h.lock(); }), _, _,
+            websocketpp::frame::opcode::binary))
+        .WillOnce(Invoke([&](WebsocketChannel::connection_hdl, const void* data, std::size_t length,
+                             websocketpp::frame::opcode::value) {
+            sent.assign(static_cast<const char*>(data), length);
+        }));
+
+    channel.SendMessage(hdl, message);
+
+    std::string decodedChannel;
+    messages::ChannelMessage decoded;
+    ASSERT_TRUE(DecodeChannelFrame(sent, decodedChannel, decoded));
+    EXPECT_EQ(channelName, decodedChannel);
+    EXPECT_EQ(message.SerializeAsString(), decoded.SerializeAsString());
+}
+
+TEST(WebsocketChannel, BroadcastBinary)
+{
+    using namespace ::testing;
+
+    TestWebsocketCommunication testWC;
+    const std::string channelName = "channel1";
+    WebsocketChannel channel(testWC.ws, channelName, WebsocketChannel::RequireAuth::noAuth);
+
+    nlohmann::json value {{"deleteDevice", 3}};
+    nlohmann::json expected = value;
+    expected["channel"] = channelName;
+    messages::ChannelMessage message;
+    message.set_delete_device(3);
+
+    auto c1 = std::make_shared<MockWebsocketConnection>();
+    auto c2 = std::make_shared<MockWebsocketConnection>();
+
+    nlohmann::json jsonSubscribe {{"command", "subscribeChannel"}};
+    channel.OnChannelEvent(Events::SocketMessageEvent(
+        c1, std::make_shared<MockWebsocketMessage>(jsonSubscribe), jsonSubscribe, absl::nullopt));
+    nlohmann::json binarySubscribe {{"command", "subscribeChannel"}, {"binary", true}};
+    channel.OnChannelEvent(Events::SocketMessageEvent(
+        c2, std::make_shared<MockWebsocketMessage>(binarySubscribe), binarySubscribe, absl::nullopt));
+
+    EXPECT_FALSE(channel.IsBinary(c1));
+    EXPECT_TRUE(channel.IsBinary(c2));
+
+    std::string sent;
+    EXPECT_CALL(testWC.GetServer(),
+        send(Truly([&](WebsocketChannel::connection_hdl h) { return h.lock() == c1; }), expected.dump(),
+            websocketpp::frame::opcode::text));
+    EXPECT_CALL(testWC.GetServer(),
+        send(Truly([&](WebsocketChannel::connection_hdl h) { return h.lock() == c2; }), _, _,
+            websocketpp::frame::opcode::binary))
+        .WillOnce(Invoke([&](WebsocketChannel::connection_hdl, const void* data, std::size_t length,
+                             websocketpp::frame::opcode::value) {
+            sent.assign(static_cast<const char*>(data), length);
+        }));
+    channel.Broadcast(value, message);
+    Mock::VerifyAndClearExpectations(&testWC.GetServer());
+
+    std::string decodedChannel;
+    messages::ChannelMessage decoded;
+    ASSERT_TRUE(DecodeChannelFrame(sent, decodedChannel, decoded));
+    EXPECT_EQ(channelName, decodedChannel);
+    EXPECT_EQ(3, decoded.delete_device());
+
+    // Invalid binary value is ignored, subscribing again without binary switches back to json
+    nlohmann::json invalidSubscribe {{"command", "subscribeChannel"}, {"binary", "yes"}};
+    channel.OnChannelEvent(Events::SocketMessageEvent(
+        c1, std::make_shared<MockWebsocketMessage>(invalidSubscribe), invalidSubscribe, absl::nullopt));
+    EXPECT_FALSE(channel.IsBinary(c1));
+    EXPECT_TRUE(channel.HasSubscribers());
+    channel.OnChannelEvent(Events::SocketMessageEvent(
+        c2, std::make_shared<MockWebsocketMessage>(jsonSubscribe), jsonSubscribe, absl::nullopt));
+    EXPECT_FALSE(channel.IsBinary(c2));
+
+    // Binary mode ends with the subscription
+    channel.OnChannelEvent(Events::SocketMessageEvent(
+        c2, std::make_shared<MockWebsocketMessage>(binarySubscribe), binarySubscribe, absl::nullopt));
+    EXPECT_TRUE(channel.IsBinary(c2));
+    channel.Unsubscribe(c2);
+    EXPECT_FALSE(channel.IsBinary(c2));
+}
+
 TEST(WebsocketChannel, Broadcast)
 {
     using namespace ::testing;
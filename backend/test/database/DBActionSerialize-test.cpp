@@ -4,6 +4,7 @@
 #include <sqlpp11/remove.h>
 #include <sqlpp11/select.h>
 
+#include "WriterConnection.h"
 #include "api/SubActionImpls.h"
 #include "database/ActionsTable.h"
 #include "database/DBActionSerialize.h"
@@ -11,7 +12,7 @@
 class DBActionSerializeTest : public ::testing::Test
 {
 public:
-    DBActionSerializeTest() : dbHandler{":memory:"}, db(dbHandler.GetDatabase()), as(dbHandler)
+    DBActionSerializeTest() : dbHandler{":memory:"}, db(GetWriterConnection(dbHandler)), as(dbHandler)
     {
         db.execute(ActionsTable::createStatement);
         db.execute(SubActionsTable::createStatement);
@@ -190,5 +191,15 @@ TEST_F(DBActionSerializeTest, GetAllActions)
         }
         std::vector<Action> result = as.GetAllActions(filter, user);
         EXPECT_EQ(actions, result);
+
+        // Paging
+        EXPECT_EQ(std::vector<Action>(actions.begin(), actions.begin() + 2), as.GetAllActions(Filter("", 0, 2), user));
+        EXPECT_EQ(std::vector<Action>(actions.begin() + 1, actions.end()), as.GetAllActions(Filter("", 1, 0), user));
+        EXPECT_EQ(std::vector<Action>(actions.begin() + 2, actions.end()), as.GetAllActions(Filter("", 2, 5), user));
+        EXPECT_TRUE(as.GetAllActions(Filter("", 3, 0), user).empty());
+        // Search by name
+        EXPECT_EQ(std::vector<Action>(actions.begin() + 1, actions.begin() + 2),
+            as.GetAllActions(Filter("me3", 0, 0), user));
+        EXPECT_TRUE(as.GetAllActions(Filter("other", 0, 0), user).empty());
     }
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include <future>
+#include <map>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sqlpp11/select.h>
+
+#include "WriterConnection.h"
+#include "../mocks/MockDeviceAPI.h"
+#include "../mocks/MockDeviceType.h"
+#include "api/DeviceRegistry.h"
+#include "api/Resources.h"
+#include "database/DBDeviceSerialize.h"
+#include "database/DevicesTable.h"
+#include "utility/Logger.h"
+
+class DBDeviceSerializeTest : public ::testing::Test
+{
+public:
+    DBDeviceSerializeTest()
+        : metadata({{"on", MetadataEntry::Builder()
+                                .SetType(MetadataEntry::DataType::boolean)
+                                .SetSave(MetadataEntry::DBSave::save_log)
+                                .Create()},
+              {"brightness", MetadataEntry::Builder()
+                                 .SetType(MetadataEntry::DataType::integer)
+                                 .SetSave(MetadataEntry::DBSave::save_log)
+                                 .Create()},
+              {"color", MetadataEntry::Builder()
+                            .SetType(MetadataEntry::DataType::string)
+                            .SetSave(MetadataEntry::DBSave::save)
+                            .Create()},
+              {"added", MetadataEntry::Builder()
+                            .SetType(MetadataEntry::DataType::string)
+                            .SetSave(MetadataEntry::DBSave::save)
+                            .Create()},
+              {"removed", MetadataEntry::Builder()
+                              .SetType(MetadataEntry::DataType::integer)
+                              .SetSave(MetadataEntry::DBSave::save)
+                              .Create()}}),
+          dbHandler {":memory:"},
+          db(GetWriterConnection(dbHandler)),
+          ds(dbHandler, types)
+    {
+        using namespace ::testing;
+        db.execute(DevicesTable::createStatement);
+        db.execute(DeviceGroupsTable::createStatement);
+        db.execute(PropertiesTable::createStatement);
+        db.execute(PropertiesLogTable::createStatement);
+
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+        auto type = std::make_unique<NiceMock<MockDeviceType>>();
+        deviceType = type.get();
+        ON_CALL(*deviceType, GetName()).WillByDefault(Return("type"));
+        ON_CALL(*deviceType, GetDeviceMetadata()).WillByDefault(ReturnRef(metadata));
+        types.AddDeviceType(std::move(type));
+    }
+
+    Device::Data DeviceData(std::string name, std::vector<std::string> groups,
+        absl::flat_hash_map<std::string, nlohmann::json> properties)
+    {
+        return Device::Data {std::move(name), "icon", std::move(groups), "type",
+            Properties::FromRawData(std::move(properties), *deviceType), "api"};
+    }
+
+    // Returns the uid of each stored property
+    std::map<std::string, int64_t> GetPropertyUids(DeviceId id)
+    {
+        std::map<std::string, int64_t> result;
+        for (const auto& row : db(select(propertiesTable.propertyKey, propertiesTable.propertyUid)
+                                      .from(propertiesTable)
+                                      .where(propertiesTable.deviceId == id.GetValue())))
+        {
+            result.emplace(row.propertyKey, row.propertyUid);
+        }
+        return result;
+    }
+
+    PropertiesTable propertiesTable;
+    Metadata metadata;
+    DeviceTypeRegistry types;
+    ::testing::NiceMock<MockDeviceType>* deviceType;
+    DBHandler dbHandler;
+    DBHandler::DatabaseConnection& db;
+    DBDeviceSerialize ds;
+    const UserId user = UserId::Dummy();
+};
+
+TEST_F(DBDeviceSerializeTest, UpdateDeviceName)
+{
+    DeviceId id = ds.AddDevice(DeviceData("name", {"a"}, {{"on", true}, {"brightness", 20}}), user);
+    std::map<std::string, int64_t> uids = GetPropertyUids(id);
+
+    // Only the name is written, even if other fields differ
+    ds.UpdateDevice(id, DeviceData("other", {"b"}, {{"on", false}}), Events::DeviceFields::NAME, user);
+    Device::Data saved = ds.GetDeviceData(id, user).value();
+    EXPECT_EQ("other", saved.m_name);
+    EXPECT_EQ(std::vector<std::string> {"a"}, saved.m_groups);
+    EXPECT_EQ(true, saved.m_properties.Get("on"));
+    EXPECT_EQ(20, saved.m_properties.Get("brightness"));
+    EXPECT_EQ(uids, GetPropertyUids(id));
+}
+
+TEST_F(DBDeviceSerializeTest, UpdateDeviceGroups)
+{
+    DeviceId id = ds.AddDevice(DeviceData("name", {"a"}, {{"on", true}}), user);
+
+    ds.UpdateDevice(id, DeviceData("other", {"b"}, {}), Events::DeviceFields::GROUPS, user);
+    Device::Data saved = ds.GetDeviceData(id, user).value();
+    EXPECT_EQ("name", saved.m_name);
+    EXPECT_EQ(std::vector<std::string> {"b"}, saved.m_groups);
+    EXPECT_EQ(true, saved.m_properties.Get("on"));
+
+    ds.UpdateDevice(id, DeviceData("name", {}, {}), Events::DeviceFields::GROUPS, user);
+    EXPECT_TRUE(ds.GetDeviceData(id, user).value().m_groups.empty());
+}
+
+TEST_F(DBDeviceSerializeTest, UpdateDeviceAll)
+{
+    DeviceId id = ds.AddDevice(
+        DeviceData("name", {"a"}, {{"on", true}, {"brightness", 20}, {"color", nullptr}, {"removed", 1}}), user);
+    std::map<std::string, int64_t> uids = GetPropertyUids(id);
+
+    ds.UpdateDevice(id,
+        DeviceData("other", {"b"}, {{"on", true}, {"brightness", 30}, {"color", "red"}, {"added", "value"}}),
+        Events::DeviceFields::ALL, user);
+    Device::Data saved = ds.GetDeviceData(id, user).value();
+    EXPECT_EQ("other", saved.m_name);
+    EXPECT_EQ(std::vector<std::string> {"b"}, saved.m_groups);
+    EXPECT_EQ(true, saved.m_properties.Get("on"));
+    EXPECT_EQ(30, saved.m_properties.Get("brightness"));
+    EXPECT_EQ("red", saved.m_properties.Get("color"));
+    EXPECT_EQ("value", saved.m_properties.Get("added"));
+    EXPECT_FALSE(saved.m_properties.GetAll().count("removed"));
+
+    // Existing properties are updated in place
+    std::map<std::string, int64_t> updatedUids = GetPropertyUids(id);
+    ASSERT_EQ(4u, updatedUids.size());
+    EXPECT_EQ(uids["on"], updatedUids["on"]);
+    EXPECT_EQ(uids["brightness"], updatedUids["brightness"]);
+    EXPECT_EQ(uids["color"], updatedUids["color"]);
+    EXPECT_EQ(0u, updatedUids.count("removed"));
+
+    EXPECT_THROW(ds.UpdateDevice(DeviceId(id.GetValue() + 1), saved, Events::DeviceFields::ALL, user),
+        std::runtime_error);
+}
+
+TEST_F(DBDeviceSerializeTest, GetAPIDevices)
+{
+    DeviceId first = ds.AddDevice(DeviceData("first", {"a", "b"}, {{"on", true}, {"brightness", 20}}), user);
+    Device::Data otherApi = DeviceData("other", {"a"}, {{"on", false}});
+    otherApi.m_api = "other";
+    ds.AddDevice(otherApi, user);
+    Device::Data unknownType = DeviceData("unknown", {}, {});
+    unknownType.m_type = "unknown";
+    ds.AddDevice(unknownType, user);
+    DeviceId second = ds.AddDevice(DeviceData("second", {}, {{"on", nullptr}}), user);
+
+    // Groups and properties of other devices are not mixed in, unknown types are skipped
+    std::vector<std::pair<DeviceId, Device::Data>> loaded = ds.GetAPIDevices("api", user);
+    ASSERT_EQ(2u, loaded.size());
+    EXPECT_EQ(first, loaded[0].first);
+    EXPECT_EQ("first", loaded[0].second.m_name);
+    EXPECT_EQ((std::vector<std::string> {"a", "b"}), loaded[0].second.m_groups);
+    EXPECT_EQ(ds.GetDeviceData(first, user).value().m_properties.GetAll(), loaded[0].second.m_properties.GetAll());
+    EXPECT_EQ(second, loaded[1].first);
+    EXPECT_TRUE(loaded[1].second.m_groups.empty());
+    EXPECT_EQ(nullptr, loaded[1].second.m_properties.Get("on"));
+    EXPECT_TRUE(ds.GetAPIDevices("none", user).empty());
+}
+
+TEST_F(DBDeviceSerializeTest, GetAllDevices)
+{
+    DeviceId first = ds.AddDevice(DeviceData("first", {"a"}, {{"on", true}}), user);
+    DeviceId second = ds.AddDevice(DeviceData("second", {"b"}, {{"on", false}}), user);
+    DeviceId third = ds.AddDevice(DeviceData("third", {"a"}, {{"brightness", 3}}), user);
+
+    std::vector<std::pair<DeviceId, Device::Data>> loaded = ds.GetAllDevices(Filter(), user);
+    ASSERT_EQ(3u, loaded.size());
+    EXPECT_EQ(second, loaded[1].first);
+    EXPECT_EQ(std::vector<std::string> {"b"}, loaded[1].second.m_groups);
+    EXPECT_EQ(false, loaded[1].second.m_properties.Get("on"));
+
+    // The second device is in the id range of the page, but does not match the filter
+    loaded = ds.GetAllDevices(Filter("", 0, 10, "a"), user);
+    ASSERT_EQ(2u, loaded.size());
+    EXPECT_EQ(first, loaded[0].first);
+    EXPECT_EQ(std::vector<std::string> {"a"}, loaded[0].second.m_groups);
+    EXPECT_EQ(1u, loaded[0].second.m_properties.GetAll().size());
+    EXPECT_EQ(third, loaded[1].first);
+    EXPECT_EQ(3, loaded[1].second.m_properties.Get("brightness"));
+
+    loaded = ds.GetAllDevices(Filter("", 1, 1), user);
+    ASSERT_EQ(1u, loaded.size());
+    EXPECT_EQ(second, loaded[0].first);
+}
+
+TEST_F(DBDeviceSerializeTest, GetAllDevicesSearch)
+{
+    DeviceId underscore = ds.AddDevice(DeviceData("a_b", {"a"}, {}), user);
+    ds.AddDevice(DeviceData("axb", {"a"}, {}), user);
+    DeviceId percent = ds.AddDevice(DeviceData("100%", {}, {}), user);
+    DeviceId thousand = ds.AddDevice(DeviceData("1000", {"a"}, {}), user);
+
+    // Wildcards in the search string are matched literally
+    std::vector<std::pair<DeviceId, Device::Data>> loaded = ds.GetAllDevices(Filter("a_b", 0, 0), user);
+    ASSERT_EQ(1u, loaded.size());
+    EXPECT_EQ(underscore, loaded[0].first);
+    loaded = ds.GetAllDevices(Filter("100%", 0, 0), user);
+    ASSERT_EQ(1u, loaded.size());
+    EXPECT_EQ(percent, loaded[0].first);
+    EXPECT_TRUE(ds.GetAllDevices(Filter("\\", 0, 0), user).empty());
+
+    // Search with paging and group
+    loaded = ds.GetAllDevices(Filter("10", 1, 5), user);
+    ASSERT_EQ(1u, loaded.size());
+    EXPECT_EQ(thousand, loaded[0].first);
+    loaded = ds.GetAllDevices(Filter("b", 0, 1, "a"), user);
+    ASSERT_EQ(1u, loaded.size());
+    EXPECT_EQ(underscore, loaded[0].first);
+}
+
+TEST_F(DBDeviceSerializeTest, ConcurrentSynchronize)
+{
+    using namespace ::testing;
+    EventEmitter<Events::DeviceChangeEvent> deviceEvents;
+    EventEmitter<Events::DevicePropertyChangeEvent> propertyEvents;
+    EventSystem evSys;
+    RuleConditions::Registry condReg;
+    SubActionRegistry subActReg;
+    DeviceRegistry registry(ds, deviceEvents, propertyEvents);
+    constexpr std::size_t count = 50;
+    // Both apis write at the same time
+    std::promise<void> start;
+    std::shared_future<void> startFuture = start.get_future().share();
+    for (const char* apiId : {"a", "b"})
+    {
+        auto api = std::make_unique<NiceMock<MockDeviceAPI>>(apiId);
+        EXPECT_CALL(*api, SynchronizeDevices(_)).WillOnce(Invoke([&, apiId](DeviceStorage& storage) {
+            startFuture.wait();
+            EXPECT_TRUE(storage.GetApiDevices(apiId, user).empty());
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                DeviceId id = storage.AddDevice(Device(std::to_string(i), "icon", {"group"}, "type",
+                                                    Properties::FromRawData({{"on", true}}, *deviceType), apiId),
+                    user);
+                storage.SetDeviceProperty(id, "on", Properties::FromRawData({{"on", false}}, *deviceType), user);
+            }
+        }));
+        EXPECT_CALL(*api, Start());
+        registry.RegisterDeviceAPI(std::move(api));
+    }
+    registry.InitAPIs("DBDeviceSerialize-test-missing", evSys, condReg, subActReg, types);
+    start.set_value();
+    registry.Start();
+    ASSERT_EQ(2u, registry.GetAllAPIs().size());
+    for (const char* apiId : {"a", "b"})
+    {
+        std::vector<std::pair<DeviceId, Device::Data>> loaded = ds.GetAPIDevices(apiId, user);
+        ASSERT_EQ(count, loaded.size());
+        for (const auto& device : loaded)
+        {
+            EXPECT_EQ((std::vector<std::string> {"group"}), device.second.m_groups);
+            EXPECT_EQ(false, device.second.m_properties.Get("on"));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <sqlpp11/insert.h>
+#include <sqlpp11/select.h>
+#include <sqlpp11/transaction.h>
+
+#include "database/DBHandler.h"
+#include "database/DevicesTable.h"
+
+namespace
+{
+    constexpr DevicesTable devices;
+} // namespace
+
+// Database file which is removed with its write ahead log afterwards
+class TestDatabaseFile
+{
+public:
+    TestDatabaseFile() : m_filename("DBHandler-test.db") { Remove(); }
+    ~TestDatabaseFile() { Remove(); }
+
+    const std::string& GetFilename() const { return m_filename; }
+
+private:
+    void Remove()
+    {
+        std::remove(m_filename.c_str());
+        std::remove((m_filename + "-wal").c_str());
+        std::remove((m_filename + "-shm").c_str());
+    }
+
+private:
+    std::string m_filename;
+};
+
+TEST(DBHandler, Write)
+{
+    DBHandler dbHandler(":memory:");
+    dbHandler.Write([](DBHandler::DatabaseConnection& db) { db.execute(DevicesTable::createStatement); }).get();
+
+    const std::thread::id caller = std::this_thread::get_id();
+    std::future<uint64_t> id = dbHandler.Write([&](DBHandler::DatabaseConnection& db) {
+        EXPECT_NE(caller, std::this_thread::get_id());
+        return db(insert_into(devices).set(devices.deviceName = "name", devices.deviceIcon = "icon",
+            devices.deviceApi = "api", devices.deviceType = "t"));
+    });
+    EXPECT_EQ(1u, id.get());
+
+    // Writes queued from the writer thread run immediately instead of waiting for themselves
+    std::future<int> nested = dbHandler.Write([&](DBHandler::DatabaseConnection&) {
+        return dbHandler.Write([](DBHandler::DatabaseConnection&) { return 2; }).get();
+    });
+    EXPECT_EQ(2, nested.get());
+
+    std::future<void> error
+        = dbHandler.Write([](DBHandler::DatabaseConnection&) { throw std::runtime_error("write failed"); });
+    EXPECT_THROW(error.get(), std::runtime_error);
+}
+
+TEST(DBHandler, GetReadConnectionInMemory)
+{
+    DBHandler dbHandler(":memory:");
+    DBHandler::DatabaseConnection* writer = nullptr;
+    dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            db.execute(DevicesTable::createStatement);
+            writer = &db;
+        })
+        .get();
+    std::future<void> write;
+    {
+        // A second connection would open a different database
+        DBHandler::ReadConnection connection = dbHandler.GetReadConnection();
+        EXPECT_EQ(writer, &*connection);
+        // The shared connection is not written while it is leased
+        write = dbHandler.Write([](DBHandler::DatabaseConnection&) {});
+        EXPECT_EQ(std::future_status::timeout, write.wait_for(std::chrono::milliseconds(20)));
+    }
+    write.get();
+}
+
+TEST(DBHandler, GetReadConnection)
+{
+    TestDatabaseFile file;
+    DBConfig config;
+    config.m_readConnections = 2;
+    DBHandler dbHandler(file.GetFilename(), config);
+    dbHandler
+        .Write([](DBHandler::DatabaseConnection& db) {
+            db.execute(DevicesTable::createStatement);
+            db(insert_into(devices).set(devices.deviceName = "name", devices.deviceIcon = "icon",
+                devices.deviceApi = "api", devices.deviceType = "t"));
+        })
+        .get();
+
+    DBHandler::ReadConnection connection = dbHandler.GetReadConnection();
+    dbHandler
+        .Write([&](DBHandler::DatabaseConnection& db) {
+            EXPECT_NE(&db, &*connection);
+            // Readers are not blocked by an open write transaction and do not see its changes
+            auto transaction = sqlpp::start_transaction(db);
+            db(insert_into(devices).set(devices.deviceName = "other", devices.deviceIcon = "icon",
+                devices.deviceApi = "api", devices.deviceType = "t"));
+            auto result = (*connection)(select(devices.deviceName).from(devices).unconditionally());
+            ASSERT_FALSE(result.empty());
+            EXPECT_EQ("name", result.front().deviceName.value());
+            result.pop_front();
+            EXPECT_TRUE(result.empty());
+            transaction.commit();
+        })
+        .get();
+    // Read connections can not write
+    EXPECT_ANY_THROW((*connection)(insert_into(devices).set(devices.deviceName = "name", devices.deviceIcon = "icon",
+        devices.deviceApi = "api", devices.deviceType = "t")));
+}
+
+TEST(DBHandler, GetReadConnectionWithoutReaders)
+{
+    TestDatabaseFile file;
+    DBConfig config;
+    config.m_readConnections = 0;
+    DBHandler dbHandler(file.GetFilename(), config);
+    dbHandler.Write([](DBHandler::DatabaseConnection& db) { db.execute(DevicesTable::createStatement); }).get();
+
+    // File databases always read from a separate connection, so writes can be waited for while reading
+    DBHandler::ReadConnection connection = dbHandler.GetReadConnection();
+    std::future<void> write = dbHandler.Write([&](DBHandler::DatabaseConnection& db) { EXPECT_NE(&db, &*connection); });
+    ASSERT_EQ(std::future_status::ready, write.wait_for(std::chrono::seconds(5)));
+    write.get();
+}
+
+TEST(ConnectionPool, Acquire)
+{
+    TestDatabaseFile file;
+    DBHandler dbHandler(file.GetFilename());
+    ConnectionPool pool(file.GetFilename(), 100, 1);
+    EXPECT_EQ(0u, pool.GetOpenConnections());
+    std::atomic<bool> acquired {false};
+    std::thread thread;
+    {
+        ConnectionPool::Lease lease = pool.Acquire();
+        EXPECT_EQ(1u, pool.GetOpenConnections());
+        // Blocks until the lease is returned
+        thread = std::thread([&] {
+            ConnectionPool::Lease other = pool.Acquire();
+            acquired = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_FALSE(acquired);
+    }
+    thread.join();
+    EXPECT_TRUE(acquired);
+    EXPECT_EQ(1u, pool.GetOpenConnections());
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <sqlpp11/insert.h>
 #include <sqlpp11/remove.h>
 
+#include "WriterConnection.h"
 #include "../mocks/MockRuleCondition.h"
 #include "database/DBActionSerialize.h"
 #include "database/DBRuleSerialize.h"
@@ -15,7 +16,7 @@ using namespace ::RuleConditions;
 class DBRuleConditionSerializeTest : public ::testing::Test
 {
 public:
-    DBRuleConditionSerializeTest() : dbHandler(":memory:"), db(dbHandler.GetDatabase()), cs(dbHandler)
+    DBRuleConditionSerializeTest() : dbHandler(":memory:"), db(GetWriterConnection(dbHandler)), cs(dbHandler)
     {
         db.execute(RulesTable::createStatement);
         db.execute(RuleConditionsTable::createStatement);
@@ -32,7 +33,7 @@ public:
 class DBRuleSerializeTest : public ::testing::Test
 {
 public:
-    DBRuleSerializeTest() : dbHandler(":memory:"), db(dbHandler.GetDatabase()), as(dbHandler), rs(dbHandler, as)
+    DBRuleSerializeTest() : dbHandler(":memory:"), db(GetWriterConnection(dbHandler)), as(dbHandler), rs(dbHandler, as)
     {
         db.execute(ActionsTable::createStatement);
         db.execute(SubActionsTable::createStatement);
@@ -547,7 +548,43 @@ TEST_F(DBRuleSerializeTest, GetAllRules)
         }
         std::vector<Rule> results = rs.GetAllRules(Filter(), user);
         EXPECT_EQ(rules, results);
+
+        // Paging
+        EXPECT_EQ(std::vector<Rule>(rules.begin(), rules.begin() + 2), rs.GetAllRules(Filter("", 0, 2), user));
+        EXPECT_EQ(std::vector<Rule>(rules.begin() + 2, rules.end()), rs.GetAllRules(Filter("", 2, 0), user));
+        EXPECT_TRUE(rs.GetAllRules(Filter("", 4, 0), user).empty());
+        // Search by name
+        EXPECT_EQ(std::vector<Rule>(rules.begin() + 1, rules.end()), rs.GetAllRules(Filter("n", 1, 0), user));
+        EXPECT_EQ(std::vector<Rule>(rules.begin() + 2, rules.begin() + 3), rs.GetAllRules(Filter("n2", 0, 0), user));
+        EXPECT_TRUE(rs.GetAllRules(Filter("other", 0, 0), user).empty());
+    }
+}
+
+TEST_F(DBRuleSerializeTest, GetAllRulesSearch)
+{
+    using namespace ::testing;
+    using ::Action;
+
+    UserId user{0x16364};
+    std::vector<Rule> rules = {
+        Rule{2, "a_b", "i", 2355, nullptr, ::Action{5, "an", "ai", 123, {}, false}},
+        Rule{3, "axb", "i1", 2351, nullptr, ::Action{6, "an1", "ai1", 1234, {}, false}},
+        Rule{4, "100%", "i2", 2352, nullptr, ::Action{7, "an2", "ai2", 1235, {}, false}},
+        Rule{5, "1000", "i3", 2353, nullptr, ::Action{8, "an3", "ai3", 1236, {}, false}},
+    };
+    uint64_t conditionId = 1;
+    for (auto& rule : rules)
+    {
+        auto c = Res::ConditionRegistry().GetCondition(1);
+        c->SetId(conditionId);
+        ++conditionId;
+        rule.SetCondition(std::move(c));
+        rs.AddRule(rule, user);
     }
+    // Wildcards in the search string are matched literally
+    EXPECT_EQ(std::vector<Rule>(rules.begin(), rules.begin() + 1), rs.GetAllRules(Filter("a_b", 0, 0), user));
+    EXPECT_EQ(std::vector<Rule>(rules.begin() + 2, rules.begin() + 3), rs.GetAllRules(Filter("100%", 0, 0), user));
+    EXPECT_TRUE(rs.GetAllRules(Filter("\\", 0, 0), user).empty());
 }
 
 TEST_F(DBRuleSerializeTest, RemoveRuleId)
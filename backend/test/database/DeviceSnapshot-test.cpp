@@ -0,0 +1,164 @@
+#include <cstdio>
+#include <fstream>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "WriterConnection.h"
+#include "../mocks/MockDeviceType.h"
+#include "api/Resources.h"
+#include "database/DBDeviceSerialize.h"
+#include "database/DeviceSnapshot.h"
+#include "utility/Logger.h"
+
+namespace
+{
+    DBConfig SnapshotConfig()
+    {
+        DBConfig config;
+        config.m_deviceGeneration = true;
+        return config;
+    }
+} // namespace
+
+class DeviceSnapshotTest : public ::testing::Test
+{
+public:
+    DeviceSnapshotTest()
+        : metadata({{"on", MetadataEntry::Builder()
+                                .SetType(MetadataEntry::DataType::boolean)
+                                .SetSave(MetadataEntry::DBSave::save_log)
+                                .Create()}}),
+          dbHandler(":memory:", SnapshotConfig()),
+          db(GetWriterConnection(dbHandler)),
+          ds(dbHandler, types),
+          snapshot("DeviceSnapshot-test.bin")
+    {
+        using namespace ::testing;
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+        auto type = std::make_unique<NiceMock<MockDeviceType>>();
+        deviceType = type.get();
+        ON_CALL(*deviceType, GetName()).WillByDefault(Return("type"));
+        ON_CALL(*deviceType, GetDeviceMetadata()).WillByDefault(ReturnRef(metadata));
+        types.AddDeviceType(std::move(type));
+        dbHandler.CreateTables(authenticator);
+        std::remove(snapshot.GetFilename().c_str());
+    }
+    ~DeviceSnapshotTest() { std::remove(snapshot.GetFilename().c_str()); }
+
+    Device::Data DeviceData(std::string name, absl::flat_hash_map<std::string, nlohmann::json> properties)
+    {
+        return Device::Data {std::move(name), "icon", {"a", "b"}, "type",
+            Properties::FromRawData(std::move(properties), *deviceType), "api"};
+    }
+
+    Authenticator authenticator;
+    Metadata metadata;
+    DeviceTypeRegistry types;
+    ::testing::NiceMock<MockDeviceType>* deviceType;
+    DBHandler dbHandler;
+    DBHandler::DatabaseConnection& db;
+    DBDeviceSerialize ds;
+    DeviceSnapshot snapshot;
+    const UserId user = UserId::Dummy();
+};
+
+TEST_F(DeviceSnapshotTest, Generation)
+{
+    const int64_t initial = ds.GetGeneration();
+    DeviceId id = ds.AddDevice(DeviceData("name", {{"on", true}}), user);
+    const int64_t added = ds.GetGeneration();
+    EXPECT_LT(initial, added);
+    ds.SetDeviceProperty(id, "on", Properties::FromRawData({{"on", false}}, *deviceType), user);
+    EXPECT_LT(added, ds.GetGeneration());
+    // Logging does not change the state
+    const int64_t changed = ds.GetGeneration();
+    ds.LogDeviceProperty(id, "on", Properties::FromRawData({{"on", false}}, *deviceType), user);
+    EXPECT_EQ(changed, ds.GetGeneration());
+}
+
+TEST_F(DeviceSnapshotTest, GenerationDisabled)
+{
+    DBHandler untracked(":memory:");
+    untracked.CreateTables(authenticator);
+    DBDeviceSerialize untrackedDs(untracked, types);
+    const int64_t initial = untrackedDs.GetGeneration();
+    DeviceId id = untrackedDs.AddDevice(DeviceData("name", {{"on", true}}), user);
+    untrackedDs.SetDeviceProperty(id, "on", Properties::FromRawData({{"on", false}}, *deviceType), user);
+    EXPECT_EQ(initial, untrackedDs.GetGeneration());
+}
+
+TEST_F(DeviceSnapshotTest, WriteRead)
+{
+    EXPECT_FALSE(snapshot.Read(0));
+    DeviceId id = ds.AddDevice(DeviceData("name", {{"on", true}, {"color", nullptr}}), user);
+    snapshot.Write(ds.CreateSnapshot());
+
+    absl::optional<messages::DeviceSnapshot> read = snapshot.Read(ds.GetGeneration());
+    ASSERT_TRUE(read);
+    EXPECT_EQ(DeviceSnapshot::s_format, read->format());
+    ASSERT_EQ(1, read->devices_size());
+    const messages::SnapshotDevice& device = read->devices(0);
+    EXPECT_EQ(id.GetValue(), device.id());
+    EXPECT_EQ("name", device.name());
+    EXPECT_EQ("type", device.type());
+    EXPECT_EQ("api", device.api());
+    EXPECT_EQ(2, device.groups_size());
+    EXPECT_EQ(2u, device.properties().size());
+
+    // Outdated after changes
+    ds.SetDeviceProperty(id, "on", Properties::FromRawData({{"on", false}}, *deviceType), user);
+    EXPECT_FALSE(snapshot.Read(ds.GetGeneration()));
+
+    // Invalid file
+    {
+        std::ofstream file(snapshot.GetFilename(), std::ios::binary | std::ios::trunc);
+        file << "invalid";
+    }
+    EXPECT_FALSE(snapshot.Read(read->generation()));
+}
+
+TEST_F(DeviceSnapshotTest, GetAPIDevices)
+{
+    DeviceId id = ds.AddDevice(DeviceData("name", {{"on", true}, {"color", nullptr}}), user);
+    ds.SetSnapshot(ds.CreateSnapshot());
+    // Changes behind the serializer show whether the snapshot or the database is read
+    db.execute("UPDATE devices SET device_name = 'database';");
+
+    std::vector<std::pair<DeviceId, Device::Data>> loaded = ds.GetAPIDevices("api", user);
+    ASSERT_EQ(1u, loaded.size());
+    EXPECT_EQ(id, loaded[0].first);
+    EXPECT_EQ("name", loaded[0].second.m_name);
+    EXPECT_EQ((std::vector<std::string> {"a", "b"}), loaded[0].second.m_groups);
+    EXPECT_EQ(true, loaded[0].second.m_properties.Get("on"));
+    EXPECT_EQ(nullptr, loaded[0].second.m_properties.Get("color"));
+    EXPECT_EQ(2u, loaded[0].second.m_properties.GetAll().size());
+    // Only used once
+    EXPECT_EQ("database", ds.GetAPIDevices("api", user).at(0).second.m_name);
+}
+
+TEST_F(DeviceSnapshotTest, Invalidate)
+{
+    DeviceId id = ds.AddDevice(DeviceData("name", {{"on", true}}), user);
+    Device::Data other = DeviceData("other", {});
+    other.m_api = "other";
+    ds.AddDevice(other, user);
+    ds.SetSnapshot(ds.CreateSnapshot());
+    db.execute("UPDATE devices SET device_name = 'database';");
+
+    // Changed api is loaded from the database, others still from the snapshot
+    ds.SetDeviceProperty(id, "on", Properties::FromRawData({{"on", false}}, *deviceType), user);
+    EXPECT_EQ("database", ds.GetAPIDevices("api", user).at(0).second.m_name);
+    EXPECT_EQ("other", ds.GetAPIDevices("other", user).at(0).second.m_name);
+
+    // Added devices invalidate their api
+    ds.SetSnapshot(ds.CreateSnapshot());
+    ds.AddDevice(DeviceData("added", {}), user);
+    EXPECT_EQ(2u, ds.GetAPIDevices("api", user).size());
+
+    ds.SetSnapshot(ds.CreateSnapshot());
+    ds.ClearSnapshot();
+    db.execute("UPDATE devices SET device_name = 'cleared';");
+    EXPECT_EQ("cleared", ds.GetAPIDevices("other", user).at(0).second.m_name);
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+
+#include "WriterConnection.h"
+#include "../mocks/MockDeviceType.h"
+#include "api/SubActionImpls.h"
+#include "database/DBActionSerialize.h"
+#include "database/DBDeviceSerialize.h"
+#include "database/DBRuleSerialize.h"
+
+using namespace ::RuleConditions;
+
+// Records all statements executed by the serializers and checks their query plans
+class QueryPlanTest : public ::testing::Test
+{
+public:
+    QueryPlanTest()
+        : dbHandler(":memory:"),
+          db(GetWriterConnection(dbHandler)),
+          as(dbHandler),
+          rs(dbHandler, as),
+          ds(dbHandler, types),
+          metadata({{"on", MetadataEntry::Builder()
+                                .SetType(MetadataEntry::DataType::boolean)
+                                .SetSave(MetadataEntry::DBSave::save_log)
+                                .Create()},
+              {"brightness", MetadataEntry::Builder()
+                                 .SetType(MetadataEntry::DataType::integer)
+                                 .SetSave(MetadataEntry::DBSave::save_log)
+                                 .Create()}})
+    {
+        using namespace ::testing;
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+        Res::ConditionRegistry().RegisterDefaultConditions();
+        Res::ActionRegistry().RegisterDefaultSubActions();
+        auto type = std::make_unique<NiceMock<MockDeviceType>>();
+        deviceType = type.get();
+        ON_CALL(*deviceType, GetName()).WillByDefault(Return("type"));
+        ON_CALL(*deviceType, GetDeviceMetadata()).WillByDefault(ReturnRef(metadata));
+        types.AddDeviceType(std::move(type));
+
+        dbHandler.CreateTables(authenticator);
+        sqlite3_trace_v2(db.native_handle(), SQLITE_TRACE_STMT, &QueryPlanTest::Trace, this);
+    }
+    ~QueryPlanTest()
+    {
+        sqlite3_trace_v2(db.native_handle(), 0, nullptr, nullptr);
+        Res::ConditionRegistry().RemoveAll();
+        Res::ActionRegistry().RemoveAll();
+    }
+
+    // Returns the detail column of every row in the query plan
+    std::vector<std::string> GetQueryPlan(const std::string& sql)
+    {
+        sqlite3_stmt* statement = nullptr;
+        const std::string explain = "EXPLAIN QUERY PLAN " + sql;
+        if (sqlite3_prepare_v2(db.native_handle(), explain.c_str(), -1, &statement, nullptr) != SQLITE_OK)
+        {
+            ADD_FAILURE() << "Failed to explain: " << sql << ": " << sqlite3_errmsg(db.native_handle());
+            return {};
+        }
+        std::vector<std::string> details;
+        while (sqlite3_step(statement) == SQLITE_ROW)
+        {
+            details.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(statement, 3)));
+        }
+        sqlite3_finalize(statement);
+        return details;
+    }
+
+    // Fails for every recorded statement which scans a whole table or index.
+    // Listing all entries or searching names with LIKE '%...%' has to scan, so those are allowed
+    void ExpectNoFullScans()
+    {
+        sqlite3_trace_v2(db.native_handle(), 0, nullptr, nullptr);
+        std::set<std::string> recorded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            recorded.swap(statements);
+        }
+        ASSERT_FALSE(recorded.empty());
+        for (const std::string& sql : recorded)
+        {
+            const bool query = sql.compare(0, 6, "SELECT") == 0 || sql.compare(0, 6, "UPDATE") == 0
+                || sql.compare(0, 6, "DELETE") == 0;
+            const bool listing = sql.find(" WHERE ") == std::string::npos || sql.find(" LIKE") != std::string::npos;
+            if (!query || listing)
+            {
+                continue;
+            }
+            for (const std::string& detail : GetQueryPlan(sql))
+            {
+                EXPECT_EQ(std::string::npos, detail.find("SCAN")) << detail << " in: " << sql;
+            }
+        }
+    }
+
+    static int Trace(unsigned int, void* context, void*, void* sql)
+    {
+        QueryPlanTest* test = static_cast<QueryPlanTest*>(context);
+        // Writes are executed on the writer thread
+        std::lock_guard<std::mutex> lock(test->mutex);
+        test->statements.emplace(static_cast<const char*>(sql));
+        return 0;
+    }
+
+    Device::Data DeviceData(std::vector<std::string> groups, absl::flat_hash_map<std::string, nlohmann::json> values)
+    {
+        return Device::Data {
+            "name", "icon", std::move(groups), "type", Properties::FromRawData(std::move(values), *deviceType), "api"};
+    }
+
+    Authenticator authenticator;
+    DBHandler dbHandler;
+    DBHandler::DatabaseConnection& db;
+    DeviceTypeRegistry types;
+    DBActionSerialize as;
+    DBRuleSerialize rs;
+    DBDeviceSerialize ds;
+    Metadata metadata;
+    ::testing::NiceMock<MockDeviceType>* deviceType;
+    std::mutex mutex;
+    std::set<std::string> statements;
+    const UserId user = UserId::Dummy();
+};
+
+TEST_F(QueryPlanTest, DeviceSerialize)
+{
+    DeviceId id = ds.AddDevice(DeviceData({"a"}, {{"on", true}}), user);
+    ds.GetDeviceData(id, user);
+    ds.UpdateDevice(id, DeviceData({"b"}, {{"on", false}, {"brightness", 20}}), Events::DeviceFields::ALL, user);
+    ds.UpdateDevice(id, DeviceData({}, {{"on", false}}), Events::DeviceFields::ALL, user);
+    ds.GetAPIDeviceIds("api", user);
+    ds.GetAllDeviceIds(Filter("", 0, 10), user);
+    ds.GetAllDeviceIds(Filter("na", 0, 10), user);
+    ds.GetAllDeviceIds(Filter("", 0, 10, "b"), user);
+    ds.GetAPIDevices("api", user);
+    ds.GetAllDevices(Filter("", 0, 10), user);
+    ds.GetAllDevices(Filter("", 0, 10, "b"), user);
+
+    Properties properties = Properties::FromRawData({{"on", true}, {"brightness", 30}}, *deviceType);
+    ds.InsertDeviceProperty(id, "brightness", properties, user);
+    ds.SetDeviceProperty(id, "on", properties, user);
+    ds.LogDeviceProperty(id, "brightness", properties, user);
+    ds.SetDeviceProperties(id, {{"on", false, true}, {"brightness", false, false}}, properties, user);
+    const auto now = std::chrono::system_clock::now();
+    ds.GetPropertyHistory(id, "on", now - std::chrono::hours(1), absl::nullopt, 0, properties, user);
+    ds.GetPropertyHistory(id, "on", now - std::chrono::hours(1), now, 0, properties, user);
+    ds.RemoveDevice(id, user);
+
+    ExpectNoFullScans();
+}
+
+TEST_F(QueryPlanTest, ActionSerialize)
+{
+    ::Action action {0, "name", "icon", 0xFF, {SubAction(SubActionImpls::Notification(2))}, true};
+    action.SetId(as.AddAction(action, user));
+    as.GetAction(action.GetId(), user);
+    as.GetAllActions(Filter("", 0, 10), user);
+    as.GetAllActions(Filter("na", 0, 10), user);
+    as.AddAction(action, user);
+    as.AddActionOnly(action, user);
+    as.RemoveAction(action.GetId(), user);
+
+    ExpectNoFullScans();
+}
+
+TEST_F(QueryPlanTest, RuleSerialize)
+{
+    Rule rule {0, "name", "icon", 0xFF, std::make_unique<RuleConstantCondition>(0, true),
+        ::Action {0, "name", "icon", 0, {}, false}, true};
+    rs.AddRule(rule, user);
+    rs.GetRule(rule.GetId(), user);
+    rs.GetAllRules(Filter("", 0, 10), user);
+    rs.GetAllRules(Filter("na", 0, 10), user);
+    rs.UpdateRule(rule, user);
+    rs.AddRuleOnly(rule, user);
+    rs.RemoveRule(rule, user);
+
+    Rule other {0, "other", "icon", 0xFF, std::make_unique<RuleConstantCondition>(0, false),
+        ::Action {0, "other", "icon", 0, {}, false}, true};
+    rs.AddRule(other, user);
+    rs.RemoveRule(other.GetId(), user);
+
+    ExpectNoFullScans();
+}
+
+// Deleting a parent row looks up the referencing rows, which EXPLAIN QUERY PLAN does not show
+TEST_F(QueryPlanTest, ForeignKeys)
+{
+    std::vector<std::pair<std::string, std::string>> references;
+    for (const auto& table : {"actions", "sub_actions", "devices", "device_groups", "properties", "propertieslog",
+             "rule_conditions", "rules", "users"})
+    {
+        sqlite3_stmt* statement = nullptr;
+        const std::string sql = std::string("PRAGMA foreign_key_list(") + table + ");";
+        ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(db.native_handle(), sql.c_str(), -1, &statement, nullptr));
+        while (sqlite3_step(statement) == SQLITE_ROW)
+        {
+            // Column 3 is the referencing column
+            references.emplace_back(table, reinterpret_cast<const char*>(sqlite3_column_text(statement, 3)));
+        }
+        sqlite3_finalize(statement);
+    }
+    ASSERT_FALSE(references.empty());
+    for (const auto& reference : references)
+    {
+        const std::string sql = "SELECT 1 FROM " + reference.first + " WHERE " + reference.second + " = ?";
+        for (const std::string& detail : GetQueryPlan(sql))
+        {
+            EXPECT_EQ(std::string::npos, detail.find("SCAN")) << detail << " in: " << sql;
+        }
+    }
+}
\ No newline at end of file
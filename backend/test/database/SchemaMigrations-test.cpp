@@ -0,0 +1,132 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+#include <sqlpp11/insert.h>
+#include <sqlpp11/select.h>
+
+#include "WriterConnection.h"
+#include "api/Resources.h"
+#include "database/DBHandler.h"
+#include "database/DevicesTable.h"
+#include "database/SchemaMigrations.h"
+#include "utility/Logger.h"
+
+namespace
+{
+    constexpr DeviceGroupsTable deviceGroups;
+
+    Migration BackfillMigration()
+    {
+        return Migration {1, "Double values", {"ALTER TABLE values_log ADD COLUMN doubled INTEGER;"}, "values_log",
+            "UPDATE values_log SET doubled = value * 2 WHERE rowid >= ?1 AND rowid < ?2;"};
+    }
+} // namespace
+
+class SchemaMigrationsTest : public ::testing::Test
+{
+public:
+    SchemaMigrationsTest() : dbHandler(":memory:"), db(GetWriterConnection(dbHandler))
+    {
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+    }
+
+    // Returns the first column of the first row
+    int64_t QueryInt(const std::string& sql)
+    {
+        sqlite3_stmt* statement = nullptr;
+        EXPECT_EQ(SQLITE_OK, sqlite3_prepare_v2(db.native_handle(), sql.c_str(), -1, &statement, nullptr));
+        EXPECT_EQ(SQLITE_ROW, sqlite3_step(statement));
+        const int64_t result = sqlite3_column_int64(statement, 0);
+        sqlite3_finalize(statement);
+        return result;
+    }
+
+    void CreateDevice()
+    {
+        db.execute("INSERT INTO devices(device_id, device_name, device_icon, device_api, device_type) "
+                   "VALUES(1, 'name', 'icon', 'api', 'type');");
+    }
+
+    DBHandler dbHandler;
+    DBHandler::DatabaseConnection& db;
+};
+
+TEST_F(SchemaMigrationsTest, CreateTables)
+{
+    Authenticator authenticator;
+    dbHandler.CreateTables(authenticator);
+    EXPECT_EQ(SchemaMigrations(GetDatabaseMigrations()).GetLatestVersion(), SchemaMigrations::GetVersion(db));
+
+    // New databases allow multiple groups per device
+    CreateDevice();
+    db(insert_into(deviceGroups).set(deviceGroups.deviceId = 1, deviceGroups.groupName = "a"));
+    db(insert_into(deviceGroups).set(deviceGroups.deviceId = 1, deviceGroups.groupName = "b"));
+}
+
+TEST_F(SchemaMigrationsTest, DeviceGroups)
+{
+    // Schema before versioning, device_id was the primary key
+    db.execute(DevicesTable::createStatement);
+    db.execute("CREATE TABLE device_groups(device_id INTEGER PRIMARY KEY NOT NULL REFERENCES devices(device_id) ON "
+               "DELETE CASCADE, group_name VARCHAR NOT NULL, UNIQUE(device_id, group_name));");
+    CreateDevice();
+    db(insert_into(deviceGroups).set(deviceGroups.deviceId = 1, deviceGroups.groupName = "a"));
+    EXPECT_ANY_THROW(db(insert_into(deviceGroups).set(deviceGroups.deviceId = 1, deviceGroups.groupName = "b")));
+
+    SchemaMigrations migrations(GetDatabaseMigrations());
+    EXPECT_EQ(0, SchemaMigrations::GetVersion(db));
+    migrations.Migrate(db);
+    EXPECT_EQ(1, SchemaMigrations::GetVersion(db));
+    db(insert_into(deviceGroups).set(deviceGroups.deviceId = 1, deviceGroups.groupName = "b"));
+
+    std::vector<std::string> groups;
+    for (const auto& row : db(select(deviceGroups.groupName).from(deviceGroups).where(deviceGroups.deviceId == 1)))
+    {
+        groups.push_back(row.groupName);
+    }
+    EXPECT_EQ((std::vector<std::string> {"a", "b"}), groups);
+    // Migrating again does nothing
+    migrations.Migrate(db);
+    EXPECT_FALSE(migrations.RunBackfillChunk(db));
+}
+
+TEST_F(SchemaMigrationsTest, Backfill)
+{
+    db.execute("CREATE TABLE values_log(value INTEGER NOT NULL);");
+    for (int i = 0; i < 25; ++i)
+    {
+        db.execute("INSERT INTO values_log(value) VALUES(" + std::to_string(i) + ");");
+    }
+    std::vector<std::pair<int64_t, int64_t>> progress;
+    auto onProgress = [&](const Migration& migration, int64_t done, int64_t total) {
+        EXPECT_EQ(1, migration.m_version);
+        progress.emplace_back(done, total);
+    };
+    {
+        SchemaMigrations migrations({BackfillMigration()}, 10);
+        migrations.Migrate(db);
+        EXPECT_EQ(1, SchemaMigrations::GetVersion(db));
+        EXPECT_TRUE(migrations.RunBackfillChunk(db, onProgress));
+        EXPECT_EQ(15, QueryInt("SELECT COUNT(*) FROM values_log WHERE doubled IS NULL;"));
+    }
+    // Continues where the interrupted backfill stopped
+    SchemaMigrations migrations({BackfillMigration()}, 10);
+    migrations.Migrate(db);
+    while (migrations.RunBackfillChunk(db, onProgress))
+    {}
+    EXPECT_EQ((std::vector<std::pair<int64_t, int64_t>> {{10, 25}, {20, 25}, {25, 25}}), progress);
+    EXPECT_EQ(0, QueryInt("SELECT COUNT(*) FROM values_log WHERE doubled IS NULL OR doubled != value * 2;"));
+    EXPECT_EQ(0, QueryInt("SELECT COUNT(*) FROM schema_backfills;"));
+}
+
+TEST_F(SchemaMigrationsTest, NewerDatabase)
+{
+    db.execute("PRAGMA user_version = 5;");
+    EXPECT_THROW(SchemaMigrations(GetDatabaseMigrations()).Migrate(db), std::runtime_error);
+    EXPECT_THROW(SchemaMigrations({BackfillMigration(), BackfillMigration()}), std::invalid_argument);
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "database/DBHandler.h"
+
+// Returns the writing connection of dbHandler, so tests can prepare and check the database directly.
+// Only safe while no write is running, the tests wait for all of their writes
+inline DBHandler::DatabaseConnection& GetWriterConnection(DBHandler& dbHandler)
+{
+    return *dbHandler.Write([](DBHandler::DatabaseConnection& db) { return &db; }).get();
+}
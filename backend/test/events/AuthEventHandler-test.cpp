@@ -2,6 +2,7 @@
 #include <sqlpp11/insert.h>
 
 #include "../communication/TestWebsocketCommunication.h"
+#include "../database/WriterConnection.h"
 #include "database/DBHandler.h"
 #include "database/UsersTable.h"
 #include "events/AuthEventHandler.h"
@@ -16,7 +17,7 @@ public:
         const char* usersTable = "CREATE TABLE users(user_id INTEGER PRIMARY KEY NOT NULL, user_name VARCHAR NOT NULL, "
                                  "user_pwhash VARCHAR, user_priority INTEGER NOT NULL DEFAULT 0, last_login TIMESTAMP, "
                                  "login_attempts INTEGER DEFAULT 0, picture BLOB DEFAULT NULL);";
-        dbHandler.GetDatabase().execute(usersTable);
+        GetWriterConnection(dbHandler).execute(usersTable);
     }
 
     Authenticator authenticator;
@@ -46,7 +47,7 @@ TEST_F(AuthEventHandlerTest, ValidateLogin)
         EXPECT_EQ("", handler.ValidateLogin("user", "1616"));
     }
     UsersTable users;
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
 
     const std::string userName = "user13";
     const std::string password = "awg89j2oj6kwlejrasdf";
@@ -105,7 +106,7 @@ TEST_F(AuthEventHandlerTest, HandleLogin)
 
     const uint64_t userId = 0x4589312;
     UsersTable users;
-    auto& db = dbHandler.GetDatabase();
+    auto& db = GetWriterConnection(dbHandler);
     db(insert_into(users).set(users.userId = userId, users.userPwhash = authenticator.CreatePasswordHash(password),
         users.userName = userName));
 
@@ -0,0 +1,76 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../communication/TestWebsocketCommunication.h"
+#include "events/CommandRouter.h"
+
+namespace
+{
+    class TestOwner
+    {
+    public:
+        MOCK_METHOD2(First, PostEventState(const Events::SocketMessageEvent&, WebsocketChannel&));
+        MOCK_METHOD2(Second, PostEventState(const Events::SocketMessageEvent&, WebsocketChannel&));
+    };
+
+    Events::SocketMessageEvent MakeMessage(const nlohmann::json& payload)
+    {
+        return Events::SocketMessageEvent(websocketpp::connection_hdl(), nullptr, payload, absl::nullopt);
+    }
+} // namespace
+
+TEST(CommandRouter, Dispatch)
+{
+    using namespace ::testing;
+    Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+    Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+    TestWebsocketCommunication websocket;
+    WebsocketChannel channel(websocket.ws, "test", WebsocketChannel::RequireAuth::noAuth);
+    TestOwner owner;
+
+    CommandRouter<TestOwner> router("CommandRouterTest");
+    router.AddCommand("FIRST", &TestOwner::First);
+    router.AddCommand("SECOND", &TestOwner::Second);
+    EXPECT_THROW(router.AddCommand("FIRST", &TestOwner::Second), std::logic_error);
+
+    EXPECT_EQ(PostEventState::notHandled, router.Dispatch(owner, MakeMessage({{"no_command", "t"}}), channel));
+    EXPECT_EQ(PostEventState::notHandled, router.Dispatch(owner, MakeMessage({{"command", "THIRD"}}), channel));
+    EXPECT_EQ(PostEventState::notHandled, router.Dispatch(owner, MakeMessage({{"command", 1}}), channel));
+
+    EXPECT_CALL(owner, First(_, Ref(channel))).WillOnce(Return(PostEventState::handled));
+    EXPECT_EQ(PostEventState::handled, router.Dispatch(owner, MakeMessage({{"command", "FIRST"}}), channel));
+    Mock::VerifyAndClearExpectations(&owner);
+
+    // Errors and exceptions are counted
+    EXPECT_CALL(owner, Second(_, Ref(channel)))
+        .WillOnce(Return(PostEventState::error))
+        .WillOnce(Throw(std::runtime_error("test")))
+        .WillOnce(Return(PostEventState::handled));
+    const Events::SocketMessageEvent second = MakeMessage({{"command", "SECOND"}});
+    EXPECT_EQ(PostEventState::error, router.Dispatch(owner, second, channel));
+    EXPECT_EQ(PostEventState::error, router.Dispatch(owner, second, channel));
+    // Copies share statistics
+    CommandRouter<TestOwner> copy = router;
+    EXPECT_EQ(PostEventState::handled, copy.Dispatch(owner, second, channel));
+
+    const std::vector<CommandStats> stats = router.GetStats();
+    ASSERT_EQ(2, stats.size());
+    EXPECT_EQ("FIRST", stats[0].command);
+    EXPECT_EQ(1, stats[0].calls);
+    EXPECT_EQ(0, stats[0].errors);
+    EXPECT_EQ("SECOND", stats[1].command);
+    EXPECT_EQ(3, stats[1].calls);
+    EXPECT_EQ(2, stats[1].errors);
+    EXPECT_LE(stats[1].maxTime, stats[1].totalTime);
+
+    // Statistics are sent on request
+    EXPECT_CALL(websocket.GetServer(),
+        send(_, Truly([](const std::string& s) {
+            nlohmann::json stats = nlohmann::json::parse(s).at("commandStats");
+            return stats.size() == 2 && stats[1].at("command") == "SECOND" && stats[1].at("calls") == 3
+                && stats[1].at("errors") == 2;
+        }),
+            websocketpp::frame::opcode::text));
+    EXPECT_EQ(PostEventState::handled,
+        router.Dispatch(owner, MakeMessage({{"command", CommandRouter<TestOwner>::s_getCommandStats}}), channel));
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "../communication/TestWebsocketCommunication.h"
+#include "../mocks/MockDeviceSerialize.h"
+#include "../mocks/MockDeviceType.h"
+#include "api/Resources.h"
+#include "events/PropertyDeltaHandler.h"
+#include "utility/Logger.h"
+
+class PropertyDeltaHandlerTest : public ::testing::Test
+{
+public:
+    PropertyDeltaHandlerTest()
+        : storage(deviceSerialize, deviceEvents, propertyEvents),
+          channel(websocket.ws, "devices", WebsocketChannel::RequireAuth::noAuth),
+          handler(WebsocketChannelAccessor(websocket.ws, "devices"), storage, std::chrono::milliseconds(10))
+    {
+        using namespace ::testing;
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+        websocket.ws.AddChannel(WebsocketChannel(websocket.ws, "devices", WebsocketChannel::RequireAuth::noAuth));
+
+        Device::Data data {"device", "icon", {}, "type",
+            Properties::FromRawData({{"on", true}, {"brightness", 20}}, deviceType), "api"};
+        ON_CALL(deviceSerialize, GetDeviceData(deviceId, Matcher<UserId>(_))).WillByDefault(Return(data));
+    }
+
+    MockDeviceSerialize deviceSerialize;
+    MockDeviceType deviceType;
+    EventEmitter<Events::DeviceChangeEvent> deviceEvents;
+    EventEmitter<Events::DevicePropertyChangeEvent> propertyEvents;
+    DeviceStorage storage;
+    TestWebsocketCommunication websocket;
+    WebsocketChannel channel;
+    PropertyDeltaHandler handler;
+    const DeviceId deviceId {5};
+    const UserId user = UserId::Dummy();
+};
+
+TEST_F(PropertyDeltaHandlerTest, SubscribeSnapshot)
+{
+    using namespace ::testing;
+    auto connection = std::make_shared<MockWebsocketConnection>();
+
+    EXPECT_CALL(deviceSerialize, GetDeviceData(deviceId, Matcher<UserId>(_)));
+    EXPECT_CALL(websocket.GetServer(),
+        send(_, Truly([](const std::string& s) {
+            nlohmann::json snapshot = nlohmann::json::parse(s).at("snapshot");
+            return snapshot.size() == 1 && snapshot[0].at("id") == 5 && snapshot[0].at("key") == "brightness"
+                && snapshot[0].at("value") == 20;
+        }),
+            websocketpp::frame::opcode::text));
+    handler.Subscribe(connection, {deviceId}, {"brightness"}, false, user, channel);
+}
+
+TEST_F(PropertyDeltaHandlerTest, CoalesceChanges)
+{
+    using namespace ::testing;
+    auto connection = std::make_shared<MockWebsocketConnection>();
+    auto other = std::make_shared<MockWebsocketConnection>();
+
+    EXPECT_CALL(deviceSerialize, GetDeviceData(deviceId, Matcher<UserId>(_))).Times(AnyNumber());
+    EXPECT_CALL(websocket.GetServer(), send(_, _, websocketpp::frame::opcode::text)).Times(2);
+    handler.Subscribe(connection, {deviceId}, {"brightness"}, false, user, channel);
+    handler.Subscribe(other, {DeviceId(6)}, {}, false, user, channel);
+    Mock::VerifyAndClearExpectations(&websocket.GetServer());
+
+    Device device = storage.GetDevice(deviceId, user).value();
+    // Not subscribed to property
+    EXPECT_EQ(PostEventState::notHandled,
+        handler.HandlePropertyChange(Events::DevicePropertyChangeEvent(device, device, {"on"}, user)));
+    device.GetProperties() = Properties::FromRawData({{"on", true}, {"brightness", 30}}, deviceType);
+    EXPECT_EQ(PostEventState::handled,
+        handler.HandlePropertyChange(Events::DevicePropertyChangeEvent(device, device, {"brightness"}, user)));
+    device.GetProperties() = Properties::FromRawData({{"on", true}, {"brightness", 40}}, deviceType);
+    EXPECT_EQ(PostEventState::handled,
+        handler.HandlePropertyChange(Events::DevicePropertyChangeEvent(device, device, {"brightness"}, user)));
+
+    // Only the latest value is sent, only to the subscribed connection
+    EXPECT_CALL(websocket.GetServer(),
+        send(Truly([&](WebsocketChannel::connection_hdl h) { return h.lock() == connection; }),
+            Truly([](const std::string& s) {
+                nlohmann::json deltas = nlohmann::json::parse(s).at("deltas");
+                return deltas.size() == 1 && deltas[0].at("key") == "brightness" && deltas[0].at("value") == 40;
+            }),
+            websocketpp::frame::opcode::text));
+    handler.Flush();
+    Mock::VerifyAndClearExpectations(&websocket.GetServer());
+
+    // Nothing pending
+    EXPECT_CALL(websocket.GetServer(), send(_, _, _)).Times(0);
+    handler.Flush();
+    Mock::VerifyAndClearExpectations(&websocket.GetServer());
+
+    // No deltas after unsubscribe
+    handler.Unsubscribe(connection);
+    EXPECT_EQ(PostEventState::notHandled,
+        handler.HandlePropertyChange(Events::DevicePropertyChangeEvent(device, device, {"brightness"}, user)));
+    EXPECT_CALL(websocket.GetServer(), send(_, _, _)).Times(0);
+    handler.Flush();
+}
+
+TEST_F(PropertyDeltaHandlerTest, ChangeDuringSnapshot)
+{
+    using namespace ::testing;
+    auto connection = std::make_shared<MockWebsocketConnection>();
+
+    EXPECT_CALL(deviceSerialize, GetDeviceData(deviceId, Matcher<UserId>(_))).Times(AnyNumber());
+    Device device = storage.GetDevice(deviceId, user).value();
+    // Property changes while the snapshot is read
+    EXPECT_CALL(deviceSerialize, GetAllDevices(_, Matcher<UserId>(_)))
+        .WillOnce(InvokeWithoutArgs([&]() {
+            handler.HandlePropertyChange(Events::DevicePropertyChangeEvent(device, device, {"brightness"}, user));
+            return std::vector<std::pair<DeviceId, Device::Data>>();
+        }));
+    {
+        InSequence s;
+        EXPECT_CALL(websocket.GetServer(),
+            send(_, Truly([](const std::string& s) { return nlohmann::json::parse(s).count("snapshot"); }),
+                websocketpp::frame::opcode::text));
+        EXPECT_CALL(websocket.GetServer(),
+            send(_, Truly([](const std::string& s) {
+                nlohmann::json deltas = nlohmann::json::parse(s).at("deltas");
+                return deltas.size() == 1 && deltas[0].at("key") == "brightness";
+            }),
+                websocketpp::frame::opcode::text));
+    }
+    handler.Subscribe(connection, {}, {}, false, user, channel);
+    handler.Flush();
+}
\ No newline at end of file
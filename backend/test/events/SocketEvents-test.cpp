@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "../mocks/MockWebsocketServer.h"
+#include "communication/Authenticator.h"
+#include "events/SocketEvents.h"
+
+TEST(SocketMessageEvent, Parse)
+{
+    using namespace ::testing;
+    using Events::SocketMessageEvent;
+    Authenticator a;
+    {
+        // Not json
+        auto msg = std::make_shared<MockWebsocketMessage>();
+        std::string payload = "{not json";
+        EXPECT_CALL(*msg, get_payload()).WillRepeatedly(ReturnRef(payload));
+        SocketMessageEvent event = SocketMessageEvent::Parse(MockWebsocketServer::connection_hdl(), msg, &a);
+        EXPECT_EQ(payload, event.GetJsonPayload());
+        EXPECT_EQ("", event.GetChannel());
+        EXPECT_EQ("", event.GetCommand());
+        EXPECT_FALSE(event.GetUser().has_value());
+    }
+    {
+        // Not an object
+        nlohmann::json payload = {1, 2, "channel"};
+        auto msg = std::make_shared<MockWebsocketMessage>(payload);
+        SocketMessageEvent event = SocketMessageEvent::Parse(MockWebsocketServer::connection_hdl(), msg, &a);
+        EXPECT_EQ(payload, event.GetJsonPayload());
+        EXPECT_EQ("", event.GetChannel());
+        EXPECT_EQ("", event.GetCommand());
+    }
+    {
+        // Routing fields
+        nlohmann::json payload = {{"channel", "devices"}, {"command", "GET_DEVICES"}, {"idToken", 2}};
+        auto msg = std::make_shared<MockWebsocketMessage>(payload);
+        SocketMessageEvent event = SocketMessageEvent::Parse(MockWebsocketServer::connection_hdl(), msg, &a);
+        EXPECT_EQ(payload, event.GetJsonPayload());
+        EXPECT_EQ("devices", event.GetChannel());
+        EXPECT_EQ("GET_DEVICES", event.GetCommand());
+        EXPECT_FALSE(event.GetUser().has_value());
+    }
+    {
+        // User is only set with an authenticator
+        nlohmann::json payload = {{"command", 3}, {"idToken", a.CreateJWTToken({{"sub", "5"}})}};
+        auto msg = std::make_shared<MockWebsocketMessage>(payload);
+        SocketMessageEvent event = SocketMessageEvent::Parse(MockWebsocketServer::connection_hdl(), msg, nullptr);
+        EXPECT_EQ("", event.GetCommand());
+        EXPECT_FALSE(event.GetUser().has_value());
+        event = SocketMessageEvent::Parse(MockWebsocketServer::connection_hdl(), msg, &a);
+        EXPECT_EQ(5, event.GetUser().value().IActuallyReallyNeedTheIntegerNow());
+    }
+}
@@ -98,13 +98,28 @@ TEST(ArgumentParserDeathTest, ParseArguments)
         EXPECT_EQ(d.m_logLevel, a.m_logLevel);
     }
     {
-        const char* args[]
-            = {"test_exe", "-debug", "-dir", "testdir", "-logDir", "logdir", "-cLogL", "1", "-logL", "3"};
-        Arguments a = ParseArguments(10, args);
+        const char* args[] = {"test_exe", "-debug", "-dir", "testdir", "-logDir", "logdir", "-cLogL", "1", "-logL", "3",
+            "-logAsync", "200"};
+        Arguments a = ParseArguments(12, args);
         EXPECT_EQ(static_cast<Logger::LogLevel>(1), a.m_consoleLogLevel);
         EXPECT_EQ("testdir", a.m_directory);
         EXPECT_EQ("logdir", a.m_logDir);
         EXPECT_EQ(true, a.m_debug);
         EXPECT_EQ(static_cast<Logger::LogLevel>(3), a.m_logLevel);
+        EXPECT_EQ(200, a.m_logFlushInterval);
+    }
+    {
+        const char* args[] = {"test_exe", "-dbReaders", "2", "-dbSync", "FULL", "-dbCache", "-8000", "-dbMmap",
+            "268435456", "-snapshot", "300"};
+        Arguments a = ParseArguments(11, args);
+        EXPECT_EQ(2, a.m_dbReadConnections);
+        EXPECT_EQ("FULL", a.m_dbSynchronous);
+        EXPECT_EQ(-8000, a.m_dbCacheSize);
+        EXPECT_EQ(268435456, a.m_dbMmapSize);
+        EXPECT_EQ(300, a.m_snapshotInterval);
+        // Other args not changed
+        EXPECT_EQ(d.m_directory, a.m_directory);
+        EXPECT_EQ(d.m_debug, a.m_debug);
+        EXPECT_EQ(d.m_logLevel, a.m_logLevel);
     }
 }
\ No newline at end of file
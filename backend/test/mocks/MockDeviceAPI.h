@@ -0,0 +1,27 @@
+#pragma once
+
+#include <gmock/gmock.h>
+
+#include "api/DeviceAPI.h"
+
+class MockDeviceAPI : public IDeviceAPI
+{
+public:
+    explicit MockDeviceAPI(const char* apiId) : m_apiId(apiId) {}
+
+    MOCK_METHOD1(Initialize, void(nlohmann::json& config));
+    MOCK_METHOD1(Connect, void(nlohmann::json& config));
+    MOCK_METHOD0(Start, void());
+    MOCK_METHOD0(Shutdown, void());
+    MOCK_METHOD0(Cancel, void());
+    MOCK_METHOD1(RegisterEventHandlers, void(EventSystem& evSys));
+    MOCK_METHOD1(RegisterRuleConditions, void(RuleConditions::Registry& registry));
+    MOCK_METHOD1(RegisterSubActions, void(SubActionRegistry& registry));
+    MOCK_METHOD1(RegisterDeviceTypes, void(DeviceTypeRegistry& registry));
+    MOCK_METHOD1(SynchronizeDevices, void(DeviceStorage& storage));
+
+    const char* GetAPIId() const noexcept override { return m_apiId; }
+
+private:
+    const char* m_apiId;
+};
@@ -14,13 +14,22 @@ public:
     MOCK_METHOD2(AddDevice, DeviceId(const Device::Data& deviceData, UserId user));
     MOCK_METHOD2(AddDevice, DeviceId(const Device::Data& deviceData, const UserHeldTransaction&));
     // Updates an existing device
-    MOCK_METHOD3(UpdateDevice, void(DeviceId id, const Device::Data& data, UserId user));
-    MOCK_METHOD3(UpdateDevice, void(DeviceId id, const Device::Data& data, const UserHeldTransaction&));
+    MOCK_METHOD4(UpdateDevice, void(DeviceId id, const Device::Data& data, Events::DeviceFields fields, UserId user));
+    MOCK_METHOD4(UpdateDevice,
+        void(DeviceId id, const Device::Data& data, Events::DeviceFields fields, const UserHeldTransaction&));
 
     MOCK_CONST_METHOD2(GetAPIDeviceIds, std::vector<DeviceId>(absl::string_view apiId, UserId user));
     MOCK_CONST_METHOD2(GetAPIDeviceIds, std::vector<DeviceId>(absl::string_view apiId, const UserHeldTransaction&));
     MOCK_CONST_METHOD2(GetAllDeviceIds, std::vector<DeviceId>(const Filter& filter, UserId user));
     MOCK_CONST_METHOD2(GetAllDeviceIds, std::vector<DeviceId>(const Filter& filter, const UserHeldTransaction&));
+    MOCK_CONST_METHOD2(
+        GetAPIDevices, std::vector<std::pair<DeviceId, Device::Data>>(absl::string_view apiId, UserId user));
+    MOCK_CONST_METHOD2(GetAPIDevices,
+        std::vector<std::pair<DeviceId, Device::Data>>(absl::string_view apiId, const UserHeldTransaction&));
+    MOCK_CONST_METHOD2(
+        GetAllDevices, std::vector<std::pair<DeviceId, Device::Data>>(const Filter& filter, UserId user));
+    MOCK_CONST_METHOD2(GetAllDevices,
+        std::vector<std::pair<DeviceId, Device::Data>>(const Filter& filter, const UserHeldTransaction&));
     // Removes a device
     MOCK_METHOD2(RemoveDevice, void(DeviceId deviceId, UserId user));
     MOCK_METHOD2(RemoveDevice, void(DeviceId deviceId, const UserHeldTransaction&));
@@ -43,6 +52,12 @@ public:
         void(DeviceId deviceId, absl::string_view propertyKey, const Properties& properties,
             const UserHeldTransaction&));
 
+    MOCK_METHOD4(SetDeviceProperties,
+        void(DeviceId deviceId, const std::vector<PropertyWrite>& writes, const Properties& properties, UserId user));
+    MOCK_METHOD4(SetDeviceProperties,
+        void(DeviceId deviceId, const std::vector<PropertyWrite>& writes, const Properties& properties,
+            const UserHeldTransaction&));
+
     MOCK_METHOD7(GetPropertyHistory,
         nlohmann::json(DeviceId deviceId, absl::string_view propertyKey,
             const std::chrono::system_clock::time_point& start,
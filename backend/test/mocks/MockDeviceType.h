@@ -0,0 +1,15 @@
+#pragma once
+
+#include <gmock/gmock.h>
+
+#include "api/DeviceType.h"
+
+class MockDeviceType : public DeviceType
+{
+public:
+    MOCK_CONST_METHOD0(GetName, absl::string_view());
+    MOCK_CONST_METHOD0(GetDeviceMetadata, const Metadata&());
+    MOCK_CONST_METHOD3(ValidateUpdate, bool(absl::string_view property, const nlohmann::json& value, UserId user));
+    MOCK_CONST_METHOD3(OnUpdate, void(absl::string_view property, Device& device, UserId user));
+    MOCK_CONST_METHOD3(OnUpdates, void(const std::vector<std::string>& properties, Device& device, UserId user));
+};
@@ -0,0 +1,276 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <LinHttpHandler.h>
+#include <arpa/inet.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../mocks/MockDeviceSerialize.h"
+#include "../mocks/MockDeviceType.h"
+#include "api/Resources.h"
+#include "plugins/hue-api/HueSync.h"
+#include "utility/Logger.h"
+
+// Minimal http server on localhost which answers every request with the current lights
+class FakeHueBridge
+{
+public:
+    FakeHueBridge()
+    {
+        m_socket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &length);
+        m_port = ntohs(address.sin_port);
+        listen(m_socket, 4);
+        m_thread = std::thread(&FakeHueBridge::Run, this);
+    }
+    ~FakeHueBridge()
+    {
+        m_running = false;
+        // Unblocks accept
+        shutdown(m_socket, SHUT_RDWR);
+        m_thread.join();
+        close(m_socket);
+    }
+
+    int GetPort() const { return m_port; }
+    void SetLights(const nlohmann::json& lights)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lights = lights.dump();
+    }
+    std::vector<std::string> GetRequests()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requests;
+    }
+
+private:
+    void Run()
+    {
+        while (m_running)
+        {
+            int client = accept(m_socket, nullptr, nullptr);
+            if (client < 0)
+            {
+                continue;
+            }
+            std::string request;
+            char buffer[1024];
+            while (request.find("\r\n\r\n") == std::string::npos)
+            {
+                ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+                if (received <= 0)
+                {
+                    break;
+                }
+                request.append(buffer, received);
+            }
+            std::string response;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_requests.push_back(request.substr(0, request.find("\r\n")));
+                response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+                    + std::to_string(m_lights.size()) + "\r\nConnection: close\r\n\r\n" + m_lights;
+            }
+            send(client, response.data(), response.size(), 0);
+            close(client);
+        }
+    }
+
+private:
+    int m_socket;
+    int m_port;
+    std::atomic<bool> m_running {true};
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::string m_lights = "{}";
+    std::vector<std::string> m_requests;
+};
+
+class HueSyncTest : public ::testing::Test
+{
+public:
+    HueSyncTest()
+        : storage(deviceSerialize, deviceEvents, propertyEvents),
+          metadata({{"lightId", MetadataEntry::Builder()
+                                    .SetType(MetadataEntry::DataType::integer)
+                                    .SetSave(MetadataEntry::DBSave::save)
+                                    .Create()},
+              {"on", MetadataEntry::Builder()
+                         .SetType(MetadataEntry::DataType::boolean)
+                         .SetSave(MetadataEntry::DBSave::save_log)
+                         .Create()},
+              {"brightness", MetadataEntry::Builder()
+                                 .SetType(MetadataEntry::DataType::integer)
+                                 .SetSave(MetadataEntry::DBSave::save_log)
+                                 .SetOptional(true)
+                                 .Create()},
+              {"colorTemperature", MetadataEntry::Builder()
+                                       .SetType(MetadataEntry::DataType::integer)
+                                       .SetSave(MetadataEntry::DBSave::save_log)
+                                       .SetOptional(true)
+                                       .Create()}})
+    {
+        using namespace ::testing;
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+        ON_CALL(deviceType, GetDeviceMetadata()).WillByDefault(ReturnRef(metadata));
+        ON_CALL(deviceType, ValidateUpdate(_, _, _)).WillByDefault(Return(true));
+    }
+
+    Device::Data LightData(int lightId, bool on, int brightness)
+    {
+        return Device::Data {"light", "icon", {}, "hueLight",
+            Properties::FromRawData({{"lightId", lightId}, {"on", on}, {"brightness", brightness}}, deviceType),
+            "HUEAPI_0.0"};
+    }
+
+    ::testing::NiceMock<MockDeviceSerialize> deviceSerialize;
+    ::testing::NiceMock<MockDeviceType> deviceType;
+    EventEmitter<Events::DeviceChangeEvent> deviceEvents;
+    EventEmitter<Events::DevicePropertyChangeEvent> propertyEvents;
+    DeviceStorage storage;
+    Metadata metadata;
+    const UserId apiUser = UserId::Dummy(1);
+};
+
+TEST_F(HueSyncTest, DiffLight)
+{
+    Device device("light", "icon", {}, "hueLight",
+        Properties::FromRawData({{"lightId", 1}, {"on", false}, {"brightness", 100}}, deviceType), "HUEAPI_0.0");
+
+    // Unchanged brightness and missing hue are not updated
+    PropertyUpdate update
+        = HueSync::DiffLight({{"state", {{"on", true}, {"bri", 100}, {"ct", 300}}}, {"name", "light"}}, device);
+    ASSERT_EQ(2u, update.GetSize());
+    EXPECT_EQ("on", update.GetValues()[0].first);
+    EXPECT_EQ(true, update.GetValues()[0].second);
+    EXPECT_EQ("colorTemperature", update.GetValues()[1].first);
+    EXPECT_EQ(300, update.GetValues()[1].second);
+
+    EXPECT_TRUE(HueSync::DiffLight({{"state", {{"on", false}, {"bri", 100}}}}, device).IsEmpty());
+    EXPECT_TRUE(HueSync::DiffLight({{"name", "light"}}, device).IsEmpty());
+}
+
+TEST_F(HueSyncTest, NextInterval)
+{
+    EXPECT_EQ(HueSync::s_minInterval, HueSync::NextInterval(HueSync::s_maxInterval, true));
+    EXPECT_EQ(HueSync::s_minInterval * 2, HueSync::NextInterval(HueSync::s_minInterval, false));
+    EXPECT_EQ(HueSync::s_maxInterval, HueSync::NextInterval(HueSync::s_maxInterval, false));
+}
+
+TEST_F(HueSyncTest, Synchronize)
+{
+    using namespace ::testing;
+    FakeHueBridge bridge;
+    HueSync sync(std::make_shared<LinHttpHandler>(), "127.0.0.1", bridge.GetPort(), "user", storage, "HUEAPI_0.0",
+        apiUser);
+
+    ON_CALL(deviceSerialize, GetAPIDevices(absl::string_view("HUEAPI_0.0"), Matcher<UserId>(_)))
+        .WillByDefault(Return(std::vector<std::pair<DeviceId, Device::Data>> {
+            {DeviceId(1), LightData(1, false, 10)}, {DeviceId(2), LightData(2, true, 254)}}));
+
+    bridge.SetLights({{"1", {{"state", {{"on", true}, {"bri", 10}}}}}, {"2", {{"state", {{"on", true}, {"bri", 254}}}}},
+        {"3", {{"state", {{"on", false}}}}}});
+    // Only the changed property of light 1 is written, in one batch
+    EXPECT_CALL(deviceSerialize,
+        SetDeviceProperties(DeviceId(1), Truly([](const std::vector<PropertyWrite>& writes) {
+            return writes.size() == 1 && writes[0].key == "on";
+        }),
+            _, Matcher<UserId>(apiUser)));
+    EXPECT_CALL(deviceSerialize, SetDeviceProperties(DeviceId(2), _, _, Matcher<UserId>(_))).Times(0);
+    EXPECT_EQ(1u, sync.Synchronize());
+    Mock::VerifyAndClearExpectations(&deviceSerialize);
+
+    // The devices are held, so the same state has no changes and the storage is not queried
+    EXPECT_CALL(deviceSerialize, GetAPIDevices(_, Matcher<UserId>(_))).Times(0);
+    EXPECT_CALL(deviceSerialize, SetDeviceProperties(_, _, _, Matcher<UserId>(_))).Times(0);
+    EXPECT_EQ(0u, sync.Synchronize());
+    Mock::VerifyAndClearExpectations(&deviceSerialize);
+
+    // All lights are fetched with a single request per synchronization
+    EXPECT_THAT(bridge.GetRequests(), ElementsAre(HasSubstr("/api/user/lights"), HasSubstr("/api/user/lights")));
+}
+
+TEST_F(HueSyncTest, SynchronizeSkipsInvalid)
+{
+    using namespace ::testing;
+    FakeHueBridge bridge;
+    HueSync sync(std::make_shared<LinHttpHandler>(), "127.0.0.1", bridge.GetPort(), "user", storage, "HUEAPI_0.0",
+        apiUser);
+
+    ON_CALL(deviceSerialize, GetAPIDevices(absl::string_view("HUEAPI_0.0"), Matcher<UserId>(_)))
+        .WillByDefault(Return(std::vector<std::pair<DeviceId, Device::Data>> {
+            {DeviceId(1), LightData(1, false, 10)}, {DeviceId(2), LightData(2, false, 254)}}));
+
+    // Hue is not in the metadata: light 1 has no valid change, light 2 still gets its new state
+    bridge.SetLights({{"1", {{"state", {{"on", false}, {"bri", 10}, {"hue", 100}}}}},
+        {"2", {{"state", {{"on", true}, {"bri", 254}, {"hue", 100}}}}}});
+    EXPECT_CALL(deviceSerialize, SetDeviceProperties(DeviceId(1), _, _, Matcher<UserId>(_))).Times(0);
+    EXPECT_CALL(deviceSerialize,
+        SetDeviceProperties(DeviceId(2), Truly([](const std::vector<PropertyWrite>& writes) {
+            return writes.size() == 1 && writes[0].key == "on";
+        }),
+            _, Matcher<UserId>(apiUser)));
+    EXPECT_EQ(1u, sync.Synchronize());
+}
+
+TEST_F(HueSyncTest, ReloadOnDeviceChange)
+{
+    using namespace ::testing;
+    FakeHueBridge bridge;
+    HueSync sync(std::make_shared<LinHttpHandler>(), "127.0.0.1", bridge.GetPort(), "user", storage, "HUEAPI_0.0",
+        apiUser);
+    bridge.SetLights(
+        {{"1", {{"state", {{"on", true}, {"bri", 10}}}}}, {"2", {{"state", {{"on", true}, {"bri", 20}}}}}});
+
+    EXPECT_CALL(deviceSerialize, GetAPIDevices(absl::string_view("HUEAPI_0.0"), Matcher<UserId>(_)))
+        .WillOnce(Return(std::vector<std::pair<DeviceId, Device::Data>> {{DeviceId(1), LightData(1, true, 10)}}));
+    EXPECT_EQ(0u, sync.Synchronize());
+    EXPECT_EQ(0u, sync.Synchronize());
+    Mock::VerifyAndClearExpectations(&deviceSerialize);
+
+    // A new light is only compared after the devices are reloaded
+    sync.OnDeviceChange(Events::DeviceChangeEvent(Device(), Device(), Events::DeviceFields::ADD, apiUser));
+    EXPECT_CALL(deviceSerialize, GetAPIDevices(absl::string_view("HUEAPI_0.0"), Matcher<UserId>(_)))
+        .WillOnce(Return(std::vector<std::pair<DeviceId, Device::Data>> {
+            {DeviceId(1), LightData(1, true, 10)}, {DeviceId(2), LightData(2, false, 20)}}));
+    EXPECT_CALL(deviceSerialize, SetDeviceProperties(DeviceId(2), _, _, Matcher<UserId>(apiUser)));
+    EXPECT_EQ(1u, sync.Synchronize());
+    Mock::VerifyAndClearExpectations(&deviceSerialize);
+}
+
+TEST_F(HueSyncTest, SynchronizeError)
+{
+    FakeHueBridge bridge;
+    HueSync sync(std::make_shared<LinHttpHandler>(), "127.0.0.1", bridge.GetPort(), "user", storage, "HUEAPI_0.0",
+        apiUser);
+    // Error responses of the bridge are arrays
+    bridge.SetLights(nlohmann::json::array(
+        {{{"error", {{"type", 1}, {"address", "/lights"}, {"description", "unauthorized user"}}}}}));
+    EXPECT_THROW(sync.Synchronize(), std::runtime_error);
+}
+
+TEST_F(HueSyncTest, StartStop)
+{
+    FakeHueBridge bridge;
+    HueSync sync(std::make_shared<LinHttpHandler>(), "127.0.0.1", bridge.GetPort(), "user", storage, "HUEAPI_0.0",
+        apiUser);
+    sync.Start();
+    // Stopping does not wait for the poll interval
+    sync.Stop();
+    EXPECT_TRUE(bridge.GetRequests().empty());
+}
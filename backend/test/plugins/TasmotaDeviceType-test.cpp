@@ -0,0 +1,105 @@
+#include <string>
+
+#include <gtest/gtest.h>
+#include <mosquitto.h>
+
+#include "api/Resources.h"
+#include "plugins/tasmota-api/TasmotaDeviceType.h"
+#include "utility/Logger.h"
+
+class TasmotaDeviceTypeTest : public ::testing::Test
+{
+public:
+    TasmotaDeviceTypeTest()
+    {
+        Res::Logger().SetConsoleLevel(Logger::LEVEL_NONE);
+        Res::Logger().SetFileLevel(Logger::LEVEL_NONE);
+    }
+
+    Device CreateDevice(const std::string& name, absl::flat_hash_map<std::string, nlohmann::json> properties)
+    {
+        return Device(name, "icon", {}, "tasmota", Properties::FromRawData(std::move(properties), type), "api");
+    }
+
+    // Returns topic and payload of the command, or empty strings if there is none
+    std::pair<std::string, std::string> BuildCommand(const Device& device, absl::string_view property)
+    {
+        std::string topic;
+        std::string payload;
+        if (!type.BuildCommand(property, device, topic, payload))
+        {
+            return {};
+        }
+        return {topic, payload};
+    }
+
+    struct MosquittoLib
+    {
+        MosquittoLib() { mosquitto_lib_init(); }
+        ~MosquittoLib() { mosquitto_lib_cleanup(); }
+    } lib;
+    // Not connected, only needed to construct the type
+    MQTTClient client {"127.0.0.1", 1};
+    TasmotaDeviceType type {client, UserId::Dummy()};
+};
+
+TEST_F(TasmotaDeviceTypeTest, ValueCommands)
+{
+    using Command = std::pair<std::string, std::string>;
+    Device device = CreateDevice("lamp",
+        {{"POWER2", true}, {"POWER3", false}, {"Dimmer", 50}, {"Color", "FF0000"}, {"CT", 153}, {"HSBColorHue", 120},
+            {"HSBColorSaturation", 30}, {"HSBColorBrightness", 80}, {"Speed", 12.5}, {"ShutterPosition3", 40},
+            {"online", true}});
+    EXPECT_EQ(Command("cmnd/lamp/POWER2", "ON"), BuildCommand(device, "POWER2"));
+    EXPECT_EQ(Command("cmnd/lamp/POWER3", "OFF"), BuildCommand(device, "POWER3"));
+    EXPECT_EQ(Command("cmnd/lamp/Dimmer", "50"), BuildCommand(device, "Dimmer"));
+    EXPECT_EQ(Command("cmnd/lamp/Color", "FF0000"), BuildCommand(device, "Color"));
+    EXPECT_EQ(Command("cmnd/lamp/CT", "153"), BuildCommand(device, "CT"));
+    EXPECT_EQ(Command("cmnd/lamp/HsbColor1", "120"), BuildCommand(device, "HSBColorHue"));
+    EXPECT_EQ(Command("cmnd/lamp/HsbColor2", "30"), BuildCommand(device, "HSBColorSaturation"));
+    EXPECT_EQ(Command("cmnd/lamp/HsbColor3", "80"), BuildCommand(device, "HSBColorBrightness"));
+    // Floats are sent in their shortest form
+    EXPECT_EQ(Command("cmnd/lamp/Speed", "12.5"), BuildCommand(device, "Speed"));
+    EXPECT_EQ(Command("cmnd/lamp/ShutterPosition3", "40"), BuildCommand(device, "ShutterPosition3"));
+    // No command for sensor values
+    EXPECT_EQ(Command(), BuildCommand(device, "online"));
+}
+
+TEST_F(TasmotaDeviceTypeTest, ShutterCommands)
+{
+    using Command = std::pair<std::string, std::string>;
+    Device device = CreateDevice("shutter",
+        {{"ShutterClose1", false}, {"ShutterClose3", true}, {"ShutterOpen2", true}, {"ShutterOpen4", false}});
+    EXPECT_EQ(Command("cmnd/shutter/ShutterClose3", ""), BuildCommand(device, "ShutterClose3"));
+    EXPECT_EQ(Command("cmnd/shutter/ShutterStop1", ""), BuildCommand(device, "ShutterClose1"));
+    EXPECT_EQ(Command("cmnd/shutter/ShutterOpen2", ""), BuildCommand(device, "ShutterOpen2"));
+    // Stop command keeps the shutter index
+    EXPECT_EQ(Command("cmnd/shutter/ShutterStop4", ""), BuildCommand(device, "ShutterOpen4"));
+}
+
+TEST_F(TasmotaDeviceTypeTest, Rename)
+{
+    Device device = CreateDevice("old", {{"POWER1", true}});
+    EXPECT_EQ("cmnd/old/POWER1", BuildCommand(device, "POWER1").first);
+    // Commands go to the current name, like after a restart
+    device.SetName("new");
+    EXPECT_EQ("cmnd/new/POWER1", BuildCommand(device, "POWER1").first);
+}
+
+TEST_F(TasmotaDeviceTypeTest, ValidateUpdate)
+{
+    const UserId user = UserId::Dummy();
+    EXPECT_TRUE(type.ValidateUpdate("Dimmer", 0, user));
+    EXPECT_TRUE(type.ValidateUpdate("Dimmer", 100, user));
+    EXPECT_FALSE(type.ValidateUpdate("Dimmer", 101, user));
+    EXPECT_FALSE(type.ValidateUpdate("White", 0, user));
+    EXPECT_FALSE(type.ValidateUpdate("CT", 152, user));
+    EXPECT_TRUE(type.ValidateUpdate("CT", 500, user));
+    EXPECT_FALSE(type.ValidateUpdate("HSBColorHue", 361, user));
+    EXPECT_FALSE(type.ValidateUpdate("Scheme", 13, user));
+    EXPECT_FALSE(type.ValidateUpdate("Speed", 0, user));
+    EXPECT_FALSE(type.ValidateUpdate("ShutterPosition2", -1, user));
+    // Properties without range
+    EXPECT_TRUE(type.ValidateUpdate("POWER1", true, user));
+    EXPECT_TRUE(type.ValidateUpdate("online", true, user));
+}
@@ -1,6 +1,9 @@
+#include <chrono>
 #include <iostream>
 #include <regex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -412,4 +415,130 @@ TEST(Logger, GetLevel)
     EXPECT_EQ(Logger::LEVEL_DEBUG, l.GetLevel());
     l.SetConsoleLevel(Logger::LEVEL_NONE);
     EXPECT_EQ(Logger::LEVEL_DEBUG, l.GetLevel());
+}
+
+TEST(Logger, Async)
+{
+    std::stringstream sstream;
+    std::streambuf* b = std::cout.rdbuf(sstream.rdbuf());
+
+    Logger l;
+    try
+    {
+        l.SetFileLevel(Logger::LEVEL_NONE);
+        l.SetConsoleLevel(Logger::LEVEL_INFO);
+        Logger::AsyncConfig config;
+        config.m_flushInterval = std::chrono::hours(1);
+        config.m_flushLevel = Logger::LEVEL_NONE;
+        l.StartAsync(config);
+        l.Info("first");
+        l.Debug("not enabled");
+        l.Info("Tag", "second");
+        l.StopAsync();
+        {
+            const std::string s = sstream.str();
+            sstream.str("");
+            std::regex r {R"(.*\[ INFO  \]first\n.*\[ INFO  \]\[Tag\] second\n.*)"};
+            EXPECT_TRUE(std::regex_match(s, r)) << "s is " << std::quoted(s);
+        }
+        // Written right away after StopAsync
+        l.Info("sync");
+        EXPECT_NE(std::string::npos, sstream.str().find("sync"));
+    }
+    catch (...)
+    {
+        std::cout.rdbuf(b);
+        std::cout.clear();
+        throw;
+    }
+    std::cout.rdbuf(b);
+    std::cout.clear();
+}
+
+TEST(Logger, AsyncOverflow)
+{
+    std::stringstream sstream;
+    std::streambuf* b = std::cout.rdbuf(sstream.rdbuf());
+
+    Logger l;
+    try
+    {
+        l.SetFileLevel(Logger::LEVEL_NONE);
+        l.SetConsoleLevel(Logger::LEVEL_INFO);
+        Logger::AsyncConfig config;
+        config.m_capacity = 4;
+        config.m_flushInterval = std::chrono::hours(1);
+        config.m_flushLevel = Logger::LEVEL_NONE;
+        l.StartAsync(config);
+        for (int i = 0; i < 6; ++i)
+        {
+            l.Info("message " + std::to_string(i));
+        }
+        EXPECT_EQ(2, l.GetDroppedCount());
+        l.StopAsync();
+        const std::string s = sstream.str();
+        EXPECT_NE(std::string::npos, s.find("message 3"));
+        EXPECT_EQ(std::string::npos, s.find("message 4"));
+        EXPECT_NE(std::string::npos, s.find("Dropped 2 log messages"));
+    }
+    catch (...)
+    {
+        std::cout.rdbuf(b);
+        std::cout.clear();
+        throw;
+    }
+    std::cout.rdbuf(b);
+    std::cout.clear();
+}
+
+TEST(Logger, AsyncStopWhileLogging)
+{
+    std::stringstream sstream;
+    std::streambuf* b = std::cout.rdbuf(sstream.rdbuf());
+
+    Logger l;
+    try
+    {
+        l.SetFileLevel(Logger::LEVEL_NONE);
+        l.SetConsoleLevel(Logger::LEVEL_INFO);
+        constexpr int threadCount = 4;
+        constexpr int messageCount = 500;
+        Logger::AsyncConfig config;
+        config.m_capacity = threadCount * messageCount;
+        config.m_flushInterval = std::chrono::hours(1);
+        config.m_flushLevel = Logger::LEVEL_NONE;
+        l.StartAsync(config);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < messageCount; ++i)
+                {
+                    l.Info("message");
+                }
+            });
+        }
+        l.StopAsync();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        // Messages queued while stopping are not left in the queue
+        const std::string s = sstream.str();
+        int written = 0;
+        for (std::size_t pos = s.find("message"); pos != std::string::npos; pos = s.find("message", pos + 1))
+        {
+            ++written;
+        }
+        EXPECT_EQ(threadCount * messageCount, written);
+        EXPECT_EQ(0, l.GetDroppedCount());
+    }
+    catch (...)
+    {
+        std::cout.rdbuf(b);
+        std::cout.clear();
+        throw;
+    }
+    std::cout.rdbuf(b);
+    std::cout.clear();
 }
\ No newline at end of file
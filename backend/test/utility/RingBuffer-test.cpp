@@ -0,0 +1,76 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utility/RingBuffer.h"
+
+TEST(RingBuffer, Capacity)
+{
+    EXPECT_EQ(1, RingBuffer<int>(0).GetCapacity());
+    EXPECT_EQ(4, RingBuffer<int>(3).GetCapacity());
+    EXPECT_EQ(8, RingBuffer<int>(8).GetCapacity());
+}
+
+TEST(RingBuffer, PushPop)
+{
+    RingBuffer<std::string> buffer(4);
+    std::string value;
+    EXPECT_FALSE(buffer.TryPop(value));
+    // Wraps around multiple times
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(buffer.TryPush(std::to_string(i)));
+        }
+        std::string rejected = "full";
+        EXPECT_FALSE(buffer.TryPush(std::move(rejected)));
+        EXPECT_EQ("full", rejected);
+        for (int i = 0; i < 4; ++i)
+        {
+            ASSERT_TRUE(buffer.TryPop(value));
+            EXPECT_EQ(std::to_string(i), value);
+        }
+        EXPECT_FALSE(buffer.TryPop(value));
+    }
+}
+
+TEST(RingBuffer, MultipleProducers)
+{
+    constexpr int producerCount = 4;
+    constexpr int valueCount = 10000;
+    RingBuffer<int> buffer(64);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p)
+    {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < valueCount; ++i)
+            {
+                while (!buffer.TryPush(p * valueCount + i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    // Values of each producer arrive in order
+    std::vector<int> next(producerCount, 0);
+    int received = 0;
+    while (received < producerCount * valueCount)
+    {
+        int value;
+        if (buffer.TryPop(value))
+        {
+            const int p = value / valueCount;
+            ASSERT_EQ(next[p], value % valueCount);
+            ++next[p];
+            ++received;
+        }
+    }
+    for (std::thread& t : producers)
+    {
+        t.join();
+    }
+}
\ No newline at end of file
@@ -19,6 +19,8 @@ public:
     Active& operator=(Active&& other) = delete;
 
     void Send(Message m);
+    // Returns whether the caller runs on the thread of this Active
+    bool IsActiveThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
 
 private:
     // Called by thread
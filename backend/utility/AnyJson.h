@@ -88,4 +88,19 @@ inline google::protobuf::Any JsonToAny(const nlohmann::json& json)
 		throw std::logic_error("JsonToAny: unsupported type");
 	}
 	return result;
-}
\ No newline at end of file
+}
+
+// Like JsonToAny, but objects and arrays are packed as StringValue containing their dump.
+// json must not be null
+inline google::protobuf::Any JsonToAnyOrDump(const nlohmann::json& json)
+{
+	if (json.is_structured())
+	{
+		google::protobuf::Any result;
+		google::protobuf::StringValue v;
+		v.set_value(json.dump());
+		result.PackFrom(v);
+		return result;
+	}
+	return JsonToAny(json);
+}
@@ -2,12 +2,11 @@
 
 #include <chrono>
 #include <ctime>
-#include <iomanip> // std::setw
 #include <iostream>
 #include <memory>
-#include <sstream> // std::stringstream
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 #include <absl/strings/str_cat.h>
 
@@ -33,8 +32,14 @@ void Logger::Open(const std::string& dirname, LogLevel fileLevel, LogLevel conso
     OpenCurrentFile(dirname, true);
 }
 
+Logger::~Logger()
+{
+    StopAsync();
+}
+
 void Logger::Close()
 {
+    StopAsync();
     std::lock_guard<std::mutex> lock(m_mutex);
     // Block all outputs
     m_consoleLevel = LEVEL_NONE;
@@ -44,82 +49,223 @@ void Logger::Close()
     m_csvFile.close();
 }
 
+void Logger::StartAsync(const AsyncConfig& config)
+{
+    StopAsync();
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    m_asyncConfig = config;
+    m_flushLevel = config.m_flushLevel;
+    if (!m_queue)
+    {
+        m_queue = std::make_unique<RingBuffer<Entry>>(config.m_capacity);
+    }
+    m_asyncRunning = true;
+    m_asyncThread = std::thread([this] { RunAsync(); });
+    m_async = true;
+}
+
+void Logger::StopAsync()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        if (!m_asyncRunning)
+        {
+            return;
+        }
+        m_async = false;
+        m_asyncRunning = false;
+    }
+    m_asyncCv.notify_all();
+    // Thread writes the remaining messages before it exits
+    m_asyncThread.join();
+    // Threads which still saw m_async set may push after the last write of the thread. Every thread that can see it
+    // set is counted, so once the count is zero all of their messages are queued
+    while (m_producers.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+    WriteQueued();
+}
+
 void Logger::Log(const std::string& tag, const std::string& message, LogLevel level)
 {
-    size_t tag_size = tag.size();
-    if (tag_size > tag_padding)
+    if (!IsEnabled(level))
     {
-        tag_padding = tag_size;
+        return;
     }
-    std::stringstream ss;
-    ss << "[" << std::left << std::setw(tag_padding) << tag << "] " << message;
-    Log(ss.str(), level);
+    size_t padding = tag.size();
+    SuggestTagPadding(padding);
+    padding = tag_padding.load(std::memory_order_relaxed);
+    std::string paddedMessage;
+    paddedMessage.reserve(padding + message.size() + 3);
+    paddedMessage += '[';
+    paddedMessage += tag;
+    paddedMessage.append(padding - tag.size(), ' ');
+    paddedMessage += "] ";
+    paddedMessage += message;
+    Log(paddedMessage, level);
 }
 
 void Logger::Log(const std::string& message, LogLevel level)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (level < m_consoleLevel && level < m_fileLevel)
+    if (!IsEnabled(level))
     {
         return;
     }
     time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    // Counted before m_async is checked, so StopAsync either sees this thread or this thread sees m_async cleared
+    m_producers.fetch_add(1);
+    if (m_async.load())
+    {
+        if (!m_queue->TryPush(Entry {level, now, message}))
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (level >= m_flushLevel.load(std::memory_order_relaxed))
+        {
+            {
+                // Set under the mutex, so the wakeup cannot be lost between the check and the wait
+                std::lock_guard<std::mutex> lock(m_asyncMutex);
+                m_flushPending = true;
+            }
+            m_asyncCv.notify_one();
+        }
+        m_producers.fetch_sub(1);
+        return;
+    }
+    m_producers.fetch_sub(1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Write(level, now, message);
+    Flush();
+}
+
+void Logger::Write(LogLevel level, time_t now, const std::string& message)
+{
+    const LogLevel consoleLevel = m_consoleLevel.load(std::memory_order_relaxed);
+    const LogLevel fileLevel = m_fileLevel.load(std::memory_order_relaxed);
     tm* time = localtime(&now);
     std::string levelStr;
     // Check if a new file needs to be opened
-    if (time->tm_mday != m_mday && m_fileLevel != LogLevel::LEVEL_NONE)
+    if (time->tm_mday != m_mday && fileLevel != LogLevel::LEVEL_NONE)
     {
         OpenCurrentFile(m_dirname);
     }
+    if (level >= consoleLevel)
+    {
+        switch (level)
+        {
+        case LEVEL_DEBUG:
+            console::SetColor(console::color::FG_DARK_GREY);
+            break;
+        case LEVEL_WARNING:
+            console::SetColor(console::color::FG_MAGENTA);
+            break;
+        case LEVEL_ERROR:
+        case LEVEL_SEVERE:
+            console::SetColor(console::color::FG_RED);
+            break;
+        default:
+            break;
+        }
+    }
     switch (level)
     {
     case LEVEL_DEBUG:
-        console::SetColor(console::color::FG_DARK_GREY);
         levelStr = "[ DEBUG ]";
         break;
     case LEVEL_INFO:
         levelStr = "[ INFO  ]";
         break;
     case LEVEL_WARNING:
-        console::SetColor(console::color::FG_MAGENTA);
         levelStr = "[WARNING]";
         break;
     case LEVEL_ERROR:
-        console::SetColor(console::color::FG_RED);
         levelStr = "[ ERROR ]";
         break;
     case LEVEL_SEVERE:
-        console::SetColor(console::color::FG_RED);
         levelStr = "[SEVERE ]";
         break;
     case LEVEL_NONE:
         levelStr = "[ NONE  ]";
         break;
     }
-    std::string formattedMessage = absl::StrCat(GetTimeStringFromTime(time), levelStr, message,"\n");
+    std::string formattedMessage = absl::StrCat(GetTimeStringFromTime(time), levelStr, message, "\n");
 
-    if (level >= m_consoleLevel)
+    if (level >= consoleLevel)
     {
         std::cout << formattedMessage;
         console::SetColor(console::color::RESET);
-        std::cout << std::flush;
     }
-    if (level >= m_fileLevel)
+    if (level >= fileLevel)
     {
         if (m_file.is_open())
         {
-            m_file << formattedMessage << std::flush;
+            m_file << formattedMessage;
         }
         if (m_csvFile.is_open())
         {
-            std::string csvMessage;
             // CSV format: Level(int);Time(int);Message\n
-            csvMessage = absl::StrCat(level, ";",  now, ";", message , "\n");
-            m_csvFile << csvMessage << std::flush;
+            m_csvFile << absl::StrCat(level, ";", now, ";", message, "\n");
         }
     }
 }
 
+void Logger::Flush()
+{
+    std::cout << std::flush;
+    if (m_file.is_open())
+    {
+        m_file.flush();
+    }
+    if (m_csvFile.is_open())
+    {
+        m_csvFile.flush();
+    }
+}
+
+void Logger::RunAsync()
+{
+    std::unique_lock<std::mutex> lock(m_asyncMutex);
+    while (m_asyncRunning)
+    {
+        m_asyncCv.wait_for(lock, m_asyncConfig.m_flushInterval, [this] { return m_flushPending || !m_asyncRunning; });
+        m_flushPending = false;
+        lock.unlock();
+        WriteQueued();
+        lock.lock();
+    }
+    lock.unlock();
+    WriteQueued();
+}
+
+void Logger::WriteQueued()
+{
+    std::vector<Entry> batch;
+    Entry entry;
+    while (m_queue->TryPop(entry))
+    {
+        batch.push_back(std::move(entry));
+    }
+    const uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (batch.empty() && dropped == m_reportedDropped)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Entry& e : batch)
+    {
+        Write(e.m_level, e.m_time, e.m_message);
+    }
+    if (dropped != m_reportedDropped)
+    {
+        time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        Write(LEVEL_WARNING, now,
+            absl::StrCat("[Logger] Dropped ", dropped - m_reportedDropped, " log messages, the buffer was full"));
+        m_reportedDropped = dropped;
+    }
+    Flush();
+}
+
 void Logger::OpenCurrentFile(const std::string& dirname, bool blocking)
 {
     const auto updateFileFn = [&, dirname]() {
@@ -1,9 +1,18 @@
 #ifndef _LOGGER_H
 #define _LOGGER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
+
+#include "RingBuffer.h"
 
 /*!
  * \brief A basic static Logger class with configurable log levels.
@@ -13,6 +22,9 @@
  *
  * The Logger should be thread-save.
  *
+ * By default messages are written and flushed by the calling thread. In async mode (see StartAsync()) messages are
+ * put into a lock-free ring buffer and written in batches by a background thread.
+ *
  * The .csv file contains the same content as the normal log file, but does not format it to be read.
  * Instead, it contains these colums: \n
  * \c level (int value);\c time (as returned by \c time());\c message
@@ -51,7 +63,33 @@ public:
         LEVEL_NONE
     };
 
+    /*!
+     * \brief Configuration of the async mode.
+     */
+    struct AsyncConfig
+    {
+        /*!
+         * \brief Maximum number of queued messages, rounded up to a power of two.
+         *
+         * Messages are dropped and counted when the buffer is full.
+         */
+        std::size_t m_capacity = 8192;
+        /*!
+         * \brief Time between batched writes, outputs are flushed after each batch.
+         */
+        std::chrono::milliseconds m_flushInterval {500};
+        /*!
+         * \brief Messages of at least this LogLevel are written immediately.
+         */
+        LogLevel m_flushLevel = LEVEL_ERROR;
+    };
+
 public:
+    /*!
+     * \brief Stops async mode.
+     */
+    ~Logger();
+
     /*!
      * \brief Opens the Logger.
      * \param dirname The path of the log directory.
@@ -61,27 +99,47 @@ public:
      */
     void Open(const std::string& dirname, LogLevel fileLevel, LogLevel consoleLevel = LEVEL_NONE);
     /*!
-     * \brief Closes the Logger and the file.
+     * \brief Closes the Logger and the file, stops async mode.
      */
     void Close();
 
+    /*!
+     * \brief Starts writing messages from a background thread.
+     * \param config The AsyncConfig. The capacity of the first call is kept when called again.
+     *
+     * Queued messages are written when StopAsync() or Close() is called.
+     */
+    void StartAsync(const AsyncConfig& config);
+    /*!
+     * \brief Writes all queued messages and stops the background thread.
+     */
+    void StopAsync();
+    /*!
+     * \brief Returns the number of messages dropped because the buffer was full.
+     */
+    inline uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
     /*!
      * \brief Sets the LogLevel for file output.
      * \param level The LogLevel for the file. LogLevel::LEVEL_NONE disables file output.
      */
-    inline void SetFileLevel(LogLevel level)
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_fileLevel = level;
-    }
+    inline void SetFileLevel(LogLevel level) { m_fileLevel.store(level, std::memory_order_relaxed); }
     /*!
      * \brief Sets the LogLevel for console output.
      * \param level The LogLevel for the console. LogLevel::LEVEL_NONE disables console output.
      */
-    inline void SetConsoleLevel(LogLevel level)
+    inline void SetConsoleLevel(LogLevel level) { m_consoleLevel.store(level, std::memory_order_relaxed); }
+    /*!
+     * \brief Checks whether messages of a LogLevel are written.
+     * \param level The LogLevel to check.
+     * \returns Whether console or file output is enabled for \c level.
+     *
+     * Use it to skip building expensive messages.
+     */
+    inline bool IsEnabled(LogLevel level) const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_consoleLevel = level;
+        return level >= m_consoleLevel.load(std::memory_order_relaxed)
+            || level >= m_fileLevel.load(std::memory_order_relaxed);
     }
 
     /*!
@@ -185,8 +243,9 @@ public:
      */
     inline LogLevel GetLevel()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_fileLevel < m_consoleLevel ? m_fileLevel : m_consoleLevel;
+        const LogLevel fileLevel = m_fileLevel.load(std::memory_order_relaxed);
+        const LogLevel consoleLevel = m_consoleLevel.load(std::memory_order_relaxed);
+        return fileLevel < consoleLevel ? fileLevel : consoleLevel;
     }
     /*!
      * \brief Suggest a padding width for tag logs
@@ -194,9 +253,9 @@ public:
      */
     void SuggestTagPadding(size_t suggestion)
     {
-        if (suggestion > tag_padding)
+        size_t padding = tag_padding.load(std::memory_order_relaxed);
+        while (suggestion > padding && !tag_padding.compare_exchange_weak(padding, suggestion))
         {
-            tag_padding = suggestion;
         }
     }
 
@@ -220,6 +279,38 @@ private:
      */
     void Log(const std::string& tag, const std::string& message, LogLevel level);
 
+    /*!
+     * \brief A message queued in async mode.
+     */
+    struct Entry
+    {
+        LogLevel m_level = LEVEL_NONE;
+        time_t m_time = 0;
+        std::string m_message;
+    };
+
+    /*!
+     * \brief Formats and writes a message without flushing, m_mutex must be locked.
+     * \param level The LogLevel of the message.
+     * \param now The time the message was logged at.
+     * \param message The message to output.
+     */
+    void Write(LogLevel level, time_t now, const std::string& message);
+    /*!
+     * \brief Flushes console and files, m_mutex must be locked.
+     */
+    void Flush();
+    /*!
+     * \brief Runs on the background thread in async mode.
+     */
+    void RunAsync();
+    /*!
+     * \brief Writes all queued messages in one batch and reports dropped messages.
+     *
+     * Must only be called from one thread at a time.
+     */
+    void WriteQueued();
+
     /*!
      * \brief Opens the current log file.
      * \param dirname The name of the log directory.
@@ -261,11 +352,11 @@ private:
     /*!
      * \brief The LogLevel for file output.
      */
-    LogLevel m_fileLevel;
+    std::atomic<LogLevel> m_fileLevel {LEVEL_NONE};
     /*!
      * \brief The LogLevel for console output.
      */
-    LogLevel m_consoleLevel;
+    std::atomic<LogLevel> m_consoleLevel {LEVEL_NONE};
     /*!
      * \brief Is locked to prevent splitting of messages.
      */
@@ -273,6 +364,54 @@ private:
     /*!
      * \brief Variable to hold the total padding of tag log
      */
-    size_t tag_padding;
+    std::atomic<size_t> tag_padding {0};
+    /*!
+     * \brief Whether messages are queued for the background thread.
+     */
+    std::atomic<bool> m_async {false};
+    /*!
+     * \brief Number of threads in Log() which may still queue a message, StopAsync() waits for them.
+     */
+    std::atomic<int> m_producers {0};
+    /*!
+     * \brief Queued messages, created on the first call of StartAsync() and kept until destruction.
+     */
+    std::unique_ptr<RingBuffer<Entry>> m_queue;
+    /*!
+     * \brief The AsyncConfig, guarded by m_asyncMutex.
+     */
+    AsyncConfig m_asyncConfig;
+    /*!
+     * \brief Copy of AsyncConfig::m_flushLevel for the logging threads.
+     */
+    std::atomic<LogLevel> m_flushLevel {LEVEL_NONE};
+    /*!
+     * \brief Guards stopping and waking of the background thread.
+     */
+    std::mutex m_asyncMutex;
+    /*!
+     * \brief Wakes the background thread for urgent messages or when stopping.
+     */
+    std::condition_variable m_asyncCv;
+    /*!
+     * \brief Whether the background thread should keep running, guarded by m_asyncMutex.
+     */
+    bool m_asyncRunning = false;
+    /*!
+     * \brief Whether an urgent message waits to be written, guarded by m_asyncMutex.
+     */
+    bool m_flushPending = false;
+    /*!
+     * \brief The background thread.
+     */
+    std::thread m_asyncThread;
+    /*!
+     * \brief Number of messages dropped because the buffer was full.
+     */
+    std::atomic<uint64_t> m_dropped {0};
+    /*!
+     * \brief Number of dropped messages which were already reported, only accessed by the writing thread.
+     */
+    uint64_t m_reportedDropped = 0;
 };
 #endif
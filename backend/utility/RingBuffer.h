@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free queue for multiple producers and one consumer.
+// Each slot has a sequence number which tells whether it is free for the producer or filled for the consumer
+template <typename T>
+class RingBuffer
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit RingBuffer(std::size_t capacity) : m_capacity(RoundCapacity(capacity)), m_slots(new Slot[m_capacity])
+    {
+        for (std::size_t i = 0; i < m_capacity; ++i)
+        {
+            m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    std::size_t GetCapacity() const { return m_capacity; }
+
+    // Can be called from any thread. Returns false without moving value if the buffer is full
+    bool TryPush(T&& value)
+    {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = m_slots[pos & (m_capacity - 1)];
+            const std::size_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+            if (sequence == pos)
+            {
+                // Slot is free, try to claim it
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.m_value = std::move(value);
+                    slot.m_sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < pos)
+            {
+                // Slot still holds the value of the previous round
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Must only be called from one thread at a time. Returns false if the buffer is empty
+    bool TryPop(T& value)
+    {
+        Slot& slot = m_slots[m_head & (m_capacity - 1)];
+        if (slot.m_sequence.load(std::memory_order_acquire) != m_head + 1)
+        {
+            return false;
+        }
+        value = std::move(slot.m_value);
+        // Free slot for the next round
+        slot.m_sequence.store(m_head + m_capacity, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> m_sequence;
+        T m_value;
+    };
+
+    static std::size_t RoundCapacity(std::size_t capacity)
+    {
+        std::size_t result = 1;
+        while (result < capacity)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+private:
+    const std::size_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<std::size_t> m_tail {0};
+    // Only accessed by the consumer
+    std::size_t m_head = 0;
+};
\ No newline at end of file
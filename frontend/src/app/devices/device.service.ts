@@ -1,6 +1,6 @@
 import {Inject, Injectable, OnDestroy} from '@angular/core';
 import {from, Observable, of, Subject} from 'rxjs';
-import {filter, map, scan, take} from 'rxjs/operators';
+import {filter, map, mergeMap, scan, take} from 'rxjs/operators';
 import {WebSocketSubject} from 'rxjs/webSocket';
 
 import {WebsocketChannelService} from '../websocket/websocket-channel.service';
@@ -35,6 +35,14 @@ export class DeviceService implements OnDestroy {
     return undefined;
   }
 
+  private messageToDevices(message: any): Device[] {
+    if (message && message.devices) {
+      return message.devices.map((device: any) => this.messageToDevice({device: device}));
+    }
+    const device = this.messageToDevice(message);
+    return device !== undefined ? [device] : [];
+  }
+
   private messageToMeta(message: any): DeviceMeta|undefined {
     if (message && message.meta) {
       const meta = message.meta;
@@ -80,10 +88,9 @@ export class DeviceService implements OnDestroy {
   getDevices(): Observable<Device> {
     this.initSubject();
     this.subject.next({command: 'GET_DEVICES'});
+    // Devices arrive in chunks of {devices: [...]}, pushed changes as {device: ...}
     return this.subject.pipe(
-        map((message: any) => this.messageToDevice(message)),
-        // filter(device => device != null));
-        filter(device => device !== undefined));
+        mergeMap((message: any) => from(this.messageToDevices(message))));
   }
 
   getDevicesAsArray(): Observable<Device[]> {